@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+//Conta as alocacoes feitas pelo operator new global (std::vector, std::string, new...).
+//Memoria de arenas e de malloc direto (stb_image) nao passa por aqui
+size_t getHeapAllocationCount();
@@ -0,0 +1,82 @@
+#include "Arena.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+Arena::Arena(size_t reserveSize)
+{
+#ifdef _WIN32
+	base = (char*)VirtualAlloc(nullptr, reserveSize, MEM_RESERVE, PAGE_NOACCESS);
+#else
+	void* address = mmap(nullptr, reserveSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	base = address == MAP_FAILED ? nullptr : (char*)address;
+#endif
+
+	if (!base)
+	{
+		cout << "Failed to reserve arena of " << (reserveSize >> 20) << " MB" << endl;
+		return;
+	}
+
+	reserved = reserveSize;
+}
+
+Arena::~Arena()
+{
+	if (!base)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	VirtualFree(base, 0, MEM_RELEASE);
+#else
+	munmap(base, reserved);
+#endif
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+	size_t start = (used + alignment - 1) & ~(alignment - 1);
+	size_t end = start + size;
+
+	if (end > reserved)
+	{
+		cout << "Arena out of memory (" << (reserved >> 20) << " MB reserved)" << endl;
+		return nullptr;
+	}
+
+	if (end > committed)
+	{
+		size_t newCommitted = (end + COMMIT_GRANULARITY - 1) & ~(COMMIT_GRANULARITY - 1);
+		if (newCommitted > reserved)
+		{
+			newCommitted = reserved;
+		}
+
+#ifdef _WIN32
+		bool ok = VirtualAlloc(base + committed, newCommitted - committed, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+		bool ok = mprotect(base + committed, newCommitted - committed, PROT_READ | PROT_WRITE) == 0;
+#endif
+		if (!ok)
+		{
+			cout << "Failed to commit arena memory" << endl;
+			return nullptr;
+		}
+
+		committed = newCommitted;
+	}
+
+	used = end;
+	return base + start;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+//Alocador linear: reserva um intervalo contiguo de enderecos e confirma paginas
+//conforme cresce. Os ponteiros nunca mudam, entao um arena usado para um unico tipo
+//forma um array contiguo; a memoria e liberada toda de uma vez (reset ou destrutor)
+class Arena
+{
+public:
+	static const size_t DEFAULT_RESERVE = sizeof(void*) == 8 ? ((size_t)1 << 32) : ((size_t)64 << 20);
+
+	Arena(size_t reserveSize = DEFAULT_RESERVE);
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	//Retorna nullptr se a reserva se esgotar
+	void* allocate(size_t size, size_t alignment = 16);
+	template <class T>
+	T* push(size_t count = 1) { return (T*)allocate(sizeof(T) * count, alignof(T)); }
+
+	char* getBase() { return base; }
+	size_t getUsed() { return used; }
+	size_t getCommitted() { return committed; }
+	//Mantem as paginas confirmadas para o proximo uso
+	void reset() { used = 0; }
+	//Temporarios com escopo: guarda a posicao e volta para ela quando nao forem mais usados
+	size_t getMarker() { return used; }
+	void rewind(size_t marker) { used = marker; }
+
+protected:
+	static const size_t COMMIT_GRANULARITY = 64 << 10;
+
+	char* base = nullptr;
+	size_t reserved = 0, committed = 0, used = 0;
+};
@@ -0,0 +1,105 @@
+#include "AtlasPacker.h"
+
+AtlasPacker::AtlasPacker(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+
+	Segment segment = { 0, 0, width };
+	skyline.push_back(segment);
+}
+
+int AtlasPacker::fit(int index, int width, int height)
+{
+	int x = skyline[index].x;
+	if (x + width > this->width)
+	{
+		return -1;
+	}
+
+	//O retangulo apoia no segmento mais alto entre os que ele cobre
+	int y = 0;
+	int remaining = width;
+	for (int i = index; remaining > 0; i++)
+	{
+		if (skyline[i].y > y)
+		{
+			y = skyline[i].y;
+		}
+		remaining -= skyline[i].width;
+	}
+
+	return y + height <= this->height ? y : -1;
+}
+
+bool AtlasPacker::insert(int width, int height, int& x, int& y)
+{
+	int best = -1, bestY = 0, bestWidth = 0;
+
+	for (int i = 0; i < skyline.size(); i++)
+	{
+		int candidateY = fit(i, width, height);
+
+		//Menor altura final; empate decidido pelo segmento mais estreito
+		if (candidateY >= 0 && (best < 0 || candidateY + height < bestY + height ||
+			(candidateY == bestY && skyline[i].width < bestWidth)))
+		{
+			best = i;
+			bestY = candidateY;
+			bestWidth = skyline[i].width;
+		}
+	}
+
+	if (best < 0)
+	{
+		return false;
+	}
+
+	x = skyline[best].x;
+	y = bestY;
+
+	Segment segment = { x, y + height, width };
+	skyline.insert(skyline.begin() + best, segment);
+
+	//Remove ou encurta os segmentos que ficaram embaixo do novo
+	for (int i = best + 1; i < skyline.size(); i++)
+	{
+		int covered = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+		if (covered <= 0)
+		{
+			break;
+		}
+
+		skyline[i].x += covered;
+		skyline[i].width -= covered;
+
+		if (skyline[i].width <= 0)
+		{
+			skyline.erase(skyline.begin() + i);
+			i--;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	//Junta vizinhos de mesma altura
+	for (int i = 0; i + 1 < skyline.size(); i++)
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+			i--;
+		}
+	}
+
+	usedArea += (long long)width * height;
+	return true;
+}
+
+float AtlasPacker::getOccupancy()
+{
+	return (float)usedArea / ((float)width * height);
+}
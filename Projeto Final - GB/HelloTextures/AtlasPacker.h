@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+//Empacotamento de retangulos em uma pagina pelo metodo skyline (bottom-left):
+//a pagina guarda apenas o contorno superior dos retangulos ja colocados
+class AtlasPacker
+{
+public:
+	AtlasPacker(int width, int height);
+	//Retorna false se o retangulo nao cabe mais na pagina
+	bool insert(int width, int height, int& x, int& y);
+	//Fracao da pagina ocupada
+	float getOccupancy();
+
+protected:
+	struct Segment
+	{
+		int x, y, width;
+	};
+
+	//Altura em que um retangulo comecando no segmento index ficaria, ou -1 se nao cabe
+	int fit(int index, int width, int height);
+
+	int width, height;
+	long long usedArea = 0;
+	vector<Segment> skyline;
+};
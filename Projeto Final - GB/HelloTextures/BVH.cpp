@@ -0,0 +1,344 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//Distancia minima de um acerto, para o raio nao atingir a superficie de onde saiu
+static const float MIN_DISTANCE = 1e-5f;
+
+void RayPacket::set(const glm::vec3* origins, const glm::vec3* directions, const float* maxDistances)
+{
+	float values[9][4];
+	for (int lane = 0; lane < 4; lane++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			//Componente zero vira um valor minimo: 0 * infinito daria NaN no teste das caixas
+			float direction = directions[lane][c];
+			if (fabs(direction) < 1e-20f)
+			{
+				direction = direction < 0.0f ? -1e-20f : 1e-20f;
+			}
+			values[c][lane] = origins[lane][c];
+			values[3 + c][lane] = direction;
+			values[6 + c][lane] = 1.0f / direction;
+		}
+	}
+	originX = _mm_loadu_ps(values[0]);
+	originY = _mm_loadu_ps(values[1]);
+	originZ = _mm_loadu_ps(values[2]);
+	directionX = _mm_loadu_ps(values[3]);
+	directionY = _mm_loadu_ps(values[4]);
+	directionZ = _mm_loadu_ps(values[5]);
+	inverseX = _mm_loadu_ps(values[6]);
+	inverseY = _mm_loadu_ps(values[7]);
+	inverseZ = _mm_loadu_ps(values[8]);
+	tMax = _mm_loadu_ps(maxDistances);
+	u = v = _mm_setzero_ps();
+	triangle = _mm_set1_epi32(-1);
+}
+
+//Metade da area da superficie da caixa
+static float halfArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	glm::vec3 extent = boundsMax - boundsMin;
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+void BVH::build(const vector<glm::vec3>& vertices)
+{
+	int nbTriangles = vertices.size() / 3;
+	vector<BuildItem> items(nbTriangles);
+	triangleIndices.resize(nbTriangles);
+	for (int i = 0; i < nbTriangles; i++)
+	{
+		const glm::vec3* v = &vertices[i * 3];
+		items[i].boundsMin = glm::min(v[0], glm::min(v[1], v[2]));
+		items[i].boundsMax = glm::max(v[0], glm::max(v[1], v[2]));
+		items[i].centroid = (items[i].boundsMin + items[i].boundsMax) * 0.5f;
+		triangleIndices[i] = i;
+	}
+
+	//Uma arvore binaria com folhas nao vazias tem no maximo 2n - 1 nos
+	nodes.clear();
+	triangles.clear();
+	if (nbTriangles == 0)
+	{
+		return;
+	}
+	nodes.reserve(nbTriangles * 2);
+	Node root;
+	root.leftFirst = 0;
+	root.count = nbTriangles;
+	nodes.push_back(root);
+	updateBounds(0, items);
+	subdivide(0, 0, items);
+
+	triangles.resize(nbTriangles);
+	for (int i = 0; i < nbTriangles; i++)
+	{
+		const glm::vec3* v = &vertices[triangleIndices[i] * 3];
+		triangles[i].v0 = v[0];
+		triangles[i].edge1 = v[1] - v[0];
+		triangles[i].edge2 = v[2] - v[0];
+	}
+}
+
+void BVH::updateBounds(int node, const vector<BuildItem>& items)
+{
+	Node& n = nodes[node];
+	n.boundsMin = glm::vec3(FLT_MAX);
+	n.boundsMax = glm::vec3(-FLT_MAX);
+	for (int i = n.leftFirst; i < n.leftFirst + n.count; i++)
+	{
+		const BuildItem& item = items[triangleIndices[i]];
+		n.boundsMin = glm::min(n.boundsMin, item.boundsMin);
+		n.boundsMax = glm::max(n.boundsMax, item.boundsMax);
+	}
+}
+
+void BVH::subdivide(int node, int depth, const vector<BuildItem>& items)
+{
+	int first = nodes[node].leftFirst, count = nodes[node].count;
+	if (count <= 2 || depth >= MAX_DEPTH)
+	{
+		return;
+	}
+
+	glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+	for (int i = first; i < first + count; i++)
+	{
+		centroidMin = glm::min(centroidMin, items[triangleIndices[i]].centroid);
+		centroidMax = glm::max(centroidMax, items[triangleIndices[i]].centroid);
+	}
+
+	//Custo de cada plano entre intervalos: area * triangulos de cada lado
+	float bestCost = FLT_MAX;
+	int bestAxis = -1, bestPlane = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		glm::vec3 binMin[NB_BINS], binMax[NB_BINS];
+		int binCount[NB_BINS] = {};
+		fill(binMin, binMin + NB_BINS, glm::vec3(FLT_MAX));
+		fill(binMax, binMax + NB_BINS, glm::vec3(-FLT_MAX));
+		float scale = NB_BINS / extent;
+		for (int i = first; i < first + count; i++)
+		{
+			const BuildItem& item = items[triangleIndices[i]];
+			int bin = min(NB_BINS - 1, (int)((item.centroid[axis] - centroidMin[axis]) * scale));
+			binCount[bin]++;
+			binMin[bin] = glm::min(binMin[bin], item.boundsMin);
+			binMax[bin] = glm::max(binMax[bin], item.boundsMax);
+		}
+
+		float leftArea[NB_BINS - 1], rightArea[NB_BINS - 1];
+		int leftCount[NB_BINS - 1], rightCount[NB_BINS - 1];
+		glm::vec3 leftMin(FLT_MAX), leftMax(-FLT_MAX), rightMin(FLT_MAX), rightMax(-FLT_MAX);
+		int leftSum = 0, rightSum = 0;
+		for (int i = 0; i < NB_BINS - 1; i++)
+		{
+			leftSum += binCount[i];
+			leftCount[i] = leftSum;
+			leftMin = glm::min(leftMin, binMin[i]);
+			leftMax = glm::max(leftMax, binMax[i]);
+			leftArea[i] = leftSum ? halfArea(leftMin, leftMax) : 0.0f;
+
+			int j = NB_BINS - 1 - i;
+			rightSum += binCount[j];
+			rightCount[j - 1] = rightSum;
+			rightMin = glm::min(rightMin, binMin[j]);
+			rightMax = glm::max(rightMax, binMax[j]);
+			rightArea[j - 1] = rightSum ? halfArea(rightMin, rightMax) : 0.0f;
+		}
+
+		for (int i = 0; i < NB_BINS - 1; i++)
+		{
+			float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+			if (leftCount[i] > 0 && rightCount[i] > 0 && cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestPlane = i;
+			}
+		}
+	}
+
+	//Folha quando nao ha divisao ou quando ela custa mais que testar todos os triangulos
+	//(custo de visitar um no igual ao de um triangulo)
+	float area = halfArea(nodes[node].boundsMin, nodes[node].boundsMax);
+	if (bestAxis < 0 || (count <= MAX_LEAF_TRIANGLES && area + bestCost >= count * area))
+	{
+		return;
+	}
+
+	float scale = NB_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	int* middle = partition(&triangleIndices[first], &triangleIndices[first] + count, [&](int triangle) {
+		return min(NB_BINS - 1, (int)((items[triangle].centroid[bestAxis] - centroidMin[bestAxis]) * scale)) <= bestPlane;
+	});
+	int leftCount = middle - &triangleIndices[first];
+
+	int left = nodes.size();
+	Node child;
+	child.leftFirst = first;
+	child.count = leftCount;
+	nodes.push_back(child);
+	child.leftFirst = first + leftCount;
+	child.count = count - leftCount;
+	nodes.push_back(child);
+	nodes[node].leftFirst = left;
+	nodes[node].count = 0;
+
+	updateBounds(left, items);
+	updateBounds(left + 1, items);
+	subdivide(left, depth + 1, items);
+	subdivide(left + 1, depth + 1, items);
+}
+
+//Mascara SSE das lanes de uma mascara de 4 bits
+static inline __m128 laneMask(int active)
+{
+	const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(active), bits), bits));
+}
+
+//Teste das fatias: lanes cuja entrada na caixa vem antes da saida, de tMax e depois da origem
+static inline int intersectBox(const RayPacket& packet, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.x), packet.originX), packet.inverseX);
+	__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.x), packet.originX), packet.inverseX);
+	__m128 tNear = _mm_min_ps(t1, t2), tFar = _mm_max_ps(t1, t2);
+	t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.y), packet.originY), packet.inverseY);
+	t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.y), packet.originY), packet.inverseY);
+	tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+	tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+	t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.z), packet.originZ), packet.inverseZ);
+	t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.z), packet.originZ), packet.inverseZ);
+	tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+	tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+
+	__m128 hit = _mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_cmpge_ps(tFar, _mm_setzero_ps()));
+	return _mm_movemask_ps(_mm_and_ps(hit, _mm_cmplt_ps(tNear, packet.tMax)));
+}
+
+template<bool anyHit>
+int BVH::traverse(RayPacket& packet, int active) const
+{
+	if (nodes.empty() || !active)
+	{
+		return 0;
+	}
+
+	//Direcao do primeiro raio ativo, so para a ordem dos filhos
+	float directions[3][4];
+	_mm_storeu_ps(directions[0], packet.directionX);
+	_mm_storeu_ps(directions[1], packet.directionY);
+	_mm_storeu_ps(directions[2], packet.directionZ);
+	int lead = 0;
+	while (!(active & 1 << lead))
+	{
+		lead++;
+	}
+	glm::vec3 leadDirection(directions[0][lead], directions[1][lead], directions[2][lead]);
+
+	int hits = 0;
+	int stack[MAX_DEPTH * 2];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const Node& node = nodes[stack[--top]];
+		if (!(intersectBox(packet, node.boundsMin, node.boundsMax) & active))
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			const Node& left = nodes[node.leftFirst];
+			const Node& right = nodes[node.leftFirst + 1];
+			glm::vec3 leftToRight = (right.boundsMin + right.boundsMax) - (left.boundsMin + left.boundsMax);
+			bool leftFirst = glm::dot(leftToRight, leadDirection) > 0.0f;
+			stack[top++] = node.leftFirst + (leftFirst ? 1 : 0);
+			stack[top++] = node.leftFirst + (leftFirst ? 0 : 1);
+			continue;
+		}
+
+		__m128 activeMask = laneMask(active);
+		for (int i = node.leftFirst; i < node.leftFirst + node.count; i++)
+		{
+			//Moller-Trumbore nas 4 lanes
+			const Triangle& triangle = triangles[i];
+			__m128 e1x = _mm_set1_ps(triangle.edge1.x), e1y = _mm_set1_ps(triangle.edge1.y), e1z = _mm_set1_ps(triangle.edge1.z);
+			__m128 e2x = _mm_set1_ps(triangle.edge2.x), e2y = _mm_set1_ps(triangle.edge2.y), e2z = _mm_set1_ps(triangle.edge2.z);
+
+			//p = direcao x aresta 2
+			__m128 px = _mm_sub_ps(_mm_mul_ps(packet.directionY, e2z), _mm_mul_ps(packet.directionZ, e2y));
+			__m128 py = _mm_sub_ps(_mm_mul_ps(packet.directionZ, e2x), _mm_mul_ps(packet.directionX, e2z));
+			__m128 pz = _mm_sub_ps(_mm_mul_ps(packet.directionX, e2y), _mm_mul_ps(packet.directionY, e2x));
+			__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+			__m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+			__m128 sx = _mm_sub_ps(packet.originX, _mm_set1_ps(triangle.v0.x));
+			__m128 sy = _mm_sub_ps(packet.originY, _mm_set1_ps(triangle.v0.y));
+			__m128 sz = _mm_sub_ps(packet.originZ, _mm_set1_ps(triangle.v0.z));
+			__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDeterminant);
+
+			//q = s x aresta 1
+			__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+			__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+			__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+			__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(packet.directionX, qx), _mm_mul_ps(packet.directionY, qy)), _mm_mul_ps(packet.directionZ, qz)), inverseDeterminant);
+			__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDeterminant);
+
+			//Comparacoes ordenadas: NaN (determinante 0, raio paralelo) nunca acerta
+			__m128 zero = _mm_setzero_ps();
+			__m128 hit = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+			hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(t, _mm_set1_ps(MIN_DISTANCE)), _mm_cmplt_ps(t, packet.tMax)));
+			hit = _mm_and_ps(hit, activeMask);
+			int hitLanes = _mm_movemask_ps(hit);
+			if (!hitLanes)
+			{
+				continue;
+			}
+
+			if (anyHit)
+			{
+				hits |= hitLanes;
+				active &= ~hitLanes;
+				if (!active)
+				{
+					return hits;
+				}
+				activeMask = laneMask(active);
+				continue;
+			}
+
+			hits |= hitLanes;
+			packet.tMax = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, packet.tMax));
+			packet.u = _mm_or_ps(_mm_and_ps(hit, u), _mm_andnot_ps(hit, packet.u));
+			packet.v = _mm_or_ps(_mm_and_ps(hit, v), _mm_andnot_ps(hit, packet.v));
+			__m128i hitInt = _mm_castps_si128(hit);
+			packet.triangle = _mm_or_si128(_mm_and_si128(hitInt, _mm_set1_epi32(i)), _mm_andnot_si128(hitInt, packet.triangle));
+		}
+	}
+	return hits;
+}
+
+void BVH::intersect(RayPacket& packet, int active) const
+{
+	traverse<false>(packet, active);
+}
+
+int BVH::occluded(const RayPacket& packet, int active) const
+{
+	RayPacket copy = packet;
+	return traverse<true>(copy, active);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <emmintrin.h>
+
+using namespace std;
+
+//Pacote de 4 raios em SoA, percorrido junto na BVH com SSE2: raios vizinhos (um quad 2x2
+//de pixels, ou as sombras e reflexos dele) visitam quase os mesmos nos, e cada no e lido
+//uma vez para os 4
+struct RayPacket
+{
+	__m128 originX, originY, originZ;
+	__m128 directionX, directionY, directionZ;
+	__m128 inverseX, inverseY, inverseZ; //1 / direcao
+	__m128 tMax; //distancia maxima; depois do intersect, a do acerto mais proximo
+	__m128 u, v; //coordenadas baricentricas do acerto (pesos dos vertices 1 e 2)
+	__m128i triangle; //triangulo atingido, na ordem da BVH (getTriangleIndex), ou -1
+
+	//Origem, direcao e distancia maxima de cada lane
+	void set(const glm::vec3* origins, const glm::vec3* directions, const float* maxDistances);
+};
+
+//Hierarquia de volumes envolventes sobre triangulos, construida pela heuristica de area de
+//superficie (SAH) com os centroides divididos em NB_BINS intervalos por eixo. Os nos
+//ficam em um vetor com os dois filhos lado a lado, e os triangulos sao reordenados para
+//cada folha ser um intervalo continuo
+class BVH
+{
+public:
+	BVH() {}
+	//Tres vertices por triangulo
+	void build(const vector<glm::vec3>& vertices);
+	//Acerto mais proximo das lanes em active (mascara de 4 bits), dentro de tMax
+	void intersect(RayPacket& packet, int active) const;
+	//Lanes de active com algum triangulo antes de tMax; para no primeiro acerto de cada uma
+	int occluded(const RayPacket& packet, int active) const;
+	//Triangulo original (posicao em vertices / 3) de um indice de RayPacket::triangle
+	int getTriangleIndex(int i) const { return triangleIndices[i]; }
+	int getNbNodes() const { return nodes.size(); }
+	int getNbTriangles() const { return triangles.size(); }
+
+	enum { NB_BINS = 16, MAX_LEAF_TRIANGLES = 8, MAX_DEPTH = 64 };
+
+protected:
+	struct Node
+	{
+		glm::vec3 boundsMin;
+		int leftFirst; //filho esquerdo (o direito e o seguinte) ou primeiro triangulo da folha
+		glm::vec3 boundsMax;
+		int count; //triangulos da folha; 0 nos nos internos
+	};
+
+	//Moller-Trumbore: vertice 0 e as arestas a partir dele
+	struct Triangle
+	{
+		glm::vec3 v0, edge1, edge2;
+	};
+
+	struct BuildItem
+	{
+		glm::vec3 boundsMin, boundsMax, centroid;
+	};
+
+	void updateBounds(int node, const vector<BuildItem>& items);
+	void subdivide(int node, int depth, const vector<BuildItem>& items);
+	//Ordem de visita dos filhos pela direcao do primeiro raio ativo: o mais proximo primeiro
+	template<bool anyHit>
+	int traverse(RayPacket& packet, int active) const;
+
+	vector<Node> nodes;
+	vector<Triangle> triangles;
+	vector<int> triangleIndices;
+};
@@ -0,0 +1,793 @@
+#include "Benchmark.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <memory>
+#include <cfloat>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Bezier.h"
+#include "Hermite.h"
+#include "CatmullRom.h"
+#include "Spline.h"
+#include "CurveBatch.h"
+#include "SceneFile.h"
+#include "MipChain.h"
+#include "TextureCache.h"
+#include "PhongKernel.h"
+#include "HeadlessContext.h"
+#include "GLExtensions.h"
+#include "Framebuffer.h"
+#include "GLState.h"
+#include "Arena.h"
+#include "Camera.h"
+#include "Mesh.h"
+#include "CurveRegistry.h"
+#include "MaterialLibrary.h"
+#include "RenderQueue.h"
+#include "ShadowMap.h"
+#include "LightClusters.h"
+#include "DeferredRenderer.h"
+
+static double elapsedMs(chrono::high_resolution_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+static float randomFloat(float min, float max)
+{
+	return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+//Compara o caminho por objeto (G * M * T com glm, como em Bezier::generateCurve)
+//com a avaliacao em lote do CurveBatch
+static void benchmarkCurves()
+{
+	const int nbCurves = 1000, nbControlPoints = 10, nbObjects = 100000, nbFrames = 20;
+
+	srand(42);
+
+	vector<Bezier> curves(nbCurves);
+	CurveBatch batch;
+
+	for (int i = 0; i < nbCurves; i++)
+	{
+		vector<glm::vec3> controlPoints;
+		for (int j = 0; j < nbControlPoints; j++)
+		{
+			controlPoints.push_back(glm::vec3(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1)));
+		}
+		curves[i].setControlPoints(controlPoints);
+		batch.addCurve(curves[i]);
+	}
+
+	vector<int> curveIds(nbObjects);
+	vector<float> t(nbObjects);
+	for (int i = 0; i < nbObjects; i++)
+	{
+		curveIds[i] = rand() % nbCurves;
+		t[i] = randomFloat(0, 1);
+	}
+
+	vector<glm::vec3> positions(nbObjects), tangents(nbObjects);
+	vector<glm::vec3> batchPositions(nbObjects), batchTangents(nbObjects);
+
+	glm::mat4 M(-1, 3, -3, 1,
+		3, -6, 3, 0,
+		-3, 3, 0, 0,
+		1, 0, 0, 0
+	);
+
+	auto start = chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < nbFrames; frame++)
+	{
+		for (int i = 0; i < nbObjects; i++)
+		{
+			Bezier& curve = curves[curveIds[i]];
+			int nSegments = curve.getNbSegments();
+			float ft = t[i] * nSegments;
+			int segment = min((int)ft, nSegments - 1);
+			float u = ft - segment;
+
+			glm::mat4x3 G = curve.getGeometryMatrix(segment);
+			glm::vec4 T(u * u * u, u * u, u, 1);
+			glm::vec4 dT(3 * u * u, 2 * u, 1, 0);
+
+			positions[i] = G * M * T;
+			tangents[i] = G * M * dT;
+		}
+	}
+	double glmMs = elapsedMs(start) / nbFrames;
+
+	start = chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < nbFrames; frame++)
+	{
+		batch.evaluate(curveIds.data(), t.data(), nbObjects, batchPositions.data(), batchTangents.data());
+	}
+	double batchMs = elapsedMs(start) / nbFrames;
+
+	float maxError = 0.0f;
+	for (int i = 0; i < nbObjects; i++)
+	{
+		maxError = max(maxError, glm::length(positions[i] - batchPositions[i]));
+		maxError = max(maxError, glm::length(tangents[i] - batchTangents[i]));
+	}
+
+	cout << "curves: " << nbObjects << " objects on " << nbCurves << " curves" << endl;
+	cout << "  per-object glm: " << glmMs << " ms/frame (" << glmMs * 1e6 / nbObjects << " ns/object)" << endl;
+	cout << "  CurveBatch:     " << batchMs << " ms/frame (" << batchMs * 1e6 / nbObjects << " ns/object)" << endl;
+	cout << "  speedup " << glmMs / batchMs << "x, max error " << maxError << endl;
+}
+
+//Laco das classes de curva antes do Spline<Basis>: G montada e G * M * T para cada ponto
+static void tessellateRuntimeBasis(Curve& curve, int pointsPerSegment, vector<glm::vec3>& curvePoints)
+{
+	glm::mat4 M = curve.getBasisMatrix();
+	float step = 1.0f / (float)pointsPerSegment;
+	int nSegments = curve.getNbSegments();
+
+	curvePoints.clear();
+
+	for (int i = 0; i < nSegments; i++)
+	{
+		for (int k = 0; k < pointsPerSegment; k++)
+		{
+			float t = k * step;
+			glm::vec4 T(t * t * t, t * t, t, 1);
+			glm::mat4x3 G = curve.getGeometryMatrix(i);
+			curvePoints.push_back(G * M * T);
+		}
+	}
+}
+
+//firstSegment: segmento da classe que corresponde ao primeiro do Spline<Basis>
+template <class Basis>
+static void benchmarkSpline(string name, Curve& curve, const vector<glm::vec3>& controlPoints, int nbRuns, int firstSegment = 0)
+{
+	const int pointsPerSegment = 100;
+	vector<glm::vec3> runtimePoints, splinePoints;
+
+	curve.setControlPoints(controlPoints);
+
+	auto start = chrono::high_resolution_clock::now();
+	for (int run = 0; run < nbRuns; run++)
+	{
+		tessellateRuntimeBasis(curve, pointsPerSegment, runtimePoints);
+	}
+	double runtimeMs = elapsedMs(start) / nbRuns;
+
+	start = chrono::high_resolution_clock::now();
+	for (int run = 0; run < nbRuns; run++)
+	{
+		Spline<Basis>::tessellate(controlPoints, pointsPerSegment, splinePoints);
+	}
+	double splineMs = elapsedMs(start) / nbRuns;
+
+	float maxError = 0.0f;
+	int offset = firstSegment * pointsPerSegment;
+	for (int i = 0; i < splinePoints.size() && i + offset < runtimePoints.size(); i++)
+	{
+		maxError = max(maxError, glm::length(runtimePoints[i + offset] - splinePoints[i]));
+	}
+
+	cout << "  " << name << ": runtime M " << runtimeMs << " ms, Spline<Basis> " << splineMs << " ms ("
+		<< runtimeMs / splineMs << "x), " << splinePoints.size() << " points, max error " << maxError << endl;
+}
+
+//Compara as classes de curva (matriz de base em tempo de execucao) com o Spline<Basis>
+static void benchmarkSplines()
+{
+	const int nbControlPoints = 3001, nbRuns = 20;
+
+	srand(42);
+
+	vector<glm::vec3> controlPoints;
+	for (int j = 0; j < nbControlPoints; j++)
+	{
+		controlPoints.push_back(glm::vec3(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1)));
+	}
+
+	Bezier bezier;
+	Hermite hermite;
+	//A classe aberta tem um segmento a mais em cada extremo, com os pontos refletidos
+	CatmullRom catmullRom(CatmullRom::UNIFORM, false);
+
+	cout << "splines: " << nbControlPoints << " control points, 100 points per segment" << endl;
+	benchmarkSpline<BezierBasis>("Bezier", bezier, controlPoints, nbRuns);
+	benchmarkSpline<HermiteBasis>("Hermite", hermite, controlPoints, nbRuns);
+	benchmarkSpline<CatmullRomBasis>("CatmullRom (uniform)", catmullRom, controlPoints, nbRuns, 1);
+
+	//Base sem classe equivalente com matriz em tempo de execucao
+	vector<glm::vec3> points;
+	auto start = chrono::high_resolution_clock::now();
+	for (int run = 0; run < nbRuns; run++)
+	{
+		Spline<BSplineBasis>::tessellate(controlPoints, 100, points);
+	}
+	cout << "  BSpline: Spline<Basis> " << elapsedMs(start) / nbRuns << " ms, " << points.size() << " points" << endl;
+}
+
+//Cena de texto sintetica: um quarto dos objetos tem trajetoria com 4 pontos
+static void writeTextScene(string path, int nbObjects)
+{
+	ofstream out(path);
+
+	out << "cameraPos 0.0 0.0 3.0\ncameraFront 0.0 0.0 -1.0\ncameraUp 0.0 1.0 0.0\n";
+	out << "lightPos -2.0 100.0 2.0\nlightColor 1.0 1.0 1.0\n";
+
+	for (int i = 0; i < nbObjects; i++)
+	{
+		out << "\nfileName " << (i % 2 ? "planeta.obj" : "SuzanneTriTextured.obj") << "\n";
+		out << "position " << randomFloat(-10, 10) << " " << randomFloat(-10, 10) << " " << randomFloat(-10, 10) << "\n";
+		out << "scale " << randomFloat(0.1f, 1) << "\nangle " << randomFloat(0, 360) << "\naxis Y\n";
+
+		if (i % 4 == 0)
+		{
+			out << "startCurve\n";
+			for (int j = 0; j < 4; j++)
+			{
+				out << "curvePoint " << randomFloat(-1, 1) << " " << randomFloat(-1, 1) << " " << randomFloat(-1, 1) << "\n";
+			}
+			out << "endCurve\n";
+		}
+		else
+		{
+			out << "noCurve\n";
+		}
+	}
+}
+
+//Tempo de carga da cena em texto e no formato binario mapeado em memoria.
+//A carga binaria inclui a validacao e uma leitura de todos os registros
+static void benchmarkScene()
+{
+	const int sizes[] = { 1000, 100000, 1000000 };
+	const string textPath = "bench-scene.txt", binaryPath = "bench-scene.scnb";
+
+	srand(42);
+
+	cout << "scene: load time, text vs binary" << endl;
+
+	for (int nbObjects : sizes)
+	{
+		writeTextScene(textPath, nbObjects);
+
+		double textMs, binaryMs;
+		float checksum = 0.0f;
+		{
+			auto start = chrono::high_resolution_clock::now();
+			SceneFile scene;
+			scene.load(textPath);
+			textMs = elapsedMs(start);
+			scene.writeBinary(binaryPath);
+		}
+		{
+			auto start = chrono::high_resolution_clock::now();
+			SceneFile scene;
+			scene.load(binaryPath);
+			for (int i = 0; i < scene.getNbObjects(); i++)
+			{
+				checksum += scene.getObject(i).position[0];
+			}
+			binaryMs = elapsedMs(start);
+		}
+
+		ifstream text(textPath, ios::binary | ios::ate), binary(binaryPath, ios::binary | ios::ate);
+		cout << "  " << nbObjects << " objects: text " << textMs << " ms (" << (text.tellg() >> 10) << " KB), binary "
+			<< binaryMs << " ms (" << (binary.tellg() >> 10) << " KB), " << textMs / binaryMs << "x, checksum " << checksum << endl;
+	}
+
+	remove(textPath.c_str());
+	remove(binaryPath.c_str());
+}
+
+static unsigned long long hashMipChain(MipChain& mips)
+{
+	unsigned long long key = TextureCache::hash(nullptr, 0);
+	for (int level = 1; level < mips.getNbLevels(); level++)
+	{
+		key = TextureCache::hash(mips.getPixels(level), (size_t)mips.getWidth(level) * mips.getHeight(level) * 4, key);
+	}
+	return key;
+}
+
+//Cadeia de mipmaps de uma imagem 2048x2048 em CPU (caixa e Kaiser, 1 e N threads) e
+//com glGenerateMipmap no driver atual; o hash mostra que a CPU nao depende das threads
+static void benchmarkMips()
+{
+	const int size = 2048, nbRuns = 5;
+
+	vector<unsigned char> image((size_t)size * size * 4);
+	srand(42);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			unsigned char* texel = &image[((size_t)y * size + x) * 4];
+			texel[0] = (unsigned char)(((x ^ y) & 0xFF));
+			texel[1] = (unsigned char)((x * y) >> 8);
+			texel[2] = (unsigned char)(rand() & 0xFF);
+			texel[3] = 255;
+		}
+	}
+
+	int nbLevels = MipChain::getNbLevels(size, size);
+	cout << "mips: " << size << "x" << size << " RGBA8, " << nbLevels << " levels, best of " << nbRuns << endl;
+
+	struct Config
+	{
+		const char* name;
+		MipFilter filter;
+		int nbThreads;
+	};
+	const Config configs[] = { { "box, 1 thread", MIP_BOX, 1 }, { "box, all threads", MIP_BOX, 0 },
+		{ "kaiser, 1 thread", MIP_KAISER, 1 }, { "kaiser, all threads", MIP_KAISER, 0 } };
+
+	for (const Config& config : configs)
+	{
+		double best = 1e30;
+		MipChain mips;
+		for (int run = 0; run < nbRuns; run++)
+		{
+			auto start = chrono::high_resolution_clock::now();
+			mips.build(image.data(), size, size, nbLevels, config.filter, config.nbThreads);
+			best = min(best, elapsedMs(start));
+		}
+		cout << "  cpu " << config.name << ": " << best << " ms, hash " << hex << hashMipChain(mips) << dec << endl;
+	}
+
+	glfwInit();
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "mips", nullptr, nullptr);
+	glfwMakeContextCurrent(window);
+
+	if (!window || !gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		cout << "  glGenerateMipmap skipped: no OpenGL context" << endl;
+		glfwTerminate();
+		return;
+	}
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+	glFinish();
+
+	double best = 1e30;
+	for (int run = 0; run < nbRuns; run++)
+	{
+		auto start = chrono::high_resolution_clock::now();
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glFinish();
+		best = min(best, elapsedMs(start));
+	}
+	cout << "  glGenerateMipmap: " << best << " ms (" << glGetString(GL_RENDERER) << ")" << endl;
+
+	glDeleteTextures(1, &texture);
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
+
+//Lote com quads de posicoes, normais, UVs e materiais aleatorios. Passo de UV entre 2^-13 e
+//2^-7: do nivel 0 ampliado ate o nivel 3
+static void randomPhongBatch(PhongBatch& batch, int nbMaterials)
+{
+	batch.nbLanes = PhongBatch::MAX_LANES;
+	for (int quad = 0; quad < PhongBatch::MAX_LANES; quad += 4)
+	{
+		float u = randomFloat(-2.0f, 2.0f), v = randomFloat(-2.0f, 2.0f);
+		float step = pow(2.0f, randomFloat(-13.0f, -7.0f));
+		float position[3], normal[3];
+		for (int c = 0; c < 3; c++)
+		{
+			position[c] = randomFloat(-5.0f, 5.0f);
+			normal[c] = randomFloat(-1.0f, 1.0f);
+		}
+		int material = rand() % nbMaterials;
+		for (int lane = quad; lane < quad + 4; lane++)
+		{
+			batch.positionX[lane] = position[0];
+			batch.positionY[lane] = position[1];
+			batch.positionZ[lane] = position[2];
+			batch.normalX[lane] = normal[0];
+			batch.normalY[lane] = normal[1];
+			batch.normalZ[lane] = normal[2];
+			batch.u[lane] = u + (lane & 1) * step;
+			batch.v[lane] = v + ((lane >> 1) & 1) * step;
+			batch.material[lane] = material;
+			batch.pixel[lane] = lane;
+		}
+	}
+}
+
+//Pixels por segundo do PhongKernel em cada versao suportada pela CPU, sobre lotes sinteticos:
+//quads com posicoes, normais, UVs e derivadas aleatorias, em dois materiais com texturas
+//1024x1024 e um sem textura. Com uma thread o resultado e por nucleo; a ultima linha roda a
+//melhor versao em todas as threads, cada uma com os seus lotes. Cada versao SIMD tambem e
+//comparada byte a byte com a escalar
+static void benchmarkPhong()
+{
+	const int textureSize = 1024, nbMaterials = 3, nbBatches = 8, nbIterations = 500, nbRuns = 5;
+
+	vector<float> ka[3], ks[3], kd(nbMaterials, 0.8f), q(nbMaterials);
+	vector<int32_t> nbLevels(nbMaterials, 1), levelOffset(nbMaterials * PHONG_MAX_LEVELS, 0);
+	vector<int32_t> levelWidth(nbMaterials * PHONG_MAX_LEVELS, 1), levelHeight(nbMaterials * PHONG_MAX_LEVELS, 1);
+	vector<uint32_t> texels(1, 0xFFFFFFFFu);
+	srand(42);
+	for (int c = 0; c < 3; c++)
+	{
+		ka[c].assign(nbMaterials, 0.1f);
+		ks[c].assign(nbMaterials, 0.5f);
+	}
+	vector<unsigned char> image((size_t)textureSize * textureSize * 4);
+	for (int material = 0; material < nbMaterials; material++)
+	{
+		q[material] = randomFloat(2.0f, 64.0f);
+		if (material == nbMaterials - 1)
+		{
+			continue;
+		}
+		for (size_t i = 0; i < image.size(); i++)
+		{
+			image[i] = (unsigned char)(rand() & 0xFF);
+		}
+		MipChain mips;
+		mips.build(image.data(), textureSize, textureSize, MipChain::getNbLevels(textureSize, textureSize), MIP_BOX);
+		nbLevels[material] = mips.getNbLevels();
+		for (int level = 0; level < mips.getNbLevels(); level++)
+		{
+			int slot = material * PHONG_MAX_LEVELS + level;
+			levelOffset[slot] = texels.size();
+			levelWidth[slot] = mips.getWidth(level);
+			levelHeight[slot] = mips.getHeight(level);
+			const uint32_t* pixels = (const uint32_t*)mips.getPixels(level);
+			texels.insert(texels.end(), pixels, pixels + (size_t)levelWidth[slot] * levelHeight[slot]);
+		}
+	}
+
+	PhongUniforms uniforms = {};
+	for (int c = 0; c < 3; c++)
+	{
+		uniforms.lightPos[c] = c == 0 ? 0.0f : 10.0f;
+		uniforms.lightColor[c] = 1.0f;
+		uniforms.cameraPos[c] = c == 2 ? 15.0f : 0.0f;
+		uniforms.ka[c] = ka[c].data();
+		uniforms.ks[c] = ks[c].data();
+	}
+	uniforms.kd = kd.data();
+	uniforms.q = q.data();
+	uniforms.nbLevels = nbLevels.data();
+	uniforms.levelOffset = levelOffset.data();
+	uniforms.levelWidth = levelWidth.data();
+	uniforms.levelHeight = levelHeight.data();
+	uniforms.texels = texels.data();
+
+	static PhongBatch batches[nbBatches];
+	for (PhongBatch& batch : batches)
+	{
+		randomPhongBatch(batch, nbMaterials);
+	}
+
+	//Todas as versoes devem gerar os mesmos bytes: compara cada uma com a escalar em
+	//nbCompared lotes, bem mais pixels que os medidos, para pegar diferencas raras de arredondamento
+	const int nbCompared = 2048;
+	int nbDifferent[NB_PHONG_KERNELS] = {}, maxError[NB_PHONG_KERNELS] = {};
+	static PhongBatch compared;
+	vector<uint32_t> reference(PhongBatch::MAX_LANES);
+	for (int b = 0; b < nbCompared; b++)
+	{
+		randomPhongBatch(compared, nbMaterials);
+		shadePhongScalar(uniforms, compared);
+		copy(compared.color, compared.color + PhongBatch::MAX_LANES, reference.begin());
+		for (int type = PHONG_SCALAR + 1; type < NB_PHONG_KERNELS; type++)
+		{
+			if (!isPhongKernelSupported((PhongKernelType)type))
+			{
+				continue;
+			}
+			getPhongKernel((PhongKernelType)type)(uniforms, compared);
+			for (int lane = 0; lane < PhongBatch::MAX_LANES; lane++)
+			{
+				uint32_t value = compared.color[lane], expected = reference[lane];
+				if (value != expected)
+				{
+					nbDifferent[type]++;
+				}
+				for (int shift = 0; shift < 32; shift += 8)
+				{
+					maxError[type] = max(maxError[type], abs((int)((value >> shift) & 0xFF) - (int)((expected >> shift) & 0xFF)));
+				}
+			}
+		}
+	}
+
+	double nbPixels = (double)nbIterations * nbBatches * PhongBatch::MAX_LANES;
+	cout << "phong: " << nbBatches << " batches of " << PhongBatch::MAX_LANES << " pixels, " << nbMaterials - 1 << " textures " << textureSize << "x" << textureSize
+		<< ", best of " << nbRuns << endl;
+
+	double scalarRate = 0.0;
+	for (int type = 0; type < NB_PHONG_KERNELS; type++)
+	{
+		const char* name = getPhongKernelName((PhongKernelType)type);
+		if (!isPhongKernelSupported((PhongKernelType)type))
+		{
+			cout << "  " << name << ": not supported by this CPU" << endl;
+			continue;
+		}
+
+		PhongKernel kernel = getPhongKernel((PhongKernelType)type);
+		double best = 1e30;
+		for (int run = 0; run < nbRuns; run++)
+		{
+			auto start = chrono::high_resolution_clock::now();
+			for (int iteration = 0; iteration < nbIterations; iteration++)
+			{
+				for (PhongBatch& batch : batches)
+				{
+					kernel(uniforms, batch);
+				}
+			}
+			best = min(best, elapsedMs(start));
+		}
+		double rate = nbPixels / (best * 1e3);
+
+		if (type == PHONG_SCALAR)
+		{
+			scalarRate = rate;
+			cout << "  " << name << ": " << rate << " Mpixels/s per core" << endl;
+		}
+		else
+		{
+			cout << "  " << name << ": " << rate << " Mpixels/s per core (" << rate / scalarRate << "x scalar), ";
+			if (nbDifferent[type] == 0)
+			{
+				cout << "identical to scalar on " << nbCompared * PhongBatch::MAX_LANES << " pixels" << endl;
+			}
+			else
+			{
+				cout << "MISMATCH: " << nbDifferent[type] << " of " << nbCompared * PhongBatch::MAX_LANES << " pixels differ from scalar, max error " << maxError[type] << "/255" << endl;
+			}
+		}
+	}
+
+	//Todas as threads: cada uma copia os lotes, a saida e escrita no proprio lote
+	PhongKernelType bestType = getBestPhongKernel();
+	PhongKernel kernel = getPhongKernel(bestType);
+	int nbThreads = max(1, (int)thread::hardware_concurrency());
+	double best = 1e30;
+	for (int run = 0; run < nbRuns; run++)
+	{
+		vector<thread> threads;
+		auto start = chrono::high_resolution_clock::now();
+		for (int t = 0; t < nbThreads; t++)
+		{
+			threads.push_back(thread([&uniforms, kernel] {
+				//Na pilha: new so respeita o alignas de PhongBatch a partir do C++17
+				PhongBatch local[nbBatches];
+				copy(batches, batches + nbBatches, local);
+				for (int iteration = 0; iteration < nbIterations; iteration++)
+				{
+					for (PhongBatch& batch : local)
+					{
+						kernel(uniforms, batch);
+					}
+				}
+			}));
+		}
+		for (thread& t : threads)
+		{
+			t.join();
+		}
+		best = min(best, elapsedMs(start));
+	}
+	double rate = nbPixels * nbThreads / (best * 1e3);
+	cout << "  " << getPhongKernelName(bestType) << ", " << nbThreads << " threads: " << rate << " Mpixels/s (" << rate / nbThreads << " per core)" << endl;
+}
+
+//Iluminacao forward (sprite.fs) e deferred (DeferredRenderer) nas cenas do projeto, com 0 a
+//4096 luzes pontuais aleatorias na caixa dos objetos no lugar das luzes da cena. Mede o quadro
+//inteiro com glFinish, sem sombras, que custam o mesmo nos dois caminhos
+static void benchmarkLighting()
+{
+	const char* scenePaths[] = { "../config/cena-config.txt", "../config/cena-luzes.txt" };
+	const int lightCounts[] = { 0, 64, 256, 1024, 4096 };
+	const int width = 1280, height = 720, nbWarmupFrames = 5, nbFrames = 30;
+
+	HeadlessContext context;
+	if (!context.create(4, 5) || !gladLoadGLLoader(context.getLoader()))
+	{
+		cout << "lighting: skipped, no OpenGL 4.5 context" << endl;
+		return;
+	}
+	loadGLExtensions(context.getLoader());
+
+	Framebuffer framebuffer;
+	DeferredRenderer deferred;
+	unique_ptr<Shader> forwardShader(new Shader("../shaders/sprite.vs", "../shaders/sprite.fs"));
+	if (!framebuffer.create(width, height) || !deferred.create(width, height))
+	{
+		cout << "lighting: skipped, framebuffer or G-buffer not supported" << endl;
+		return;
+	}
+	framebuffer.bind();
+	cout << "lighting: forward vs deferred, " << width << "x" << height << ", ms per frame (" << glGetString(GL_RENDERER) << ")" << endl;
+
+	srand(42);
+	for (const char* scenePath : scenePaths)
+	{
+		SceneFile scene;
+		if (!scene.load(scenePath))
+		{
+			cout << "  " << scenePath << ": not found" << endl;
+			continue;
+		}
+
+		//Objetos como em readSceneConfig, com as texturas todas residentes
+		GLState state;
+		Arena loadArena, frameArena;
+		CurveRegistry curves;
+		MaterialLibrary materials;
+		vector<Mesh> objects(scene.getNbObjects());
+		glUseProgram(forwardShader->ID);
+		for (int i = 0; i < scene.getNbObjects(); i++)
+		{
+			const SceneObjectRecord& record = scene.getObject(i);
+			const glm::vec3* controlPoints = scene.getControlPoints(record);
+			objects[i].initialSceneConfig(scene.getString(record.fileName), glm::vec3(record.position[0], record.position[1], record.position[2]), record.scale, record.angle,
+				string(1, record.axis), vector<glm::vec3>(controlPoints, controlPoints + record.nbControlPoints), record.instances);
+			objects[i].setPathConfig(scene.getString(record.curveType), record.closedCurve != 0, scene.getString(record.parameterization), record.phase);
+			objects[i].initialize(forwardShader.get(), &curves, &materials, loadArena);
+		}
+		curves.upload();
+		materials.setTextureBudget(0);
+		materials.upload(hasGLExtension("GL_ARB_bindless_texture"), hasGLExtension("GL_EXT_texture_compression_s3tc"));
+		materials.setupShader(forwardShader.get());
+		glUseProgram(deferred.getGeometryShader()->ID);
+		materials.setupShader(deferred.getGeometryShader());
+
+		Camera camera;
+		glUseProgram(forwardShader->ID);
+		camera.initialize(forwardShader.get(), width, height, scene.getCameraPos(), scene.getCameraFront(), scene.getCameraUp());
+		glm::mat4 view = camera.getViewMatrix(), projection = camera.getProjectionMatrix();
+
+		glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+		for (Mesh& object : objects)
+		{
+			glm::vec3 center;
+			float radius;
+			object.getBoundingSphere(0.0f, center, radius);
+			boundsMin = glm::min(boundsMin, center - glm::vec3(radius));
+			boundsMax = glm::max(boundsMax, center + glm::vec3(radius));
+		}
+		float lightRadius = glm::length(boundsMax - boundsMin) * 0.1f;
+
+		ShadowMap noShadows;
+		Shader* lightingShaders[2] = { forwardShader.get(), deferred.getLightingShader() };
+		for (int nbLights : lightCounts)
+		{
+			vector<PointLight> lights(nbLights);
+			for (PointLight& light : lights)
+			{
+				light.positionRadius = glm::vec4(randomFloat(boundsMin.x, boundsMax.x), randomFloat(boundsMin.y, boundsMax.y), randomFloat(boundsMin.z, boundsMax.z), lightRadius);
+				light.color = glm::vec4(randomFloat(0, 1), randomFloat(0, 1), randomFloat(0, 1), 1.0f);
+			}
+			LightClusters clusters;
+			if (nbLights > 0 && !clusters.create(lights))
+			{
+				cout << "  light clusters not supported" << endl;
+				break;
+			}
+
+			double frameMs[2];
+			for (int path = 0; path < 2; path++)
+			{
+				Shader* lightingShader = lightingShaders[path];
+				state.invalidate();
+				state.useProgram(lightingShader->ID);
+				noShadows.setupShader(lightingShader);
+				clusters.setupShader(lightingShader);
+				lightingShader->setVec3("lightPos", scene.getLightPos().x, scene.getLightPos().y, scene.getLightPos().z);
+				lightingShader->setVec3("lightColor", scene.getLightColor().x, scene.getLightColor().y, scene.getLightColor().z);
+
+				auto start = chrono::high_resolution_clock::now();
+				for (int frame = 0; frame < nbWarmupFrames + nbFrames; frame++)
+				{
+					if (frame == nbWarmupFrames)
+					{
+						glFinish();
+						start = chrono::high_resolution_clock::now();
+					}
+					float pathTime = frame / 60.0f;
+
+					glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+					glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+					state.enable(GL_DEPTH_TEST);
+					state.useProgram(forwardShader->ID);
+					curves.getCurveBuffer().bind(state);
+					camera.update();
+					forwardShader->setFloat("pathTime", pathTime);
+					clusters.update(state, view, projection, camera.getNearPlane(), camera.getFarPlane());
+					state.useProgram(lightingShader->ID);
+					clusters.apply(lightingShader, width, height);
+
+					RenderQueue queue;
+					queue.begin(frameArena, objects.size());
+					for (Mesh& object : objects)
+					{
+						queue.push(object.getSortKey(view, camera.getFarPlane()), &object);
+					}
+					queue.sort();
+					materials.bind(state);
+					if (path == 0)
+					{
+						queue.submit(state);
+					}
+					else
+					{
+						deferred.render(state, queue, view, projection, camera.getPosition(), pathTime);
+					}
+					frameArena.reset();
+				}
+				glFinish();
+				frameMs[path] = elapsedMs(start) / nbFrames;
+			}
+
+			cout << "  " << scenePath << ", " << nbLights << " lights: forward " << frameMs[0] << " ms, deferred " << frameMs[1] << " ms ("
+				<< frameMs[0] / frameMs[1] << "x)" << endl;
+		}
+
+		objects.clear();
+		curves.clear();
+		materials.deleteResources();
+	}
+
+	deferred.destroy();
+	framebuffer.destroy();
+	forwardShader.reset();
+	context.destroy();
+}
+
+int runBenchmark(string name)
+{
+	if (name == "curves")
+	{
+		benchmarkCurves();
+		return 0;
+	}
+	else if (name == "splines")
+	{
+		benchmarkSplines();
+		return 0;
+	}
+	else if (name == "scene")
+	{
+		benchmarkScene();
+		return 0;
+	}
+	else if (name == "mips")
+	{
+		benchmarkMips();
+		return 0;
+	}
+	else if (name == "phong")
+	{
+		benchmarkPhong();
+		return 0;
+	}
+	else if (name == "lighting")
+	{
+		benchmarkLighting();
+		return 0;
+	}
+
+	cout << "Unknown benchmark: " << name << endl;
+	return -1;
+}
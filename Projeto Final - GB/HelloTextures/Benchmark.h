@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+//Microbenchmarks executados via linha de comando: HelloTextures.exe --bench <nome>
+//Retorna 0 se o benchmark existe e foi executado
+int runBenchmark(string name);
@@ -3,69 +3,25 @@
 
 Bezier::Bezier()
 {
-	M = glm::mat4(-1, 3, -3, 1,
-		3, -6, 3, 0,
-		-3, 3, 0, 0,
-		1, 0, 0, 0
-	);
+	M = Spline<BezierBasis>::getBasisMatrix();
 }
 
-void Bezier::generateCurve(int pointsPerSegment)
+int Bezier::getNbSegments()
 {
-	float step = 1.0 / (float)pointsPerSegment;
-
-	float t = 0;
-
-	int nControlPoints = controlPoints.size();
-
-	for (int i = 0; i < nControlPoints - 3; i += 3)
-	{
-
-		for (float t = 0.0; t <= 1.0; t += step)
-		{
-			glm::vec3 p;
-
-			glm::vec4 T(t * t * t, t * t, t, 1);
-
-			glm::vec3 P0 = controlPoints[i];
-			glm::vec3 P1 = controlPoints[i + 1];
-			glm::vec3 P2 = controlPoints[i + 2];
-			glm::vec3 P3 = controlPoints[i + 3];
-
-			glm::mat4x3 G(P0, P1, P2, P3);
-
-			p = G * M * T;  
-
-			curvePoints.push_back(p);
-		}
-	}
-
-	//Gera o VAO
-	GLuint VBO;
-
-	//Gera do identificador do VBO
-	glGenBuffers(1, &VBO);
-
-	//Faz a conexo (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-	//Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, curvePoints.size() * sizeof(GLfloat) * 3, curvePoints.data(), GL_STATIC_DRAW);
-
-	//Gera do identificador do VAO 
-	glGenVertexArrays(1, &VAO);
-
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vrtices
-	// e os ponteiros para os atributos 
-	glBindVertexArray(VAO);
+	return Spline<BezierBasis>::getNbSegments(controlPoints.size());
+}
 
-	//Atributo posio (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
+glm::mat4x3 Bezier::getGeometryMatrix(int segment)
+{
+	return Spline<BezierBasis>::getGeometryMatrix(controlPoints, segment);
+}
 
-	
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+void Bezier::getAffectedSegments(int controlPoint, vector<int>& segments)
+{
+	Spline<BezierBasis>::getAffectedSegments(controlPoint, controlPoints.size(), segments);
+}
 
-	// Desvincula o VAO
-	glBindVertexArray(0);
+SplineSegment Bezier::getSegment(int segment)
+{
+	return Spline<BezierBasis>::getSegment(controlPoints, segment);
 }
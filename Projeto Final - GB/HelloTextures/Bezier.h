@@ -1,11 +1,15 @@
 #pragma once
 #include "Curve.h"
+#include "Spline.h"
 
 class Bezier :
     public Curve
 {
 public:
     Bezier();
-    void generateCurve(int pointsPerSegment);
+    int getNbSegments();
+    glm::mat4x3 getGeometryMatrix(int segment);
+    void getAffectedSegments(int controlPoint, vector<int>& segments);
+    SplineSegment getSegment(int segment);
 };
 
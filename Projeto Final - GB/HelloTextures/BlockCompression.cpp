@@ -0,0 +1,439 @@
+#include "BlockCompression.h"
+
+#include <emmintrin.h>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+int getBlockBytes(BlockFormat format)
+{
+	return format == BLOCK_BC1 ? 8 : (format == BLOCK_BC3 ? 16 : 4);
+}
+
+size_t getCompressedSize(BlockFormat format, int width, int height)
+{
+	if (format == BLOCK_RGBA8)
+	{
+		return (size_t)width * height * 4;
+	}
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(format);
+}
+
+//Copia o bloco 4x4 em (bx, by) para 64 bytes contiguos, repetindo as bordas
+static void loadBlock(const unsigned char* rgba, int width, int height, int bx, int by, unsigned char* block)
+{
+	for (int y = 0; y < 4; y++)
+	{
+		int sy = min(by * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++)
+		{
+			int sx = min(bx * 4 + x, width - 1);
+			memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+		}
+	}
+}
+
+static unsigned short packRGB565(int r, int g, int b)
+{
+	return (unsigned short)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static void unpackRGB565(unsigned short c, int* rgb)
+{
+	int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+//Soma pares de int32 vizinhos de a e b: [a0+a1, a2+a3, b0+b1, b2+b3]
+static __m128i addPairs(__m128i a, __m128i b)
+{
+	__m128 even = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1));
+	return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+
+//Indice de cada texel pela projecao no eixo entre as cores dos extremos; as 4 linhas
+//do bloco sao processadas em registradores SSE2
+static unsigned int selectIndices(const __m128i* rows, unsigned short c0, unsigned short c1)
+{
+	int e0[3], e1[3];
+	unpackRGB565(c0, e0);
+	unpackRGB565(c1, e1);
+
+	int dir[3] = { e0[0] - e1[0], e0[1] - e1[1], e0[2] - e1[2] };
+	int total = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+
+	const __m128i zero = _mm_setzero_si128();
+	__m128i origin = _mm_setr_epi16(e1[0], e1[1], e1[2], 0, e1[0], e1[1], e1[2], 0);
+	__m128i axis = _mm_setr_epi16(dir[0], dir[1], dir[2], 0, dir[0], dir[1], dir[2], 0);
+	__m128i limit5 = _mm_set1_epi32(5 * total), limit3 = _mm_set1_epi32(3 * total), limit1 = _mm_set1_epi32(total);
+
+	alignas(16) int steps[16];
+	for (int i = 0; i < 4; i++)
+	{
+		//Produto escalar (texel - e1) . dir dos 4 texels da linha
+		__m128i low = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(rows[i], zero), origin), axis);
+		__m128i high = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(rows[i], zero), origin), axis);
+		__m128i dot = addPairs(low, high);
+
+		//t = dot / total em sextos: quantos dos limites 1/6, 3/6 e 5/6 foram passados
+		__m128i dot6 = _mm_add_epi32(_mm_slli_epi32(dot, 2), _mm_slli_epi32(dot, 1));
+		__m128i passed = _mm_add_epi32(_mm_add_epi32(_mm_cmpgt_epi32(dot6, limit5), _mm_cmpgt_epi32(dot6, limit3)), _mm_cmpgt_epi32(dot6, limit1));
+		_mm_store_si128((__m128i*)(steps + i * 4), _mm_sub_epi32(zero, passed));
+	}
+
+	//0 limites = c1 (indice 1), 1 = 2/3 c1 (3), 2 = 2/3 c0 (2), 3 = c0 (0)
+	static const unsigned int remap[4] = { 1, 3, 2, 0 };
+	unsigned int indices = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		indices |= remap[steps[i]] << (i * 2);
+	}
+	return indices;
+}
+
+//Peso de c0 na cor de cada indice do modo de 4 cores, em tercos
+static const int colorWeights[4] = { 3, 0, 2, 1 };
+
+static int colorError(const unsigned char* block, unsigned short c0, unsigned short c1, unsigned int indices)
+{
+	int e0[3], e1[3];
+	unpackRGB565(c0, e0);
+	unpackRGB565(c1, e1);
+
+	int error = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int w = colorWeights[(indices >> (i * 2)) & 3];
+		for (int c = 0; c < 3; c++)
+		{
+			int diff = (w * e0[c] + (3 - w) * e1[c]) / 3 - block[i * 4 + c];
+			error += diff * diff;
+		}
+	}
+	return error;
+}
+
+//Com os indices fixos, os extremos que minimizam o erro saem de minimos quadrados
+static bool refineEndpoints(const unsigned char* block, unsigned int indices, unsigned short& c0, unsigned short& c1)
+{
+	float aa = 0, bb = 0, ab = 0, ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		float a = colorWeights[(indices >> (i * 2)) & 3] / 3.0f, b = 1.0f - a;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (int c = 0; c < 3; c++)
+		{
+			ax[c] += a * block[i * 4 + c];
+			bx[c] += b * block[i * 4 + c];
+		}
+	}
+
+	float det = aa * bb - ab * ab;
+	if (fabsf(det) < 1e-6f)
+	{
+		return false;
+	}
+
+	int hi[3], lo[3];
+	for (int c = 0; c < 3; c++)
+	{
+		hi[c] = min(255, max(0, (int)((ax[c] * bb - bx[c] * ab) / det + 0.5f)));
+		lo[c] = min(255, max(0, (int)((bx[c] * aa - ax[c] * ab) / det + 0.5f)));
+	}
+
+	c0 = packRGB565(hi[0], hi[1], hi[2]);
+	c1 = packRGB565(lo[0], lo[1], lo[2]);
+	if (c0 < c1)
+	{
+		swap(c0, c1);
+	}
+	return c0 != c1;
+}
+
+//Extremos iniciais pela caixa envolvente (encolhida 1/16 para dentro) e uma rodada de
+//minimos quadrados, que fica so se diminuir o erro
+static void encodeColorBlock(const unsigned char* block, unsigned char* out)
+{
+	__m128i rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = _mm_loadu_si128((const __m128i*)(block + i * 16));
+	}
+
+	__m128i minColor = _mm_min_epu8(_mm_min_epu8(rows[0], rows[1]), _mm_min_epu8(rows[2], rows[3]));
+	__m128i maxColor = _mm_max_epu8(_mm_max_epu8(rows[0], rows[1]), _mm_max_epu8(rows[2], rows[3]));
+	minColor = _mm_min_epu8(minColor, _mm_shuffle_epi32(minColor, _MM_SHUFFLE(1, 0, 3, 2)));
+	minColor = _mm_min_epu8(minColor, _mm_shuffle_epi32(minColor, _MM_SHUFFLE(2, 3, 0, 1)));
+	maxColor = _mm_max_epu8(maxColor, _mm_shuffle_epi32(maxColor, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxColor = _mm_max_epu8(maxColor, _mm_shuffle_epi32(maxColor, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	unsigned int minPacked = _mm_cvtsi128_si32(minColor), maxPacked = _mm_cvtsi128_si32(maxColor);
+	int lo[3], hi[3];
+	for (int c = 0; c < 3; c++)
+	{
+		int mn = (minPacked >> (c * 8)) & 0xFF, mx = (maxPacked >> (c * 8)) & 0xFF;
+		int inset = (mx - mn) >> 4;
+		lo[c] = mn + inset;
+		hi[c] = mx - inset;
+	}
+
+	//Cada canal de hi >= lo, entao c0 >= c1 e o bloco fica no modo de 4 cores
+	unsigned short c0 = packRGB565(hi[0], hi[1], hi[2]);
+	unsigned short c1 = packRGB565(lo[0], lo[1], lo[2]);
+	unsigned int indices = 0;
+
+	if (c0 != c1)
+	{
+		indices = selectIndices(rows, c0, c1);
+
+		unsigned short r0, r1;
+		if (refineEndpoints(block, indices, r0, r1))
+		{
+			unsigned int refined = selectIndices(rows, r0, r1);
+			if (colorError(block, r0, r1, refined) < colorError(block, c0, c1, indices))
+			{
+				c0 = r0;
+				c1 = r1;
+				indices = refined;
+			}
+		}
+	}
+
+	out[0] = c0 & 0xFF;
+	out[1] = c0 >> 8;
+	out[2] = c1 & 0xFF;
+	out[3] = c1 >> 8;
+	memcpy(out + 4, &indices, 4);
+}
+
+//Modo de 8 alfas: a0 = maximo, a1 = minimo e 6 valores interpolados entre eles
+static void encodeAlphaBlock(const unsigned char* block, unsigned char* out)
+{
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; i++)
+	{
+		a0 = max(a0, (int)block[i * 4 + 3]);
+		a1 = min(a1, (int)block[i * 4 + 3]);
+	}
+
+	unsigned long long indices = 0;
+	if (a0 != a1)
+	{
+		int range = a0 - a1;
+		for (int i = 0; i < 16; i++)
+		{
+			//k = 0 e a1, k = 7 e a0; os intermediarios ficam nos indices 8 - k
+			int k = ((block[i * 4 + 3] - a1) * 14 + range) / (2 * range);
+			unsigned long long index = k == 7 ? 0 : (k == 0 ? 1 : 8 - k);
+			indices |= index << (i * 3);
+		}
+	}
+
+	out[0] = (unsigned char)a0;
+	out[1] = (unsigned char)a1;
+	for (int i = 0; i < 6; i++)
+	{
+		out[2 + i] = (unsigned char)(indices >> (i * 8));
+	}
+}
+
+static void compressRows(BlockFormat format, const unsigned char* rgba, int width, int height, unsigned char* blocks, int firstRow, int lastRow)
+{
+	int blocksX = (width + 3) / 4;
+	int blockBytes = getBlockBytes(format);
+	alignas(16) unsigned char block[64];
+
+	for (int by = firstRow; by < lastRow; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			unsigned char* out = blocks + ((size_t)by * blocksX + bx) * blockBytes;
+			loadBlock(rgba, width, height, bx, by, block);
+
+			if (format == BLOCK_BC3)
+			{
+				encodeAlphaBlock(block, out);
+				out += 8;
+			}
+			encodeColorBlock(block, out);
+		}
+	}
+}
+
+void compressBlocks(BlockFormat format, const unsigned char* rgba, int width, int height, unsigned char* blocks, int nbThreads)
+{
+	if (format == BLOCK_RGBA8)
+	{
+		memcpy(blocks, rgba, getCompressedSize(format, width, height));
+		return;
+	}
+
+	int blocksY = (height + 3) / 4;
+
+	if (nbThreads <= 0)
+	{
+		nbThreads = max(1, (int)thread::hardware_concurrency());
+	}
+	//Abaixo de ~16 linhas de blocos por thread o custo de criar threads domina
+	nbThreads = max(1, min(nbThreads, blocksY / 16));
+
+	if (nbThreads == 1)
+	{
+		compressRows(format, rgba, width, height, blocks, 0, blocksY);
+		return;
+	}
+
+	vector<thread> workers;
+	for (int i = 0; i < nbThreads; i++)
+	{
+		int firstRow = blocksY * i / nbThreads, lastRow = blocksY * (i + 1) / nbThreads;
+		workers.push_back(thread(compressRows, format, rgba, width, height, blocks, firstRow, lastRow));
+	}
+
+	for (int i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+static void decodeColorBlock(const unsigned char* in, bool threeColorMode, unsigned char* block)
+{
+	unsigned short c0 = in[0] | (in[1] << 8), c1 = in[2] | (in[3] << 8);
+	int palette[4][4];
+	unpackRGB565(c0, palette[0]);
+	unpackRGB565(c1, palette[1]);
+
+	for (int c = 0; c < 3; c++)
+	{
+		if (c0 > c1 || !threeColorMode)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		palette[i][3] = 255;
+	}
+	if (c0 <= c1 && threeColorMode)
+	{
+		palette[3][3] = 0;
+	}
+
+	unsigned int indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((unsigned int)in[7] << 24);
+	for (int i = 0; i < 16; i++)
+	{
+		const int* color = palette[(indices >> (i * 2)) & 3];
+		for (int c = 0; c < 4; c++)
+		{
+			block[i * 4 + c] = (unsigned char)color[c];
+		}
+	}
+}
+
+static void decodeAlphaBlock(const unsigned char* in, unsigned char* block)
+{
+	int palette[8] = { in[0], in[1] };
+	for (int i = 2; i < 8; i++)
+	{
+		if (palette[0] > palette[1])
+		{
+			palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7;
+		}
+		else
+		{
+			palette[i] = i < 6 ? ((6 - i) * palette[0] + (i - 1) * palette[1]) / 5 : (i == 6 ? 0 : 255);
+		}
+	}
+
+	unsigned long long indices = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		indices |= (unsigned long long)in[2 + i] << (i * 8);
+	}
+
+	for (int i = 0; i < 16; i++)
+	{
+		block[i * 4 + 3] = (unsigned char)palette[(indices >> (i * 3)) & 7];
+	}
+}
+
+void decompressBlocks(BlockFormat format, const unsigned char* blocks, int width, int height, unsigned char* rgba)
+{
+	if (format == BLOCK_RGBA8)
+	{
+		memcpy(rgba, blocks, getCompressedSize(format, width, height));
+		return;
+	}
+
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	int blockBytes = getBlockBytes(format);
+	unsigned char block[64];
+
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			const unsigned char* in = blocks + ((size_t)by * blocksX + bx) * blockBytes;
+
+			if (format == BLOCK_BC3)
+			{
+				decodeColorBlock(in + 8, false, block);
+				decodeAlphaBlock(in, block);
+			}
+			else
+			{
+				decodeColorBlock(in, true, block);
+			}
+
+			for (int y = 0; y < 4 && by * 4 + y < height; y++)
+			{
+				for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+				{
+					memcpy(rgba + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4, block + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+}
+
+float computePSNR(const unsigned char* reference, const unsigned char* image, int width, int height, int stride, int channels)
+{
+	double error = 0.0;
+
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			size_t offset = ((size_t)y * stride + x) * 4;
+			for (int c = 0; c < channels; c++)
+			{
+				double diff = (double)reference[offset + c] - image[offset + c];
+				error += diff * diff;
+			}
+		}
+	}
+
+	double mse = error / ((double)width * height * channels);
+	if (mse <= 0.0)
+	{
+		return 99.0f;
+	}
+	return (float)(10.0 * log10(255.0 * 255.0 / mse));
+}
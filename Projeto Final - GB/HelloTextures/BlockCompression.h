@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+//Compressao S3TC em CPU: BC1 (DXT1, RGB com 4 bits por texel) e BC3 (DXT5, RGBA com
+//8 bits por texel). A entrada e sempre RGBA8; lados que nao sao multiplos de 4
+//repetem a ultima linha/coluna dentro do bloco
+enum BlockFormat
+{
+	BLOCK_BC1,
+	BLOCK_BC3,
+	BLOCK_RGBA8 //sem compressao, para texturas guardadas no mesmo formato de niveis
+};
+
+//No RGBA8 o "bloco" e um texel
+int getBlockBytes(BlockFormat format);
+size_t getCompressedSize(BlockFormat format, int width, int height);
+//nbThreads = 0 usa todos os nucleos; imagens pequenas ficam em uma thread so
+void compressBlocks(BlockFormat format, const unsigned char* rgba, int width, int height, unsigned char* blocks, int nbThreads = 0);
+void decompressBlocks(BlockFormat format, const unsigned char* blocks, int width, int height, unsigned char* rgba);
+//PSNR em dB de uma regiao width x height; stride em texels. channels = 3 ignora o alfa
+float computePSNR(const unsigned char* reference, const unsigned char* image, int width, int height, int stride, int channels);
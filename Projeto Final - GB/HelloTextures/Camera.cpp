@@ -17,11 +17,15 @@ void Camera::initialize(Shader* shader, int width, int height, glm::vec3 cameraP
 
 	//Matriz de view -- posio e orientao da cmera
 	glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-	shader->setMat4("view", value_ptr(view));
 
 	//Matriz de projeo perspectiva - definindo o volume de visualizao (frustum)
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
-	shader->setMat4("projection", glm::value_ptr(projection));
+	projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, nearPlane, farPlane);
+
+	if (shader)
+	{
+		shader->setMat4("view", value_ptr(view));
+		shader->setMat4("projection", glm::value_ptr(projection));
+	}
 }
 
 void Camera::rotate(GLFWwindow* window, double xpos, double ypos)
@@ -61,6 +65,11 @@ void Camera::update() {
 	shader->setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
 }
 
+glm::mat4 Camera::getViewMatrix()
+{
+	return glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+}
+
 void Camera::move(GLFWwindow* window, int key, int action)
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
@@ -13,10 +13,16 @@ class Camera
 public:
 	Camera() {}
 	~Camera() {}
+	//shader pode ser nulo (SoftwareRenderer): as matrizes ficam so nos getters
 	void initialize(Shader* shader, int width, int height, glm::vec3 cameraPos = glm::vec3(0.0, 0.0, 3.0), glm::vec3 cameraFront = glm::vec3(0.0, 0.0, -1.0), glm::vec3 cameraUp = glm::vec3(0.0, 1.0, 0.0), float sensitivity = 0.05, float pitch = 0.0, float yaw = -90.0);
 	void move(GLFWwindow* window, int key, int action);
 	void rotate(GLFWwindow* window, double xpos, double ypos);
 	void update();
+	glm::mat4 getViewMatrix();
+	glm::mat4 getProjectionMatrix() { return projection; }
+	float getNearPlane() { return nearPlane; }
+	float getFarPlane() { return farPlane; }
+	glm::vec3 getPosition() { return cameraPos; }
 
 protected:
 	Shader* shader;
@@ -24,5 +30,7 @@ protected:
 	float lastX, lastY, pitch, yaw;
 	float sensitivity;
 	glm::vec3 cameraFront, cameraPos, cameraUp;
+	glm::mat4 projection;
+	float nearPlane = 0.1f, farPlane = 100.0f;
 };
 
@@ -1,71 +1,114 @@
 #include "CatmullRom.h"
 
-CatmullRom::CatmullRom()
+#include <cmath>
+#include <algorithm>
+
+//Cada segmento vai de P[i] a P[i + 1] e usa a janela P[i - 1] .. P[i + 2] (passo 1).
+//Com parametrizacao nao uniforme o segmento e convertido para a forma de Hermite,
+//entao G = (P[i], P[i + 1], T[i], T[i + 1]) e M e a base de Hermite.
+CatmullRom::CatmullRom(Parameterization parameterization, bool closed)
 {
-	M = glm::mat4(-1, 3, -3, 1,
-		2, -5, 4, -1,
-		-1, 0, 1, 0,
-		0, 2, 0, 0
-	);
+	M = Spline<HermiteBasis>::getBasisMatrix();
+	setParameterization(parameterization);
+	this->closed = closed;
 }
 
-void CatmullRom::generateCurve(int pointsPerSegment)
+void CatmullRom::setParameterization(Parameterization parameterization)
 {
-	float step = 1.0 / (float)pointsPerSegment;
-
-	float t = 0;
+	if (parameterization == UNIFORM)
+	{
+		alpha = 0.0f;
+	}
+	else if (parameterization == CHORDAL)
+	{
+		alpha = 1.0f;
+	}
+	else
+	{
+		alpha = 0.5f;
+	}
+}
 
+int CatmullRom::getNbSegments()
+{
 	int nControlPoints = controlPoints.size();
 
-	for (int i = 0; i < nControlPoints - 3; i += 3)
+	if (closed)
 	{
+		return nControlPoints >= 3 ? nControlPoints : 0;
+	}
 
-		for (float t = 0.0; t <= 1.0; t += step)
-		{
-			glm::vec3 p;
-
-			glm::vec4 T(t * t * t, t * t, t, 1);
+	return nControlPoints >= 2 ? nControlPoints - 1 : 0;
+}
 
-			glm::vec3 P0 = controlPoints[i];
-			glm::vec3 P1 = controlPoints[i + 1];
-			glm::vec3 P2 = controlPoints[i + 2];
-			glm::vec3 P3 = controlPoints[i + 3];
+//Em curvas abertas os extremos sao refletidos, assim a curva passa por todos os pontos
+glm::vec3 CatmullRom::getWindowPoint(int i)
+{
+	int n = controlPoints.size();
 
-			glm::mat4x3 G(P0, P1, P2, P3);
+	if (closed)
+	{
+		return controlPoints[((i % n) + n) % n];
+	}
+	if (i < 0)
+	{
+		return 2.0f * controlPoints[0] - controlPoints[1];
+	}
+	if (i >= n)
+	{
+		return 2.0f * controlPoints[n - 1] - controlPoints[n - 2];
+	}
+	return controlPoints[i];
+}
 
-			p = G * M * T;  
-			p = p * glm::vec3(0.5, 0.5, 0.5);
+float CatmullRom::getKnotInterval(glm::vec3 p0, glm::vec3 p1)
+{
+	float d = pow(glm::dot(p1 - p0, p1 - p0), alpha * 0.5f);
 
-			curvePoints.push_back(p);
-		}
-	}
+	//Pontos repetidos nao podem gerar intervalo nulo
+	return d < 1e-4f ? 1.0f : d;
+}
 
-	//Gera o VAO
-	GLuint VBO;
+glm::mat4x3 CatmullRom::getGeometryMatrix(int segment)
+{
+	glm::vec3 P0 = getWindowPoint(segment - 1);
+	glm::vec3 P1 = getWindowPoint(segment);
+	glm::vec3 P2 = getWindowPoint(segment + 1);
+	glm::vec3 P3 = getWindowPoint(segment + 2);
 
-	//Gera o identificador do VBO
-	glGenBuffers(1, &VBO);
+	float dt0 = getKnotInterval(P0, P1);
+	float dt1 = getKnotInterval(P1, P2);
+	float dt2 = getKnotInterval(P2, P3);
 
-	//Faz a conexo (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	//Tangentes nos extremos do segmento, reescaladas para t em [0, 1]
+	glm::vec3 T1 = (P1 - P0) / dt0 - (P2 - P0) / (dt0 + dt1) + (P2 - P1) / dt1;
+	glm::vec3 T2 = (P2 - P1) / dt1 - (P3 - P1) / (dt1 + dt2) + (P3 - P2) / dt2;
 
-	//Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, curvePoints.size() * sizeof(GLfloat) * 3, curvePoints.data(), GL_STATIC_DRAW);
+	return glm::mat4x3(P1, P2, T1 * dt1, T2 * dt1);
+}
 
-	//Gera do identificador do VAO
-	glGenVertexArrays(1, &VAO);
+void CatmullRom::getAffectedSegments(int controlPoint, vector<int>& segments)
+{
+	int nSegments = getNbSegments();
 
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta os buffers de vrtices
-	// e os ponteiros para os atributos 
-	glBindVertexArray(VAO);
+	segments.clear();
 
-	//Atributo posio (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
+	for (int s = controlPoint - 2; s <= controlPoint + 1; s++)
+	{
+		int segment = s;
 
-	
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+		if (closed)
+		{
+			segment = ((s % nSegments) + nSegments) % nSegments;
+		}
+		else if (s < 0 || s >= nSegments)
+		{
+			continue;
+		}
 
-	
-	glBindVertexArray(0);
+		if (find(segments.begin(), segments.end(), segment) == segments.end())
+		{
+			segments.push_back(segment);
+		}
+	}
 }
@@ -1,10 +1,25 @@
 #pragma once
 #include "Curve.h"
+#include "Spline.h"
 class CatmullRom :
     public Curve
 {
 public:
-    CatmullRom();
-    void generateCurve(int pointsPerSegment);
-};
+    //Parametrizacao dos nos: alpha = 0, 0.5 ou 1
+    enum Parameterization { UNIFORM, CENTRIPETAL, CHORDAL };
+
+    CatmullRom(Parameterization parameterization = CENTRIPETAL, bool closed = false);
+    void setParameterization(Parameterization parameterization);
+    void setClosed(bool closed) { this->closed = closed; }
+    bool isClosed() { return closed; }
+    int getNbSegments();
+    glm::mat4x3 getGeometryMatrix(int segment);
+    void getAffectedSegments(int controlPoint, vector<int>& segments);
 
+protected:
+    glm::vec3 getWindowPoint(int i);
+    float getKnotInterval(glm::vec3 p0, glm::vec3 p1);
+
+    float alpha;
+    bool closed;
+};
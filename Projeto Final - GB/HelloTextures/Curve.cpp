@@ -6,6 +6,131 @@ void Curve::setShader(Shader* shader)
 	shader->Use();
 }
 
+SplineSegment Curve::getSegment(int segment)
+{
+	glm::mat4x3 C = getSegmentCoefficients(segment);
+
+	SplineSegment s;
+	s.a = C[0];
+	s.b = C[1];
+	s.c = C[2];
+	s.d = C[3];
+	return s;
+}
+
+void Curve::generateCurve(int pointsPerSegment)
+{
+	int nSegments = getNbSegments();
+
+	//A tesselacao e compartilhada por todos os objetos da trajetoria (CurveRegistry)
+	if (this->pointsPerSegment == pointsPerSegment && !curvePoints.empty())
+	{
+		return;
+	}
+
+	deleteCurveBuffer();
+
+	this->pointsPerSegment = pointsPerSegment;
+	curvePoints.clear();
+
+	if (nSegments == 0)
+	{
+		return;
+	}
+
+	//Um ponto extra fecha o ultimo segmento
+	curvePoints.resize(nSegments * pointsPerSegment + 1);
+
+	for (int s = 0; s < nSegments; s++)
+	{
+		tessellateSegment(s);
+	}
+
+	setupCurveBuffer();
+}
+
+void Curve::tessellateSegment(int segment)
+{
+	SplineSegment s = getSegment(segment);
+	float step = 1.0f / (float)pointsPerSegment;
+	int first = segment * pointsPerSegment;
+
+	for (int k = 0; k < pointsPerSegment; k++)
+	{
+		curvePoints[first + k] = s.evaluate(k * step);
+	}
+
+	if (segment == getNbSegments() - 1)
+	{
+		curvePoints[first + pointsPerSegment] = s.evaluate(1.0f);
+	}
+}
+
+void Curve::setControlPoint(int i, glm::vec3 point, vector<int>& affectedSegments)
+{
+	controlPoints[i] = point;
+	getAffectedSegments(i, affectedSegments);
+
+	if (curvePoints.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+	for (int s : affectedSegments)
+	{
+		tessellateSegment(s);
+
+		int first = s * pointsPerSegment;
+		int count = (s == getNbSegments() - 1) ? pointsPerSegment + 1 : pointsPerSegment;
+		glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), count * sizeof(glm::vec3), &curvePoints[first]);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Curve::setupCurveBuffer()
+{
+	//Gera o VAO
+	//Gera do identificador do VBO
+	glGenBuffers(1, &VBO);
+
+	//Faz a conexo (vincula) do buffer como um buffer de array
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+	//Envia os dados do array de floats para o buffer da OpenGl
+	glBufferData(GL_ARRAY_BUFFER, curvePoints.size() * sizeof(GLfloat) * 3, curvePoints.data(), GL_DYNAMIC_DRAW);
+
+	//Gera do identificador do VAO 
+	glGenVertexArrays(1, &VAO);
+
+	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vrtices
+	// e os ponteiros para os atributos 
+	glBindVertexArray(VAO);
+
+	//Atributo posio (x, y, z)
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Desvincula o VAO
+	glBindVertexArray(0);
+}
+
+void Curve::deleteCurveBuffer()
+{
+	if (VAO != 0)
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		VAO = 0;
+		VBO = 0;
+	}
+}
+
 void Curve::drawCurve(glm::vec4 color)
 {
 	shader->setVec4("finalColor", color.r, color.g, color.b, color.a);
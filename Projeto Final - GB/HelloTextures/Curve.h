@@ -9,6 +9,7 @@
 #include <vector> 
 
 #include "Shader.h"
+#include "Spline.h"
 
 using namespace std;
 
@@ -16,17 +17,34 @@ class Curve
 {
 public:
 	Curve() {}
+	virtual ~Curve() {}
 	inline void setControlPoints(vector <glm::vec3> controlPoints) { this->controlPoints = controlPoints; }
 	void setShader(Shader* shader);
 	void generateCurve(int pointsPerSegment);
 	void drawCurve(glm::vec4 color);
+	void deleteCurveBuffer();
+	int getNbControlPoints() { return controlPoints.size(); }
+	glm::vec3 getControlPoint(int i) { return controlPoints[i]; }
+	//Move um ponto de controle e retessela apenas os segmentos afetados
+	void setControlPoint(int i, glm::vec3 point, vector<int>& affectedSegments);
 	int getNbCurvePoints() { return curvePoints.size(); }
 	glm::vec3 getPointOnCurve(int i) { return curvePoints[i]; }
+	glm::mat4 getBasisMatrix() { return M; }
+	virtual int getNbSegments() = 0;
+	virtual glm::mat4x3 getGeometryMatrix(int segment) = 0;
+	virtual void getAffectedSegments(int controlPoint, vector<int>& segments) = 0;
+	//Coeficientes (a, b, c, d) do segmento: p(t) = a*t^3 + b*t^2 + c*t + d
+	glm::mat4x3 getSegmentCoefficients(int segment) { return getGeometryMatrix(segment) * M; }
+	virtual SplineSegment getSegment(int segment);
 protected:
+	void tessellateSegment(int segment);
+	void setupCurveBuffer();
+
 	vector <glm::vec3> controlPoints;
 	vector <glm::vec3> curvePoints;
 	glm::mat4 M; //Matriz de base
-	GLuint VAO;
+	int pointsPerSegment = 0;
+	GLuint VAO = 0, VBO = 0;
 	Shader* shader;
 };
 
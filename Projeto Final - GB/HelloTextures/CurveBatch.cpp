@@ -0,0 +1,208 @@
+#include "CurveBatch.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CURVE_BATCH_LANES 8
+#else
+#include <emmintrin.h>
+#define CURVE_BATCH_LANES 4
+#endif
+
+int CurveBatch::addCurve(Curve& curve)
+{
+	int nSegments = curve.getNbSegments();
+
+	if (nSegments == 0)
+	{
+		return -1;
+	}
+
+	firstSegment.push_back(coeffs[0].size());
+	nbSegments.push_back(nSegments);
+	segmentScale.push_back((float)nSegments);
+
+	for (int i = 0; i < NB_COEFFS; i++)
+	{
+		coeffs[i].reserve(coeffs[i].size() + nSegments);
+	}
+
+	for (int s = 0; s < nSegments; s++)
+	{
+		glm::mat4x3 C = curve.getSegmentCoefficients(s);
+
+		for (int c = 0; c < 4; c++)
+		{
+			coeffs[c * 3 + 0].push_back(C[c].x);
+			coeffs[c * 3 + 1].push_back(C[c].y);
+			coeffs[c * 3 + 2].push_back(C[c].z);
+		}
+	}
+
+	return firstSegment.size() - 1;
+}
+
+void CurveBatch::clear()
+{
+	for (int i = 0; i < NB_COEFFS; i++)
+	{
+		coeffs[i].clear();
+	}
+	firstSegment.clear();
+	nbSegments.clear();
+	segmentScale.clear();
+}
+
+void CurveBatch::evaluateScalar(const int* curveIds, const float* t, int count, glm::vec3* positions, glm::vec3* tangents)
+{
+	for (int i = 0; i < count; i++)
+	{
+		int id = curveIds[i];
+		float ns = segmentScale[id];
+		float ft = std::min(std::max(t[i], 0.0f), 1.0f) * ns;
+		float segment = std::min((float)(int)ft, ns - 1.0f);
+		float u = ft - segment;
+		int s = firstSegment[id] + (int)segment;
+
+		glm::vec3 a(coeffs[AX][s], coeffs[AY][s], coeffs[AZ][s]);
+		glm::vec3 b(coeffs[BX][s], coeffs[BY][s], coeffs[BZ][s]);
+		glm::vec3 c(coeffs[CX][s], coeffs[CY][s], coeffs[CZ][s]);
+		glm::vec3 d(coeffs[DX][s], coeffs[DY][s], coeffs[DZ][s]);
+
+		positions[i] = ((a * u + b) * u + c) * u + d;
+
+		if (tangents)
+		{
+			tangents[i] = (a * (3.0f * u) + b * 2.0f) * u + c;
+		}
+	}
+}
+
+#if defined(__AVX2__)
+
+void CurveBatch::evaluate(const int* curveIds, const float* t, int count, glm::vec3* positions, glm::vec3* tangents)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 three = _mm256_set1_ps(3.0f);
+
+	alignas(32) float p[3][CURVE_BATCH_LANES], d[3][CURVE_BATCH_LANES];
+
+	int i = 0;
+	for (; i + CURVE_BATCH_LANES <= count; i += CURVE_BATCH_LANES)
+	{
+		//Segmento e parametro local de cada lane
+		__m256i id = _mm256_loadu_si256((const __m256i*)(curveIds + i));
+		__m256 ns = _mm256_i32gather_ps(segmentScale.data(), id, 4);
+		__m256i first = _mm256_i32gather_epi32(firstSegment.data(), id, 4);
+		__m256 ft = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(t + i), zero), one), ns);
+		__m256 segment = _mm256_min_ps(_mm256_floor_ps(ft), _mm256_sub_ps(ns, one));
+		__m256 u = _mm256_sub_ps(ft, segment);
+		__m256i s = _mm256_add_epi32(first, _mm256_cvttps_epi32(segment));
+
+		for (int k = 0; k < 3; k++)
+		{
+			__m256 a = _mm256_i32gather_ps(coeffs[AX + k].data(), s, 4);
+			__m256 b = _mm256_i32gather_ps(coeffs[BX + k].data(), s, 4);
+			__m256 c = _mm256_i32gather_ps(coeffs[CX + k].data(), s, 4);
+			__m256 e = _mm256_i32gather_ps(coeffs[DX + k].data(), s, 4);
+
+			//Horner: ((a*u + b)*u + c)*u + d
+			__m256 r = _mm256_add_ps(_mm256_mul_ps(a, u), b);
+			r = _mm256_add_ps(_mm256_mul_ps(r, u), c);
+			r = _mm256_add_ps(_mm256_mul_ps(r, u), e);
+			_mm256_store_ps(p[k], r);
+
+			//Derivada: (3a*u + 2b)*u + c
+			__m256 dr = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(three, a), u), _mm256_mul_ps(two, b));
+			dr = _mm256_add_ps(_mm256_mul_ps(dr, u), c);
+			_mm256_store_ps(d[k], dr);
+		}
+
+		for (int l = 0; l < CURVE_BATCH_LANES; l++)
+		{
+			positions[i + l] = glm::vec3(p[0][l], p[1][l], p[2][l]);
+		}
+
+		if (tangents)
+		{
+			for (int l = 0; l < CURVE_BATCH_LANES; l++)
+			{
+				tangents[i + l] = glm::vec3(d[0][l], d[1][l], d[2][l]);
+			}
+		}
+	}
+
+	evaluateScalar(curveIds + i, t + i, count - i, positions + i, tangents ? tangents + i : nullptr);
+}
+
+#else
+
+void CurveBatch::evaluate(const int* curveIds, const float* t, int count, glm::vec3* positions, glm::vec3* tangents)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 three = _mm_set1_ps(3.0f);
+
+	alignas(16) float p[3][CURVE_BATCH_LANES], d[3][CURVE_BATCH_LANES];
+	alignas(16) int s[CURVE_BATCH_LANES];
+
+	int i = 0;
+	for (; i + CURVE_BATCH_LANES <= count; i += CURVE_BATCH_LANES)
+	{
+		//SSE2 nao tem gather: os dados por curva sao carregados lane a lane
+		const int* id = curveIds + i;
+		__m128 ns = _mm_setr_ps(segmentScale[id[0]], segmentScale[id[1]], segmentScale[id[2]], segmentScale[id[3]]);
+		__m128i first = _mm_setr_epi32(firstSegment[id[0]], firstSegment[id[1]], firstSegment[id[2]], firstSegment[id[3]]);
+
+		//t >= 0, entao truncar equivale a floor
+		__m128 ft = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(t + i), zero), one), ns);
+		__m128 segment = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(ft)), _mm_sub_ps(ns, one));
+		__m128 u = _mm_sub_ps(ft, segment);
+		_mm_store_si128((__m128i*)s, _mm_add_epi32(first, _mm_cvttps_epi32(segment)));
+
+		for (int k = 0; k < 3; k++)
+		{
+			const float* A = coeffs[AX + k].data();
+			const float* B = coeffs[BX + k].data();
+			const float* C = coeffs[CX + k].data();
+			const float* D = coeffs[DX + k].data();
+
+			__m128 a = _mm_setr_ps(A[s[0]], A[s[1]], A[s[2]], A[s[3]]);
+			__m128 b = _mm_setr_ps(B[s[0]], B[s[1]], B[s[2]], B[s[3]]);
+			__m128 c = _mm_setr_ps(C[s[0]], C[s[1]], C[s[2]], C[s[3]]);
+			__m128 e = _mm_setr_ps(D[s[0]], D[s[1]], D[s[2]], D[s[3]]);
+
+			//Horner: ((a*u + b)*u + c)*u + d
+			__m128 r = _mm_add_ps(_mm_mul_ps(a, u), b);
+			r = _mm_add_ps(_mm_mul_ps(r, u), c);
+			r = _mm_add_ps(_mm_mul_ps(r, u), e);
+			_mm_store_ps(p[k], r);
+
+			//Derivada: (3a*u + 2b)*u + c
+			__m128 dr = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(three, a), u), _mm_mul_ps(two, b));
+			dr = _mm_add_ps(_mm_mul_ps(dr, u), c);
+			_mm_store_ps(d[k], dr);
+		}
+
+		for (int l = 0; l < CURVE_BATCH_LANES; l++)
+		{
+			positions[i + l] = glm::vec3(p[0][l], p[1][l], p[2][l]);
+		}
+
+		if (tangents)
+		{
+			for (int l = 0; l < CURVE_BATCH_LANES; l++)
+			{
+				tangents[i + l] = glm::vec3(d[0][l], d[1][l], d[2][l]);
+			}
+		}
+	}
+
+	evaluateScalar(curveIds + i, t + i, count - i, positions + i, tangents ? tangents + i : nullptr);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "Curve.h"
+
+using namespace std;
+
+//Avalia muitas curvas de uma vez: os coeficientes de todos os segmentos ficam
+//em layout SoA e cada lane SIMD calcula a posicao/tangente de um objeto
+class CurveBatch
+{
+public:
+	CurveBatch() {}
+	int addCurve(Curve& curve);
+	void clear();
+	int getNbCurves() { return firstSegment.size(); }
+	int getNbSegments() { return coeffs[0].size(); }
+	//t em [0, 1] percorre a curva inteira; positions e tangents recebem count elementos
+	void evaluate(const int* curveIds, const float* t, int count, glm::vec3* positions, glm::vec3* tangents);
+	void evaluateScalar(const int* curveIds, const float* t, int count, glm::vec3* positions, glm::vec3* tangents);
+
+protected:
+	//Indice de cada componente dos coeficientes a, b, c, d (x, y, z)
+	enum { AX, AY, AZ, BX, BY, BZ, CX, CY, CZ, DX, DY, DZ, NB_COEFFS };
+
+	vector<float> coeffs[NB_COEFFS];
+	vector<int> firstSegment, nbSegments;
+	vector<float> segmentScale; //nbSegments como float, evita conversao na lane
+};
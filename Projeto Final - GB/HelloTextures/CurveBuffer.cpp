@@ -0,0 +1,159 @@
+#include "CurveBuffer.h"
+#include "GLExtensions.h"
+
+int CurveBuffer::addCurve(Curve& curve)
+{
+	int nSegments = curve.getNbSegments();
+
+	if (nSegments == 0)
+	{
+		return -1;
+	}
+
+	glm::mat4 M = curve.getBasisMatrix();
+	int basis = 0;
+	while (basis < basisMatrices.size() && basisMatrices[basis] != M)
+	{
+		basis++;
+	}
+	if (basis == basisMatrices.size())
+	{
+		basisMatrices.push_back(M);
+	}
+
+	curves.push_back(glm::ivec4(geometry.size(), nSegments, basis, 0));
+
+	for (int s = 0; s < nSegments; s++)
+	{
+		glm::mat4x3 G = curve.getGeometryMatrix(s);
+		geometry.push_back(glm::mat4(glm::vec4(G[0], 0), glm::vec4(G[1], 0), glm::vec4(G[2], 0), glm::vec4(G[3], 0)));
+	}
+
+	return curves.size() - 1;
+}
+
+int CurveBuffer::removeCurve(int id)
+{
+	if (id < 0 || id >= curves.size())
+	{
+		return -1;
+	}
+
+	int last = curves.size() - 1;
+	curves[id] = curves[last];
+	curves.pop_back();
+	removed = true;
+	return id == last ? -1 : last;
+}
+
+void CurveBuffer::compact()
+{
+	vector<glm::mat4> packed;
+	packed.reserve(geometry.size());
+	for (int i = 0; i < curves.size(); i++)
+	{
+		int first = curves[i].x;
+		curves[i].x = packed.size();
+		packed.insert(packed.end(), geometry.begin() + first, geometry.begin() + first + curves[i].y);
+	}
+	geometry.swap(packed);
+	removed = false;
+}
+
+void CurveBuffer::upload()
+{
+	if (removed)
+	{
+		compact();
+	}
+
+	if (SSBO[0] == 0)
+	{
+		glGenBuffers(3, SSBO);
+		//VAO vazio: os vertices da curva sao gerados a partir de gl_VertexID
+		glGenVertexArrays(1, &VAO);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO[BASIS_BINDING]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, basisMatrices.size() * sizeof(glm::mat4), basisMatrices.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO[GEOMETRY_BINDING]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, geometry.size() * sizeof(glm::mat4), geometry.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO[CURVES_BINDING]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, curves.size() * sizeof(glm::ivec4), curves.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+//Reenvia so as matrizes G dos segmentos que mudaram
+void CurveBuffer::updateSegments(int id, Curve& curve, const vector<int>& segments)
+{
+	if (id < 0)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO[GEOMETRY_BINDING]);
+
+	for (int s : segments)
+	{
+		int index = curves[id].x + s;
+		glm::mat4x3 G = curve.getGeometryMatrix(s);
+		geometry[index] = glm::mat4(glm::vec4(G[0], 0), glm::vec4(G[1], 0), glm::vec4(G[2], 0), glm::vec4(G[3], 0));
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, index * sizeof(glm::mat4), sizeof(glm::mat4), &geometry[index]);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void CurveBuffer::bind(GLState& state)
+{
+	if (removed && SSBO[0] != 0)
+	{
+		upload();
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, i, SSBO[i]);
+	}
+}
+
+void CurveBuffer::drawCurves(GLState& state, Shader* shader, int pointsPerCurve, glm::vec4 color)
+{
+	if (removed && SSBO[0] != 0)
+	{
+		upload();
+	}
+	if (curves.size() == 0)
+	{
+		return;
+	}
+
+	state.useProgram(shader->ID);
+	shader->setInt("pointsPerCurve", pointsPerCurve);
+	shader->setVec4("finalColor", color.r, color.g, color.b, color.a);
+
+	//Uma instancia por curva, cada uma desenhada como uma line strip independente
+	state.bindVertexArray(VAO);
+	glDrawArraysInstanced(GL_LINE_STRIP, 0, pointsPerCurve, curves.size());
+}
+
+void CurveBuffer::clear()
+{
+	basisMatrices.clear();
+	geometry.clear();
+	curves.clear();
+	removed = false;
+}
+
+void CurveBuffer::deleteBuffers()
+{
+	if (SSBO[0] != 0)
+	{
+		glDeleteBuffers(3, SSBO);
+		glDeleteVertexArrays(1, &VAO);
+		SSBO[0] = SSBO[1] = SSBO[2] = 0;
+		VAO = 0;
+	}
+}
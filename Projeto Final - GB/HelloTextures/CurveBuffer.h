@@ -0,0 +1,46 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "Shader.h"
+#include "Curve.h"
+#include "GLState.h"
+
+using namespace std;
+
+//Guarda pontos de controle e matrizes de base de todas as curvas da cena em SSBOs,
+//para que as posicoes sobre as trajetorias sejam calculadas no vertex shader
+class CurveBuffer
+{
+public:
+	CurveBuffer() {}
+	int addCurve(Curve& curve);
+	//Tira o registro; o ultimo registro passa a ocupar o lugar de id. Os segmentos so sao
+	//compactados e reenviados no proximo bind ou drawCurves. Retorna o indice antigo do
+	//registro movido, -1 se nenhum mudou
+	int removeCurve(int id);
+	int getNbCurves() { return curves.size(); }
+	void upload();
+	void updateSegments(int id, Curve& curve, const vector<int>& segments);
+	void bind(GLState& state);
+	void drawCurves(GLState& state, Shader* shader, int pointsPerCurve, glm::vec4 color);
+	void deleteBuffers();
+	void clear();
+
+	//Pontos de ligacao dos SSBOs nos shaders (layout(binding = ...))
+	enum { BASIS_BINDING = 0, GEOMETRY_BINDING = 1, CURVES_BINDING = 2 };
+
+protected:
+	//Junta os segmentos das curvas restantes, na ordem dos registros
+	void compact();
+
+	vector<glm::mat4> basisMatrices;
+	vector<glm::mat4> geometry; //Um G por segmento, colunas com w = 0
+	vector<glm::ivec4> curves; //primeiro segmento, numero de segmentos, base, livre
+	bool removed = false; //geometry tem segmentos de curvas removidas
+	GLuint SSBO[3] = { 0, 0, 0 };
+	GLuint VAO = 0;
+};
@@ -0,0 +1,229 @@
+#include "CurveRegistry.h"
+#include "Bezier.h"
+#include "Hermite.h"
+#include "CatmullRom.h"
+
+#include <cstring>
+
+//FNV-1a sobre o tipo da curva e os bytes dos pontos de controle
+uint64_t CurveRegistry::hashPath(const string& curveType, const string& parameterization, bool closed, const vector<glm::vec3>& controlPoints)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	auto add = [&hash](const void* data, size_t size) {
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+		}
+	};
+
+	add(curveType.data(), curveType.size());
+	add(parameterization.data(), parameterization.size());
+	add(&closed, sizeof(closed));
+	add(controlPoints.data(), controlPoints.size() * sizeof(glm::vec3));
+
+	return hash;
+}
+
+shared_ptr<Curve> CurveRegistry::createCurve(const string& curveType, const string& parameterization, bool closed)
+{
+	if (curveType == "catmullrom")
+	{
+		CatmullRom::Parameterization p = CatmullRom::CENTRIPETAL;
+		if (parameterization == "uniform")
+		{
+			p = CatmullRom::UNIFORM;
+		}
+		else if (parameterization == "chordal")
+		{
+			p = CatmullRom::CHORDAL;
+		}
+		return make_shared<CatmullRom>(p, closed);
+	}
+	else if (curveType == "hermite")
+	{
+		return make_shared<Hermite>();
+	}
+
+	return make_shared<Bezier>();
+}
+
+bool CurveRegistry::matches(const Path& path, const string& curveType, const string& parameterization, bool closed, const vector<glm::vec3>& controlPoints)
+{
+	if (!path.curve || path.curveType != curveType || path.parameterization != parameterization || path.closed != closed)
+	{
+		return false;
+	}
+
+	if (path.curve->getNbControlPoints() != controlPoints.size())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < controlPoints.size(); i++)
+	{
+		if (path.curve->getControlPoint(i) != controlPoints[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int CurveRegistry::acquire(string curveType, string parameterization, bool closed, const vector<glm::vec3>& controlPoints)
+{
+	//Bezier e Hermite nao dependem da parametrizacao nem do fechamento
+	if (curveType != "catmullrom")
+	{
+		parameterization = "";
+		closed = false;
+	}
+
+	uint64_t key = hashPath(curveType, parameterization, closed, controlPoints);
+
+	auto range = pathsByKey.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (matches(paths[it->second], curveType, parameterization, closed, controlPoints))
+		{
+			paths[it->second].references++;
+			return it->second;
+		}
+	}
+
+	Path path;
+	path.curve = createCurve(curveType, parameterization, closed);
+	path.curve->setControlPoints(controlPoints);
+	path.curveId = curveBuffer.addCurve(*path.curve);
+
+	if (path.curveId < 0)
+	{
+		return -1;
+	}
+
+	path.curveType = curveType;
+	path.parameterization = parameterization;
+	path.closed = closed;
+	path.key = key;
+	path.references = 1;
+
+	//Reaproveita a posicao de uma trajetoria liberada
+	int index = 0;
+	while (index < paths.size() && paths[index].curve)
+	{
+		index++;
+	}
+	if (index == paths.size())
+	{
+		paths.push_back(path);
+	}
+	else
+	{
+		paths[index] = path;
+	}
+	pathsByKey.insert(make_pair(key, index));
+
+	return index;
+}
+
+void CurveRegistry::removeKey(int path)
+{
+	auto range = pathsByKey.equal_range(paths[path].key);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == path)
+		{
+			pathsByKey.erase(it);
+			return;
+		}
+	}
+}
+
+//A ultima referencia tira a curva do CurveBuffer, que deixa de desenha-la; a trajetoria que
+//ocupava o ultimo registro dele passa para o registro liberado
+void CurveRegistry::release(int path)
+{
+	if (path < 0 || !paths[path].curve)
+	{
+		return;
+	}
+
+	if (--paths[path].references == 0)
+	{
+		removeKey(path);
+		paths[path].curve->deleteCurveBuffer();
+		paths[path].curve.reset();
+
+		int moved = curveBuffer.removeCurve(paths[path].curveId);
+		for (int i = 0; moved >= 0 && i < paths.size(); i++)
+		{
+			if (paths[i].curve && paths[i].curveId == moved)
+			{
+				paths[i].curveId = paths[path].curveId;
+				break;
+			}
+		}
+		paths[path].curveId = -1;
+	}
+}
+
+int CurveRegistry::getNbPaths()
+{
+	int count = 0;
+	for (int i = 0; i < paths.size(); i++)
+	{
+		if (paths[i].curve)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+int CurveRegistry::getNbReferences()
+{
+	int count = 0;
+	for (int i = 0; i < paths.size(); i++)
+	{
+		count += paths[i].references;
+	}
+	return count;
+}
+
+//Move o ponto para todos os objetos que compartilham a trajetoria e atualiza a chave
+void CurveRegistry::moveControlPoint(int path, int index, glm::vec3 offset)
+{
+	Curve* curve = paths[path].curve.get();
+	vector<int> affectedSegments;
+
+	curve->setControlPoint(index, curve->getControlPoint(index) + offset, affectedSegments);
+	curveBuffer.updateSegments(paths[path].curveId, *curve, affectedSegments);
+
+	vector<glm::vec3> controlPoints;
+	for (int i = 0; i < curve->getNbControlPoints(); i++)
+	{
+		controlPoints.push_back(curve->getControlPoint(i));
+	}
+
+	removeKey(path);
+	paths[path].key = hashPath(paths[path].curveType, paths[path].parameterization, paths[path].closed, controlPoints);
+	pathsByKey.insert(make_pair(paths[path].key, path));
+}
+
+void CurveRegistry::clear()
+{
+	for (int i = 0; i < paths.size(); i++)
+	{
+		if (paths[i].curve)
+		{
+			paths[i].curve->deleteCurveBuffer();
+		}
+	}
+
+	paths.clear();
+	pathsByKey.clear();
+	curveBuffer.deleteBuffers();
+	curveBuffer.clear();
+}
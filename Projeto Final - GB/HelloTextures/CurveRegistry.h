@@ -0,0 +1,55 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Curve.h"
+#include "CurveBuffer.h"
+
+using namespace std;
+
+//Trajetorias compartilhadas: objetos com os mesmos pontos de controle e o mesmo tipo
+//de curva usam a mesma Curve e o mesmo registro no CurveBuffer; cada objeto guarda
+//apenas o identificador da trajetoria e a sua fase
+class CurveRegistry
+{
+public:
+	CurveRegistry() {}
+	//Retorna o identificador da trajetoria ou -1 se os pontos nao formam nenhum segmento
+	int acquire(string curveType, string parameterization, bool closed, const vector<glm::vec3>& controlPoints);
+	void release(int path);
+	Curve* getCurve(int path) { return paths[path].curve.get(); }
+	int getCurveId(int path) { return paths[path].curveId; }
+	int getNbPaths();
+	int getNbReferences();
+	void moveControlPoint(int path, int index, glm::vec3 offset);
+	CurveBuffer& getCurveBuffer() { return curveBuffer; }
+	void upload() { curveBuffer.upload(); }
+	void clear();
+
+protected:
+	struct Path
+	{
+		shared_ptr<Curve> curve;
+		string curveType, parameterization;
+		bool closed;
+		uint64_t key;
+		int curveId;
+		int references;
+	};
+
+	static uint64_t hashPath(const string& curveType, const string& parameterization, bool closed, const vector<glm::vec3>& controlPoints);
+	static shared_ptr<Curve> createCurve(const string& curveType, const string& parameterization, bool closed);
+	bool matches(const Path& path, const string& curveType, const string& parameterization, bool closed, const vector<glm::vec3>& controlPoints);
+	void removeKey(int path);
+
+	vector<Path> paths;
+	unordered_multimap<uint64_t, int> pathsByKey;
+	CurveBuffer curveBuffer;
+};
@@ -0,0 +1,139 @@
+#include "DeferredRenderer.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+//Formatos dos alvos, na ordem das saidas de gbuffer.fs
+static const GLenum targetFormats[DeferredRenderer::NB_TARGETS] = { GL_RGBA8, GL_RG16, GL_RGBA8, GL_RGBA8 };
+static const char* const targetNames[DeferredRenderer::NB_TARGETS] = { "gAlbedo", "gNormal", "gSpecular", "gAmbient" };
+
+static GLuint createTarget(GLenum format, int width, int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format == GL_DEPTH_COMPONENT24 ? GL_DEPTH_COMPONENT : GL_RGBA,
+		format == GL_DEPTH_COMPONENT24 ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE, nullptr);
+	//Lidas com texelFetch; sem mipmaps a textura so fica completa com filtro sem mipmap
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	return texture;
+}
+
+bool DeferredRenderer::create(int width, int height)
+{
+	destroy();
+	this->width = width;
+	this->height = height;
+
+	geometryShader.reset(new Shader("../shaders/sprite.vs", "../shaders/gbuffer.fs"));
+	lightingShader.reset(new Shader("../shaders/deferred.vs", "../shaders/deferred.fs"));
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	GLenum drawBuffers[NB_TARGETS];
+	for (int i = 0; i < NB_TARGETS; i++)
+	{
+		targets[i] = createTarget(targetFormats[i], width, height);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, targets[i], 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	depthTexture = createTarget(GL_DEPTH_COMPONENT24, width, height);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	glDrawBuffers(NB_TARGETS, drawBuffers);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	if (!complete)
+	{
+		destroy();
+		return false;
+	}
+
+	glUseProgram(lightingShader->ID);
+	for (int i = 0; i < NB_TARGETS; i++)
+	{
+		lightingShader->setInt(targetNames[i], FIRST_TEXTURE_UNIT + i);
+	}
+	lightingShader->setInt("gDepth", FIRST_TEXTURE_UNIT + NB_TARGETS);
+
+	glGenVertexArrays(1, &emptyVertexArray);
+	geometryTimer.create();
+	lightingTimer.create();
+	return true;
+}
+
+void DeferredRenderer::destroy()
+{
+	if (framebuffer)
+	{
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(NB_TARGETS, targets);
+		glDeleteTextures(1, &depthTexture);
+		glDeleteVertexArrays(1, &emptyVertexArray);
+		framebuffer = depthTexture = emptyVertexArray = 0;
+		for (int i = 0; i < NB_TARGETS; i++)
+		{
+			targets[i] = 0;
+		}
+	}
+	geometryTimer.destroy();
+	lightingTimer.destroy();
+	geometryShader.reset();
+	lightingShader.reset();
+}
+
+void DeferredRenderer::render(GLState& state, RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, float pathTime)
+{
+	if (!isCreated())
+	{
+		return;
+	}
+	geometryTimer.poll();
+	lightingTimer.poll();
+
+	//A cor do G-buffer nao precisa ser limpa: pixels sem geometria ficam com profundidade 1
+	//e o passo de iluminacao os descarta
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	state.enable(GL_DEPTH_TEST);
+	state.depthFunc(GL_LESS);
+	state.depthMask(true);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	state.useProgram(geometryShader->ID);
+	glUniformMatrix4fv(glGetUniformLocation(geometryShader->ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(glGetUniformLocation(geometryShader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	geometryShader->setFloat("pathTime", pathTime);
+
+	geometryTimer.begin();
+	queue.submit(state, geometryShader.get());
+	geometryTimer.end();
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+
+	//Iluminacao: a profundidade do G-buffer tambem vai para o framebuffer da cena, para o
+	//que for desenhado depois (trajetorias) ser ocultado pelos objetos
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	state.useProgram(lightingShader->ID);
+	glUniformMatrix4fv(glGetUniformLocation(lightingShader->ID, "inverseViewProj"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glUniformMatrix4fv(glGetUniformLocation(lightingShader->ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	lightingShader->setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
+	for (int i = 0; i < NB_TARGETS; i++)
+	{
+		state.bindTexture(FIRST_TEXTURE_UNIT + i, GL_TEXTURE_2D, targets[i]);
+	}
+	state.bindTexture(FIRST_TEXTURE_UNIT + NB_TARGETS, GL_TEXTURE_2D, depthTexture);
+	state.depthFunc(GL_ALWAYS);
+	state.bindVertexArray(emptyVertexArray);
+
+	lightingTimer.begin();
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	lightingTimer.end();
+
+	state.depthFunc(GL_LESS);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <memory>
+
+#include "Shader.h"
+#include "GLState.h"
+#include "GPUTimer.h"
+#include "RenderQueue.h"
+
+using namespace std;
+
+//Caminho deferred, escolhido por cena (renderer deferred). O passo de geometria desenha a
+//fila com sprite.vs e gbuffer.fs num G-buffer compacto de 4 alvos de 32 bits: albedo e kd,
+//normal em octaedro (RG16), ks e q, ka; a posicao e reconstruida da profundidade. O passo de
+//iluminacao (deferred.vs/fs) cobre a tela com um triangulo e calcula a luz principal, as
+//sombras e as luzes pontuais dos clusters uma vez por pixel, qualquer que seja a sobreposicao
+class DeferredRenderer
+{
+public:
+	DeferredRenderer() {}
+	~DeferredRenderer() { destroy(); }
+	//G-buffer do tamanho do framebuffer da cena; retorna false se o driver nao aceitar os anexos
+	bool create(int width, int height);
+	void destroy();
+	bool isCreated() { return framebuffer != 0; }
+	//Programa do passo de geometria, que precisa dos uniforms da MaterialLibrary
+	Shader* getGeometryShader() { return geometryShader.get(); }
+	//Programa do passo de iluminacao, que recebe a luz, as sombras e os clusters no lugar de sprite.fs
+	Shader* getLightingShader() { return lightingShader.get(); }
+
+	//Desenha a fila no G-buffer e ilumina no framebuffer de desenho atual, gravando tambem a
+	//profundidade dele. Precisa do CurveBuffer e das texturas ligados, como o passo forward
+	void render(GLState& state, RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, float pathTime);
+
+	double getGeometryTime() { return geometryTimer.getAverageTime(); }
+	double getLightingTime() { return lightingTimer.getAverageTime(); }
+	int getBytesPerPixel() { return NB_TARGETS * 4 + 4; }
+
+	//Alvos de cor do G-buffer; as texturas dele ficam nas unidades seguintes as do mapa de sombras
+	enum { NB_TARGETS = 4, FIRST_TEXTURE_UNIT = 9 };
+
+protected:
+	unique_ptr<Shader> geometryShader, lightingShader;
+	GLuint framebuffer = 0;
+	GLuint targets[NB_TARGETS] = {};
+	GLuint depthTexture = 0;
+	GLuint emptyVertexArray = 0; //o triangulo de tela cheia nao tem atributos
+	int width = 0, height = 0;
+	GPUTimer geometryTimer, lightingTimer;
+};
@@ -0,0 +1,108 @@
+#include "DepthPrepass.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+void DepthPrepass::create()
+{
+	destroy();
+	depthShader.reset(new Shader("../shaders/prepass.vs", "../shaders/shadow.fs"));
+	glGenQueries(1, &query);
+	timer.create();
+}
+
+void DepthPrepass::destroy()
+{
+	if (query)
+	{
+		glDeleteQueries(1, &query);
+		query = 0;
+	}
+	timer.destroy();
+	depthShader.reset();
+}
+
+void DepthPrepass::render(GLState& state, Arena& frameArena, vector<Mesh>& objects, const glm::mat4& view, const glm::mat4& projection, float farPlane, float pathTime)
+{
+	rendered = false;
+	nbDraws = 0;
+	if (!enabled || !isCreated())
+	{
+		return;
+	}
+	timer.poll();
+
+	//Da frente para tras pelo centro da esfera envolvente, que para objetos em trajetoria
+	//acompanha as instancias; a chave so tem a profundidade
+	queue.begin(frameArena, objects.size());
+	for (int i = 0; i < objects.size(); i++)
+	{
+		glm::vec3 center;
+		float radius;
+		objects[i].getBoundingSphere(pathTime, center, radius);
+		float depth = -(view * glm::vec4(center, 1.0f)).z / farPlane;
+		queue.push(RenderQueue::makeKey(0, 0, 0, depth), &objects[i]);
+	}
+	queue.sort();
+
+	state.useProgram(depthShader->ID);
+	//setMat4 recebe float*, entao as matrizes constantes sao copiadas
+	glm::mat4 viewMatrix = view, projectionMatrix = projection;
+	depthShader->setMat4("view", glm::value_ptr(viewMatrix));
+	depthShader->setMat4("projection", glm::value_ptr(projectionMatrix));
+	depthShader->setFloat("pathTime", pathTime);
+	state.enable(GL_DEPTH_TEST);
+	state.depthFunc(GL_LESS);
+	state.depthMask(true);
+	//Sem cor: o passo principal grava todos os pixels visiveis
+	state.colorMask(false);
+
+	timer.begin();
+	queue.submitDepth(state, depthShader.get());
+	timer.end();
+
+	state.colorMask(true);
+	nbDraws = queue.getNbItems();
+	rendered = true;
+}
+
+void DepthPrepass::beginMainPass(GLState& state, Shader* shader)
+{
+	if (rendered)
+	{
+		state.depthFunc(GL_EQUAL);
+		state.depthMask(false);
+	}
+	if (overdraw)
+	{
+		state.enable(GL_BLEND);
+		state.blendFunc(GL_ONE, GL_ONE);
+	}
+	shader->setBool("showOverdraw", overdraw);
+
+	if (query)
+	{
+		glBeginQuery(GL_SAMPLES_PASSED, query);
+	}
+}
+
+void DepthPrepass::endMainPass(GLState& state)
+{
+	if (query)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+	}
+
+	state.depthFunc(GL_LESS);
+	state.depthMask(true);
+	state.disable(GL_BLEND);
+}
+
+GLuint DepthPrepass::countFragments()
+{
+	GLuint samples = 0;
+	if (query)
+	{
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samples);
+	}
+	return samples;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "GLState.h"
+#include "GPUTimer.h"
+#include "RenderQueue.h"
+#include "Arena.h"
+
+using namespace std;
+
+//Pre-passo de profundidade: antes do passo principal os objetos sao desenhados da frente
+//para tras so com as posicoes (Mesh::drawDepth) e um vertex shader com as mesmas contas de
+//sprite.vs; o passo principal roda com GL_EQUAL e sem gravar profundidade, entao cada pixel
+//sombreia um unico fragmento. Tambem conta os fragmentos que o passo principal sombreia
+//(GL_SAMPLES_PASSED) e liga a visualizacao de sobreposicao de sprite.fs, com ou sem o pre-passo
+class DepthPrepass
+{
+public:
+	DepthPrepass() {}
+	~DepthPrepass() { destroy(); }
+	void create();
+	void destroy();
+	bool isCreated() { return depthShader != nullptr; }
+	void setEnabled(bool enabled) { this->enabled = enabled; }
+	bool isEnabled() { return enabled; }
+	void setOverdraw(bool overdraw) { this->overdraw = overdraw; }
+	bool getOverdraw() { return overdraw; }
+
+	//Desenha a profundidade da cena se o pre-passo estiver ligado; a fila vai no arena do
+	//quadro. Precisa do CurveBuffer ligado e troca o programa em uso
+	void render(GLState& state, Arena& frameArena, vector<Mesh>& objects, const glm::mat4& view, const glm::mat4& projection, float farPlane, float pathTime);
+	//Envolvem o passo principal: teste GL_EQUAL depois do pre-passo, blending aditivo na
+	//visualizacao e a contagem de fragmentos. O shader dos objetos precisa estar em uso
+	void beginMainPass(GLState& state, Shader* shader);
+	void endMainPass(GLState& state);
+
+	double getGPUTime() { return timer.getAverageTime(); }
+	int getNbDraws() { return nbDraws; }
+	//Fragmentos que passaram no teste de profundidade no ultimo passo principal (espera a GPU)
+	GLuint countFragments();
+
+protected:
+	unique_ptr<Shader> depthShader;
+	RenderQueue queue;
+	GLuint query = 0;
+	bool enabled = false, overdraw = false;
+	bool rendered = false; //o pre-passo do quadro gravou a profundidade
+	int nbDraws = 0;
+	GPUTimer timer;
+};
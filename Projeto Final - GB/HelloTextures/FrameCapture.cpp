@@ -0,0 +1,356 @@
+#include "FrameCapture.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "ImageWriter.h"
+
+bool FrameCapture::initialize(int width, int height, string directory, CaptureFormat format, string name, int fps, bool readback)
+{
+	this->width = width;
+	this->height = height;
+	this->format = format;
+	this->name = name;
+	this->fps = fps;
+	this->directory = directory;
+	nbWritten = nbCaptured = nbStalls = nbLost = 0;
+	bytesWritten = 0;
+	totalCaptureTime = maxCaptureTime = 0.0;
+	if (!this->directory.empty() && this->directory.back() != '/' && this->directory.back() != '\\')
+	{
+		this->directory += '/';
+	}
+
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+	struct stat info;
+	if (stat(directory.c_str(), &info) != 0 || !(info.st_mode & S_IFDIR))
+	{
+		cout << "Cannot create capture directory " << directory << endl;
+		return false;
+	}
+
+	//GIF e Y4M: o cabecalho sai agora e os quadros sao anexados em ordem
+	if (format == CAPTURE_GIF || format == CAPTURE_Y4M)
+	{
+		string path = this->directory + name + (format == CAPTURE_GIF ? ".gif" : ".y4m");
+		stream = fopen(path.c_str(), "wb");
+		if (!stream)
+		{
+			cout << "Cannot create " << path << endl;
+			return false;
+		}
+
+		vector<unsigned char> header;
+		if (format == CAPTURE_GIF)
+		{
+			encodeGIFHeader(width, height, header);
+		}
+		else
+		{
+			encodeY4MHeader(width, height, fps, header);
+		}
+		fwrite(header.data(), 1, header.size(), stream);
+		bytesWritten = header.size();
+	}
+
+	next = 0;
+	nbSubmitted = 0;
+	nextBlock = 0;
+
+	if (!readback)
+	{
+		for (int i = 0; i < NB_BUFFERS; i++)
+		{
+			slots[i].storage.resize((size_t)width * height * 4);
+			slots[i].pixels = slots[i].storage.data();
+			slots[i].state = SLOT_FREE;
+			slots[i].frame = slots[i].sequence = -1;
+		}
+		encoders.start();
+		active = true;
+		return true;
+	}
+
+	if (!glBufferStorage)
+	{
+		cout << "Frame capture requires OpenGL 4.4 buffer storage" << endl;
+		return false;
+	}
+
+	//Memoria de CPU (GL_CLIENT_STORAGE_BIT) mapeada para leitura enquanto o PBO existir;
+	//coerente, entao basta a fence para os pixels estarem visiveis
+	GLsizeiptr size = (GLsizeiptr)width * height * 4;
+	GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	for (int i = 0; i < NB_BUFFERS; i++)
+	{
+		glGenBuffers(1, &slots[i].buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].buffer);
+		glBufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+		slots[i].pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+		slots[i].fence = nullptr;
+		slots[i].state = SLOT_FREE;
+		slots[i].frame = slots[i].sequence = -1;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (!slots[0].pixels)
+	{
+		cout << "Cannot map capture buffers" << endl;
+		deleteResources();
+		return false;
+	}
+
+	encoders.start();
+	active = true;
+	return true;
+}
+
+string FrameCapture::getFramePath(int frame)
+{
+	char file[32];
+	snprintf(file, sizeof(file), "frame_%05d.%s", frame, format == CAPTURE_PNG ? "png" : "rgba");
+	return directory + file;
+}
+
+void FrameCapture::capture(GLState& state, int frame)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	//Despacha, do mais antigo ao mais novo, os quadros que a GPU ja terminou de copiar
+	for (int i = 0; i < NB_BUFFERS; i++)
+	{
+		Slot& slot = slots[(next + i) % NB_BUFFERS];
+		if (slot.state == SLOT_READING && !dispatch(slot, false))
+		{
+			break;
+		}
+	}
+
+	//So aqui a thread de renderizacao espera: pela GPU ou pelos codificadores
+	Slot& slot = slots[next];
+	if (slot.state == SLOT_READING)
+	{
+		nbStalls++;
+		if (!dispatch(slot, true))
+		{
+			drop(slot);
+		}
+	}
+	waitForSlot(slot);
+
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.state = SLOT_READING;
+	slot.frame = frame;
+	slot.sequence = nbSubmitted++;
+	next = (next + 1) % NB_BUFFERS;
+
+	double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	totalCaptureTime += elapsed;
+	maxCaptureTime = max(maxCaptureTime, elapsed);
+	nbCaptured++;
+}
+
+void FrameCapture::captureImage(const unsigned char* rgba, int frame)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	Slot& slot = slots[next];
+	waitForSlot(slot);
+	memcpy(slot.storage.data(), rgba, slot.storage.size());
+	slot.frame = frame;
+	slot.sequence = nbSubmitted++;
+	next = (next + 1) % NB_BUFFERS;
+	submitEncoding(slot);
+
+	double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	totalCaptureTime += elapsed;
+	maxCaptureTime = max(maxCaptureTime, elapsed);
+	nbCaptured++;
+}
+
+void FrameCapture::waitForSlot(Slot& slot)
+{
+	unique_lock<mutex> guard(lock);
+	if (slot.state != SLOT_FREE)
+	{
+		nbStalls++;
+		slotReleased.wait(guard, [&slot] { return slot.state == SLOT_FREE; });
+	}
+}
+
+bool FrameCapture::dispatch(Slot& slot, bool wait)
+{
+	//A primeira consulta tambem descarrega os comandos, senao a fence pode nunca sinalizar
+	GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ULL : 0);
+	if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+	{
+		return false;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+	submitEncoding(slot);
+	return true;
+}
+
+void FrameCapture::drop(Slot& slot)
+{
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+	cout << "Frame " << slot.frame << " did not arrive from the GPU and was dropped from the capture" << endl;
+
+	//Bloco vazio: a sequencia continua e nada e gravado no lugar do quadro
+	if (format == CAPTURE_GIF || format == CAPTURE_Y4M)
+	{
+		vector<unsigned char> empty;
+		append(slot.sequence, empty);
+	}
+
+	lock_guard<mutex> guard(lock);
+	nbLost++;
+	slot.state = SLOT_FREE;
+}
+
+void FrameCapture::submitEncoding(Slot& slot)
+{
+	slot.state = SLOT_ENCODING;
+
+	Slot* encoded = &slot;
+	encoders.submit([this, encoded] {
+		encode(encoded->pixels, encoded->frame, encoded->sequence);
+
+		lock_guard<mutex> guard(lock);
+		encoded->state = SLOT_FREE;
+		slotReleased.notify_all();
+	});
+}
+
+void FrameCapture::encode(const unsigned char* pixels, int frame, int sequence)
+{
+	//O OpenGL le de baixo para cima: comecando da ultima linha com passo negativo a imagem sai de pe
+	const unsigned char* top = pixels + (size_t)(height - 1) * width * 4;
+	vector<unsigned char> data;
+
+	if (format == CAPTURE_GIF || format == CAPTURE_Y4M)
+	{
+		if (format == CAPTURE_GIF)
+		{
+			//Centesimos de segundo, o mais perto possivel do fps
+			encodeGIFFrame(top, width, height, -width * 4, (100 + fps / 2) / fps, data);
+		}
+		else
+		{
+			encodeY4MFrame(top, width, height, -width * 4, data);
+		}
+		append(sequence, data);
+		return;
+	}
+
+	string path = getFramePath(frame);
+	bool written;
+	if (format == CAPTURE_PNG)
+	{
+		encodePNG(top, width, height, -width * 4, data);
+		FILE* file = fopen(path.c_str(), "wb");
+		written = file && fwrite(data.data(), 1, data.size(), file) == data.size();
+		written = file && fclose(file) == 0 && written;
+	}
+	else
+	{
+		written = writeRaw(path, top, width, height, -width * 4);
+	}
+
+	lock_guard<mutex> guard(lock);
+	if (written)
+	{
+		nbWritten++;
+		bytesWritten += format == CAPTURE_PNG ? data.size() : (size_t)width * height * 4;
+	}
+	else
+	{
+		cout << "Failed to write " << path << endl;
+	}
+}
+
+void FrameCapture::append(int sequence, vector<unsigned char>& data)
+{
+	lock_guard<mutex> guard(lock);
+	readyBlocks[sequence].swap(data);
+
+	//Quem completa a sequencia grava todos os blocos consecutivos que ja estao prontos
+	while (!readyBlocks.empty() && readyBlocks.begin()->first == nextBlock)
+	{
+		vector<unsigned char>& block = readyBlocks.begin()->second;
+		if (!block.empty())
+		{
+			fwrite(block.data(), 1, block.size(), stream);
+			bytesWritten += block.size();
+			nbWritten++;
+		}
+		readyBlocks.erase(readyBlocks.begin());
+		nextBlock++;
+	}
+}
+
+void FrameCapture::finish()
+{
+	for (int i = 0; i < NB_BUFFERS; i++)
+	{
+		Slot& slot = slots[(next + i) % NB_BUFFERS];
+		if (slot.state == SLOT_READING && !dispatch(slot, true))
+		{
+			drop(slot);
+		}
+	}
+	finishEncoding();
+}
+
+void FrameCapture::finishEncoding()
+{
+	encoders.stop();
+
+	if (stream)
+	{
+		if (format == CAPTURE_GIF)
+		{
+			fputc(GIF_TRAILER, stream);
+			bytesWritten++;
+		}
+		fclose(stream);
+		stream = nullptr;
+	}
+}
+
+void FrameCapture::deleteResources()
+{
+	for (int i = 0; i < NB_BUFFERS; i++)
+	{
+		if (slots[i].fence)
+		{
+			glDeleteSync(slots[i].fence);
+		}
+		if (slots[i].buffer)
+		{
+			//Apagar o buffer tambem desfaz o mapeamento persistente
+			glDeleteBuffers(1, &slots[i].buffer);
+		}
+		slots[i].buffer = 0;
+		slots[i].pixels = nullptr;
+		slots[i].storage = vector<unsigned char>();
+		slots[i].fence = nullptr;
+		slots[i].state = SLOT_FREE;
+	}
+	active = false;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+//PNG e raw geram um arquivo por quadro; GIF e Y4M, um arquivo para a captura inteira
+enum CaptureFormat { CAPTURE_PNG, CAPTURE_RAW, CAPTURE_GIF, CAPTURE_Y4M };
+
+//Grava os quadros do framebuffer corrente sem travar a thread de renderizacao. O
+//glReadPixels de cada quadro vai para um PBO de um anel de NB_BUFFERS, seguido de uma
+//fence. Os PBOs ficam mapeados o tempo todo (GL_MAP_PERSISTENT_BIT): quando a fence
+//sinaliza, um pool de threads codifica direto da memoria mapeada, sem copia na thread de
+//renderizacao. Ela so espera se o PBO da vez ainda estiver na GPU ou sendo codificado;
+//as duas esperas sao contadas em getNbStalls. Sem readback (imagens de CPU, como as do
+//SoftwareRenderer) os slots sao memoria comum e nao ha chamadas OpenGL
+class FrameCapture
+{
+public:
+	FrameCapture() {}
+	~FrameCapture() { finishEncoding(); }
+	//Cria os PBOs, o diretorio de saida e as threads de codificacao. name identifica os
+	//arquivos da captura (GIF e Y4M) e fps define o tempo de cada quadro neles
+	bool initialize(int width, int height, string directory, CaptureFormat format, string name = "capture", int fps = 60, bool readback = true);
+	//Enfileira a leitura do quadro e despacha os que ja chegaram da GPU
+	void capture(GLState& state, int frame);
+	//Sem readback: copia a imagem (RGBA8 de baixo para cima) e a envia para codificacao
+	void captureImage(const unsigned char* rgba, int frame);
+	//Le os PBOs restantes, espera a codificacao e fecha o arquivo da captura
+	void finish();
+	void deleteResources();
+	bool isActive() { return active; }
+
+	int getNbWritten() { return nbWritten; }
+	size_t getBytesWritten() { return bytesWritten; }
+	//Tempo da thread de renderizacao dentro de capture(), em ms
+	double getAverageCaptureTime() { return nbCaptured > 0 ? totalCaptureTime / nbCaptured : 0.0; }
+	double getMaxCaptureTime() { return maxCaptureTime; }
+	int getNbStalls() { return nbStalls; }
+	//Quadros cuja copia a GPU nao terminou a tempo (fence expirada ou com erro)
+	int getNbLost() { return nbLost; }
+
+	enum { NB_BUFFERS = 6 };
+
+protected:
+	enum SlotState { SLOT_FREE, SLOT_READING, SLOT_ENCODING };
+
+	struct Slot
+	{
+		GLuint buffer = 0;
+		const unsigned char* pixels = nullptr; //Mapeamento persistente do PBO
+		vector<unsigned char> storage; //Sem readback: copia do quadro
+		GLsync fence = nullptr;
+		atomic<int> state{ SLOT_FREE }; //SlotState; os codificadores o liberam ao terminar
+		int frame = -1, sequence = -1; //Numero do quadro e posicao na captura
+	};
+
+	//Envia o quadro para o pool quando a GPU terminou a copia; wait espera a fence
+	bool dispatch(Slot& slot, bool wait);
+	//Libera o slot de um quadro que nao chegou da GPU; GIF e Y4M pulam o bloco dele
+	void drop(Slot& slot);
+	//Espera os codificadores liberarem o slot
+	void waitForSlot(Slot& slot);
+	void submitEncoding(Slot& slot);
+	void encode(const unsigned char* pixels, int frame, int sequence);
+	//GIF e Y4M: grava os blocos prontos na ordem da captura
+	void append(int sequence, vector<unsigned char>& data);
+	void finishEncoding();
+	string getFramePath(int frame);
+
+	Slot slots[NB_BUFFERS];
+	int next = 0, nbSubmitted = 0;
+	int width = 0, height = 0, fps = 60;
+	string directory, name;
+	CaptureFormat format = CAPTURE_PNG;
+	bool active = false;
+
+	ThreadPool encoders;
+	mutex lock;
+	condition_variable slotReleased;
+	map<int, vector<unsigned char>> readyBlocks; //Codificados fora de ordem
+	int nextBlock = 0;
+	FILE* stream = nullptr;
+
+	int nbWritten = 0, nbCaptured = 0, nbStalls = 0, nbLost = 0;
+	size_t bytesWritten = 0;
+	double totalCaptureTime = 0.0, maxCaptureTime = 0.0;
+};
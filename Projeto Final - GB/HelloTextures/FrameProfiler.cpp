@@ -0,0 +1,501 @@
+#include "FrameProfiler.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+//Grafico, em pixels; encolhe em janelas menores
+static const int GRAPH_MARGIN = 10, GRAPH_HEIGHT = 100, BAR_WIDTH = 2, MAX_LINES = 6;
+static const float FRAME_INTERVAL = 1000.0f / 60.0f;
+//Fundo, linhas e barras sem trecho por baixo das barras dos trechos
+static const int GRAPH_QUADS = 2 * (1 + MAX_LINES + FrameProfiler::HISTORY * (1 + FrameProfiler::MAX_SCOPES));
+static const int FLOATS_PER_VERTEX = 5;
+
+static const float backgroundColor[3] = { 0.15f, 0.15f, 0.15f };
+static const float untrackedColor[3] = { 0.45f, 0.45f, 0.45f };
+static const float lineColor[3] = { 0.9f, 0.9f, 0.9f };
+static const int NB_COLORS = 12;
+static const float palette[NB_COLORS][3] = {
+	{ 0.9f, 0.2f, 0.2f }, { 1.0f, 0.6f, 0.1f }, { 0.95f, 0.9f, 0.2f }, { 0.3f, 0.8f, 0.3f },
+	{ 0.2f, 0.8f, 0.9f }, { 0.25f, 0.4f, 1.0f }, { 0.6f, 0.3f, 0.9f }, { 0.95f, 0.3f, 0.8f },
+	{ 0.6f, 0.4f, 0.2f }, { 0.5f, 0.6f, 0.1f }, { 0.1f, 0.5f, 0.5f }, { 1.0f, 0.7f, 0.75f } };
+static const char* const paletteNames[NB_COLORS] = { "red", "orange", "yellow", "green", "cyan", "blue",
+	"purple", "magenta", "brown", "olive", "teal", "pink" };
+
+void FrameProfiler::create(bool gpu)
+{
+	destroy();
+	origin = Clock::now();
+	gpuEnabled = gpu;
+	if (!gpu)
+	{
+		return;
+	}
+
+	for (int i = 0; i < NB_FRAMES; i++)
+	{
+		glGenQueries(2 * MAX_SAMPLES, queries[i]);
+	}
+
+	graphShader.reset(new Shader("../shaders/profiler.vs", "../shaders/profiler.fs"));
+	vertices.reserve(GRAPH_QUADS * 6 * FLOATS_PER_VERTEX);
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+	glGenBuffers(1, &vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, GRAPH_QUADS * 6 * FLOATS_PER_VERTEX * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (GLvoid*)(2 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+}
+
+void FrameProfiler::destroy()
+{
+	if (queries[0][0])
+	{
+		for (int i = 0; i < NB_FRAMES; i++)
+		{
+			glDeleteQueries(2 * MAX_SAMPLES, queries[i]);
+		}
+		memset(queries, 0, sizeof(queries));
+	}
+	if (vertexArray)
+	{
+		glDeleteVertexArrays(1, &vertexArray);
+		glDeleteBuffers(1, &vertexBuffer);
+		vertexArray = vertexBuffer = 0;
+	}
+	graphShader.reset();
+	gpuEnabled = false;
+	nbScopes = nbSamples = depth = nbIgnored = frame = 0;
+	slot = -1;
+	firstPending = nbPending = 0;
+	memset(cpuHistory, 0, sizeof(cpuHistory));
+	memset(gpuHistory, 0, sizeof(gpuHistory));
+	memset(frameTimes, 0, sizeof(frameTimes));
+	memset(gpuTotals, 0, sizeof(gpuTotals));
+	memset(gpuValid, 0, sizeof(gpuValid));
+	events.reset();
+	nbEvents = 0;
+}
+
+int FrameProfiler::findScope(const char* name, int depth)
+{
+	//Normalmente o mesmo literal; strcmp cobre literais repetidos em outra unidade de traducao
+	for (int i = 0; i < nbScopes; i++)
+	{
+		if (scopeNames[i] == name || strcmp(scopeNames[i], name) == 0)
+		{
+			return i;
+		}
+	}
+	if (nbScopes == MAX_SCOPES)
+	{
+		return -1;
+	}
+	scopeNames[nbScopes] = name;
+	scopeDepths[nbScopes] = depth;
+	scopeGpu[nbScopes] = false;
+	//Trecho novo no grafico: a legenda sai de novo no fim do quadro
+	legendPending = legendPending || (graph && depth == 0);
+	return nbScopes++;
+}
+
+void FrameProfiler::record(int frame, int scope, int depth, bool gpu, double start, double duration)
+{
+	if (!recording)
+	{
+		return;
+	}
+	Event* event = events.push<Event>();
+	if (event)
+	{
+		event->frame = frame;
+		event->scope = scope;
+		event->depth = depth;
+		event->gpu = gpu;
+		event->start = start;
+		event->duration = duration;
+		nbEvents++;
+	}
+}
+
+void FrameProfiler::beginFrame()
+{
+	nbSamples = depth = nbIgnored = 0;
+	lastQuery = 0;
+	slot = -1;
+	if (gpuEnabled)
+	{
+		poll(false);
+		if (nbPending < NB_FRAMES)
+		{
+			slot = (firstPending + nbPending) % NB_FRAMES;
+		}
+	}
+	frameStart = now();
+}
+
+void FrameProfiler::begin(const char* name, bool gpu)
+{
+	if (depth == MAX_DEPTH)
+	{
+		nbIgnored++;
+		return;
+	}
+
+	int scope = findScope(name, depth);
+	int index = -1;
+	if (scope >= 0 && nbSamples < MAX_SAMPLES)
+	{
+		index = nbSamples++;
+		Sample& sample = samples[index];
+		sample.scope = scope;
+		sample.depth = depth;
+		sample.gpu = gpu && slot >= 0;
+		if (sample.gpu)
+		{
+			scopeGpu[scope] = true;
+			glQueryCounter(queries[slot][2 * index], GL_TIMESTAMP);
+		}
+		sample.start = now();
+	}
+	stack[depth++] = index;
+}
+
+void FrameProfiler::end()
+{
+	if (nbIgnored > 0)
+	{
+		nbIgnored--;
+		return;
+	}
+	if (depth == 0)
+	{
+		return;
+	}
+
+	int index = stack[--depth];
+	if (index < 0)
+	{
+		return;
+	}
+	Sample& sample = samples[index];
+	sample.end = now();
+	if (sample.gpu)
+	{
+		lastQuery = queries[slot][2 * index + 1];
+		glQueryCounter(lastQuery, GL_TIMESTAMP);
+	}
+}
+
+void FrameProfiler::endFrame()
+{
+	//Trechos que ficaram abertos terminam com o quadro
+	while (depth > 0 || nbIgnored > 0)
+	{
+		end();
+	}
+	double frameEnd = now();
+
+	int row = frame % HISTORY;
+	memset(cpuHistory[row], 0, sizeof(cpuHistory[row]));
+	frameTimes[row] = (float)(frameEnd - frameStart);
+	gpuValid[row] = false;
+	record(frame, -1, 0, false, frameStart, frameEnd - frameStart);
+
+	bool gpuSamples = false;
+	for (int i = 0; i < nbSamples; i++)
+	{
+		Sample& sample = samples[i];
+		cpuHistory[row][sample.scope] += (float)(sample.end - sample.start);
+		record(frame, sample.scope, sample.depth + 1, false, sample.start, sample.end - sample.start);
+		gpuSamples = gpuSamples || sample.gpu;
+	}
+
+	if (slot >= 0 && gpuSamples)
+	{
+		PendingFrame& frameQueries = pending[slot];
+		memcpy(frameQueries.samples, samples, nbSamples * sizeof(Sample));
+		frameQueries.nbSamples = nbSamples;
+		frameQueries.frame = frame;
+		frameQueries.lastQuery = lastQuery;
+		nbPending++;
+	}
+	else if (slot >= 0)
+	{
+		memset(gpuHistory[row], 0, sizeof(gpuHistory[row]));
+		gpuTotals[row] = 0.0f;
+		gpuValid[row] = true;
+	}
+	frame++;
+
+	if (legendPending && graph && gpuEnabled)
+	{
+		legendPending = false;
+		cout << "Profiler graph: CPU above, GPU below, grey is time outside the scopes;";
+		for (int scope = 0; scope < nbScopes; scope++)
+		{
+			if (scopeDepths[scope] == 0)
+			{
+				cout << " " << scopeNames[scope] << " " << paletteNames[scope % NB_COLORS];
+			}
+		}
+		cout << endl;
+	}
+}
+
+void FrameProfiler::poll(bool wait)
+{
+	//Os quadros terminam na ordem de envio: para no primeiro ainda sem resultado
+	while (nbPending > 0)
+	{
+		PendingFrame& frameQueries = pending[firstPending];
+		if (!wait)
+		{
+			GLuint available = 0;
+			glGetQueryObjectuiv(frameQueries.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				break;
+			}
+		}
+
+		int row = frameQueries.frame % HISTORY;
+		bool inHistory = frame - frameQueries.frame < HISTORY;
+		if (inHistory)
+		{
+			memset(gpuHistory[row], 0, sizeof(gpuHistory[row]));
+			gpuTotals[row] = 0.0f;
+		}
+
+		//Os tempos da GPU vao para o eixo da CPU a partir do envio do primeiro trecho medido
+		const GLuint* frameQueryIds = queries[firstPending];
+		GLuint64 firstTimestamp = 0;
+		double firstStart = -1.0;
+		for (int i = 0; i < frameQueries.nbSamples; i++)
+		{
+			Sample& sample = frameQueries.samples[i];
+			if (!sample.gpu)
+			{
+				continue;
+			}
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(frameQueryIds[2 * i], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(frameQueryIds[2 * i + 1], GL_QUERY_RESULT, &end);
+			if (firstStart < 0.0)
+			{
+				firstTimestamp = start;
+				firstStart = sample.start;
+			}
+			double duration = end > start ? (end - start) * 1e-6 : 0.0;
+			if (inHistory)
+			{
+				gpuHistory[row][sample.scope] += (float)duration;
+				if (sample.depth == 0)
+				{
+					gpuTotals[row] += (float)duration;
+				}
+			}
+			double offset = start > firstTimestamp ? (start - firstTimestamp) * 1e-6 : 0.0;
+			record(frameQueries.frame, sample.scope, sample.depth + 1, true, firstStart + offset, duration);
+		}
+		if (inHistory)
+		{
+			gpuValid[row] = true;
+		}
+
+		firstPending = (firstPending + 1) % NB_FRAMES;
+		nbPending--;
+	}
+}
+
+bool FrameProfiler::write(const string& path)
+{
+	if (gpuEnabled)
+	{
+		poll(true);
+	}
+
+	ofstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+
+	const Event* list = (const Event*)events.getBase();
+	bool trace = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+	if (trace)
+	{
+		//Eventos completos (ph X) em microssegundos; a CPU e a GPU aparecem como duas threads.
+		//Ponto fixo com 3 casas (ns): com 6 digitos significativos os tempos de uma gravacao longa
+		//seriam arredondados para 0,1 ms e trechos aninhados curtos sairiam do trecho pai
+		file << fixed << setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+		for (size_t i = 0; i < nbEvents; i++)
+		{
+			const Event& event = list[i];
+			file << ",\n{\"name\":\"" << (event.scope < 0 ? "frame" : scopeNames[event.scope]) << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.gpu ? 2 : 1) << ",\"ts\":" << event.start * 1e3 << ",\"dur\":" << event.duration * 1e3
+				<< ",\"args\":{\"frame\":" << event.frame << "}}";
+		}
+		file << "\n]}\n";
+	}
+	else
+	{
+		//Em ms com 6 casas (ns), pelo mesmo motivo
+		file << fixed << setprecision(6);
+		file << "frame,track,scope,depth,start_ms,duration_ms\n";
+		for (size_t i = 0; i < nbEvents; i++)
+		{
+			const Event& event = list[i];
+			file << event.frame << "," << (event.gpu ? "gpu" : "cpu") << "," << (event.scope < 0 ? "frame" : scopeNames[event.scope]) << ","
+				<< event.depth << "," << event.start << "," << event.duration << "\n";
+		}
+	}
+	return file.good();
+}
+
+void FrameProfiler::report()
+{
+	if (gpuEnabled)
+	{
+		poll(true);
+	}
+	int nbFrames = min(frame, (int)HISTORY);
+	if (nbFrames == 0)
+	{
+		return;
+	}
+
+	double frameTotal = 0.0;
+	int nbGPUFrames = 0;
+	for (int i = 0; i < nbFrames; i++)
+	{
+		int row = (frame - 1 - i) % HISTORY;
+		frameTotal += frameTimes[row];
+		nbGPUFrames += gpuValid[row] ? 1 : 0;
+	}
+	cout << "Frame profile, average of the last " << nbFrames << " frames: " << frameTotal / nbFrames << " ms CPU" << endl;
+
+	for (int scope = 0; scope < nbScopes; scope++)
+	{
+		double cpuTotal = 0.0, gpuTotal = 0.0;
+		for (int i = 0; i < nbFrames; i++)
+		{
+			int row = (frame - 1 - i) % HISTORY;
+			cpuTotal += cpuHistory[row][scope];
+			gpuTotal += gpuValid[row] ? gpuHistory[row][scope] : 0.0f;
+		}
+		cout << string(2 * (scopeDepths[scope] + 1), ' ') << scopeNames[scope] << ": " << cpuTotal / nbFrames << " ms CPU";
+		if (scopeGpu[scope] && nbGPUFrames > 0)
+		{
+			cout << ", " << gpuTotal / nbGPUFrames << " ms GPU";
+		}
+		cout << endl;
+	}
+}
+
+void FrameProfiler::setGraph(bool graph)
+{
+	this->graph = graph;
+	legendPending = graph;
+}
+
+void FrameProfiler::pushQuad(float x0, float y0, float x1, float y1, const float* color)
+{
+	const float corners[6][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y0 }, { x1, y1 }, { x0, y1 } };
+	for (int i = 0; i < 6; i++)
+	{
+		vertices.push_back(corners[i][0]);
+		vertices.push_back(corners[i][1]);
+		vertices.push_back(color[0]);
+		vertices.push_back(color[1]);
+		vertices.push_back(color[2]);
+	}
+}
+
+void FrameProfiler::drawBars(float x, float y, float width, float height, const float history[][MAX_SCOPES], const float* totals, const bool* valid)
+{
+	//Escala em multiplos de um quadro a 60 Hz, com no maximo MAX_LINES linhas
+	float maxTime = 0.0f;
+	for (int i = 0; i < HISTORY; i++)
+	{
+		int f = frame - HISTORY + i;
+		if (f >= 0 && (!valid || valid[f % HISTORY]))
+		{
+			maxTime = max(maxTime, totals[f % HISTORY]);
+		}
+	}
+	float interval = FRAME_INTERVAL;
+	int nbLines = max(1, (int)ceil(maxTime / interval));
+	if (nbLines > MAX_LINES)
+	{
+		interval *= ceil(nbLines / (float)MAX_LINES);
+		nbLines = max(1, (int)ceil(maxTime / interval));
+	}
+	float scale = height / (nbLines * interval);
+	float barWidth = width / HISTORY;
+
+	pushQuad(x, y, x + width, y + height, backgroundColor);
+	for (int i = 0; i < HISTORY; i++)
+	{
+		int f = frame - HISTORY + i;
+		if (f < 0 || (valid && !valid[f % HISTORY]))
+		{
+			continue;
+		}
+		int row = f % HISTORY;
+		float x0 = x + i * barWidth, x1 = x0 + barWidth;
+		//O quadro inteiro por baixo: o que sobra acima dos trechos e tempo fora deles
+		pushQuad(x0, y, x1, y + totals[row] * scale, untrackedColor);
+		float top = y;
+		for (int scope = 0; scope < nbScopes; scope++)
+		{
+			float time = history[row][scope];
+			if (scopeDepths[scope] == 0 && time > 0.0f)
+			{
+				pushQuad(x0, top, x1, top + time * scale, palette[scope % NB_COLORS]);
+				top += time * scale;
+			}
+		}
+	}
+	for (int i = 1; i <= nbLines; i++)
+	{
+		float lineY = y + i * interval * scale;
+		pushQuad(x, lineY - 1.0f, x + width, lineY, lineColor);
+	}
+}
+
+void FrameProfiler::drawGraph(GLState& state, int viewportWidth, int viewportHeight)
+{
+	if (!graph || !graphShader)
+	{
+		return;
+	}
+	float width = (float)min(HISTORY * BAR_WIDTH, viewportWidth - 2 * GRAPH_MARGIN);
+	float height = (float)min(GRAPH_HEIGHT, (viewportHeight - 3 * GRAPH_MARGIN) / 2);
+	if (width <= 0.0f || height <= 0.0f)
+	{
+		return;
+	}
+	vertices.clear();
+	drawBars(GRAPH_MARGIN, 2 * GRAPH_MARGIN + height, width, height, cpuHistory, frameTimes, nullptr);
+	drawBars(GRAPH_MARGIN, GRAPH_MARGIN, width, height, gpuHistory, gpuTotals, gpuValid);
+
+	state.useProgram(graphShader->ID);
+	glUniform2f(glGetUniformLocation(graphShader->ID, "viewportSize"), (float)viewportWidth, (float)viewportHeight);
+	state.bindVertexArray(vertexArray);
+	state.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+	state.disable(GL_DEPTH_TEST);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / FLOATS_PER_VERTEX));
+	state.enable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <string>
+
+#include "Shader.h"
+#include "GLState.h"
+#include "Arena.h"
+
+using namespace std;
+
+//Perfil do quadro em trechos nomeados. Cada trecho mede o tempo de CPU com o relogio de alta
+//resolucao e, se pedido, o de GPU com um par de consultas GL_TIMESTAMP: ao contrario das
+//GL_TIME_ELAPSED elas podem se aninhar e conviver com os GPUTimer dos passos. As consultas de
+//um quadro ficam em um anel de NB_FRAMES quadros e sao lidas quando o driver ja tem o
+//resultado, alguns quadros depois, sem bloquear a CPU; se o anel estiver cheio o quadro so
+//tem tempos de CPU. Os ultimos HISTORY quadros alimentam o grafico e as medias; a gravacao
+//guarda todos os quadros para exportar em CSV ou no formato de trace do Chrome
+class FrameProfiler
+{
+public:
+	FrameProfiler() {}
+	~FrameProfiler() { destroy(); }
+	//gpu: cria as consultas e o grafico; sem contexto OpenGL so mede a CPU
+	void create(bool gpu);
+	void destroy();
+
+	void beginFrame();
+	void endFrame();
+	//Trechos aninhados dentro do quadro. name deve durar o programa todo (um literal): o
+	//ponteiro identifica o trecho de um quadro para o outro
+	void begin(const char* name, bool gpu = false);
+	void end();
+
+	//Guarda os trechos de todos os quadros seguintes, no arena de eventos
+	void setRecording(bool recording) { this->recording = recording; }
+	//Espera os resultados pendentes e grava a gravacao: trace do Chrome (chrome://tracing ou
+	//Perfetto) se o arquivo terminar em .json, senao CSV
+	bool write(const string& path);
+	//Medias dos ultimos quadros, em ms por quadro, no console
+	void report();
+
+	void setGraph(bool graph);
+	bool getGraph() { return graph; }
+	//Grafico no canto inferior esquerdo do framebuffer de desenho: uma barra por quadro com
+	//os trechos de primeiro nivel empilhados, CPU em cima e GPU embaixo, linhas a cada 16,7 ms
+	//(ou multiplos). A legenda de cores vai para o console no fim do quadro em que o grafico e
+	//ligado ou aparece um trecho novo
+	void drawGraph(GLState& state, int viewportWidth, int viewportHeight);
+
+	enum { MAX_SCOPES = 32, MAX_SAMPLES = 64, MAX_DEPTH = 8, NB_FRAMES = 4, HISTORY = 240 };
+
+protected:
+	typedef chrono::high_resolution_clock Clock;
+
+	//Trecho medido em um quadro, em ms desde o create
+	struct Sample
+	{
+		short scope, depth;
+		bool gpu;
+		double start, end;
+	};
+	//Quadro com consultas de GPU ainda nao lidas
+	struct PendingFrame
+	{
+		Sample samples[MAX_SAMPLES];
+		int nbSamples = 0;
+		int frame = 0;
+		GLuint lastQuery = 0; //a ultima consulta enviada; as anteriores terminam antes dela
+	};
+	//Trecho gravado para a exportacao; scope -1 e o quadro inteiro
+	struct Event
+	{
+		int frame;
+		short scope, depth;
+		bool gpu;
+		double start, duration;
+	};
+
+	double now() { return chrono::duration<double, milli>(Clock::now() - origin).count(); }
+	int findScope(const char* name, int depth);
+	void record(int frame, int scope, int depth, bool gpu, double start, double duration);
+	//Le os quadros cujas consultas terminaram, em ordem; wait espera por todos
+	void poll(bool wait);
+	void pushQuad(float x0, float y0, float x1, float y1, const float* color);
+	void drawBars(float x, float y, float width, float height, const float history[][MAX_SCOPES], const float* totals, const bool* valid);
+
+	Clock::time_point origin;
+	const char* scopeNames[MAX_SCOPES] = {};
+	short scopeDepths[MAX_SCOPES] = {};
+	bool scopeGpu[MAX_SCOPES] = {};
+	int nbScopes = 0;
+
+	//Quadro atual
+	Sample samples[MAX_SAMPLES];
+	int nbSamples = 0;
+	int stack[MAX_DEPTH]; //amostra de cada nivel aberto, -1 se nao coube
+	int depth = 0;
+	int nbIgnored = 0; //begin alem de MAX_DEPTH, sem amostra nem nivel
+	double frameStart = 0.0;
+	int frame = 0;
+	int slot = -1; //quadro do anel que recebe as consultas, -1 sem GPU
+	GLuint lastQuery = 0;
+
+	//Anel de consultas: 2 por amostra em cada quadro
+	bool gpuEnabled = false;
+	GLuint queries[NB_FRAMES][2 * MAX_SAMPLES] = {};
+	PendingFrame pending[NB_FRAMES];
+	int firstPending = 0, nbPending = 0;
+
+	//Historico circular por quadro e trecho, em ms
+	float cpuHistory[HISTORY][MAX_SCOPES] = {};
+	float gpuHistory[HISTORY][MAX_SCOPES] = {};
+	float frameTimes[HISTORY] = {};
+	float gpuTotals[HISTORY] = {};
+	bool gpuValid[HISTORY] = {};
+
+	bool recording = false;
+	Arena events;
+	size_t nbEvents = 0;
+
+	bool graph = false, legendPending = false;
+	unique_ptr<Shader> graphShader;
+	GLuint vertexArray = 0, vertexBuffer = 0;
+	vector<float> vertices; //x, y, r, g, b; capacidade reservada no create
+};
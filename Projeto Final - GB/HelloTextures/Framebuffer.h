@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GLExtensions.h"
+
+//Framebuffer fora da tela com cor RGBA8 (textura) e profundidade de 24 bits
+class Framebuffer
+{
+public:
+	Framebuffer() {}
+	~Framebuffer() { destroy(); }
+	//Retorna false se o driver nao aceitar a combinacao de anexos
+	bool create(int width, int height);
+	void destroy();
+	//Liga para desenho e leitura e ajusta o viewport
+	void bind();
+	//Troca a cor por uma imagem RGBA8 de baixo para cima, como a do SoftwareRenderer
+	void upload(const unsigned char* rgba);
+	//Copia a cor para o framebuffer da janela, esticando se o tamanho for diferente
+	void present(int windowWidth, int windowHeight);
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+
+protected:
+	GLuint framebuffer = 0, color = 0, depth = 0;
+	int width = 0, height = 0;
+};
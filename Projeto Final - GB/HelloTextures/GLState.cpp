@@ -0,0 +1,402 @@
+#include "GLState.h"
+
+#include <iostream>
+
+using namespace std;
+
+//Capacidades acompanhadas; as demais passam direto para o driver
+static const GLenum trackedCapabilities[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST,
+	GL_STENCIL_TEST, GL_POLYGON_OFFSET_FILL, GL_FRAMEBUFFER_SRGB, GL_PROGRAM_POINT_SIZE };
+
+static const GLenum bufferTargets[] = { GL_ARRAY_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER,
+	GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER };
+
+static const GLenum bufferBindings[] = { GL_ARRAY_BUFFER_BINDING, GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING,
+	GL_UNIFORM_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_BINDING };
+
+static GLint getInteger(GLenum name)
+{
+	GLint value = 0;
+	glGetIntegerv(name, &value);
+	return value;
+}
+
+int GLState::getBufferSlot(GLenum target)
+{
+	for (int i = 0; i < NB_BUFFER_TARGETS; i++)
+	{
+		if (bufferTargets[i] == target)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+int GLState::getCapabilitySlot(GLenum capability)
+{
+	for (int i = 0; i < NB_CAPABILITIES; i++)
+	{
+		if (trackedCapabilities[i] == capability)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool GLState::check(const char* name, GLuint shadow, GLint actual)
+{
+	if (shadow == UNKNOWN || shadow == (GLuint)actual)
+	{
+		return true;
+	}
+
+	cout << "GLState mismatch: " << name << " is " << actual << ", shadow has " << shadow << endl;
+	return false;
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (this->program == program)
+	{
+		nbSkipped++;
+		if (validation)
+		{
+			check("program", program, getInteger(GL_CURRENT_PROGRAM));
+		}
+		return;
+	}
+
+	glUseProgram(program);
+	this->program = program;
+	nbCalls++;
+}
+
+void GLState::bindVertexArray(GLuint vertexArray)
+{
+	if (this->vertexArray == vertexArray)
+	{
+		nbSkipped++;
+		if (validation)
+		{
+			check("vertex array", vertexArray, getInteger(GL_VERTEX_ARRAY_BINDING));
+		}
+		return;
+	}
+
+	glBindVertexArray(vertexArray);
+	this->vertexArray = vertexArray;
+	nbCalls++;
+}
+
+//Uma textura por unidade; o alvo e guardado apenas para a validacao
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	if (textures[unit] == texture && textureTargets[unit] == target)
+	{
+		nbSkipped++;
+		return;
+	}
+
+	if (activeTexture != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		activeTexture = unit;
+		nbCalls++;
+	}
+
+	glBindTexture(target, texture);
+	textures[unit] = texture;
+	textureTargets[unit] = target;
+	nbCalls++;
+}
+
+void GLState::deleteTexture(GLuint texture)
+{
+	glDeleteTextures(1, &texture);
+	nbCalls++;
+
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		if (textures[i] == texture)
+		{
+			textures[i] = 0;
+		}
+	}
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	int slot = getBufferSlot(target);
+
+	if (slot >= 0 && buffers[slot] == buffer)
+	{
+		nbSkipped++;
+		if (validation)
+		{
+			check("buffer binding", buffer, getInteger(bufferBindings[slot]));
+		}
+		return;
+	}
+
+	glBindBuffer(target, buffer);
+	if (slot >= 0)
+	{
+		buffers[slot] = buffer;
+	}
+	nbCalls++;
+}
+
+//glBindBufferBase tambem muda o bind generico do alvo
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	int slot = getBufferSlot(target);
+	GLuint* indexed = nullptr;
+
+	if ((slot == UNIFORM || slot == SHADER_STORAGE) && index < MAX_BUFFER_INDICES)
+	{
+		indexed = &indexedBuffers[slot - UNIFORM][index];
+	}
+
+	if (indexed && *indexed == buffer)
+	{
+		nbSkipped++;
+		if (validation)
+		{
+			GLint actual = 0;
+			glGetIntegeri_v(bufferBindings[slot], index, &actual);
+			check("indexed buffer binding", buffer, actual);
+		}
+		return;
+	}
+
+	glBindBufferBase(target, index, buffer);
+	if (indexed)
+	{
+		*indexed = buffer;
+	}
+	if (slot >= 0)
+	{
+		buffers[slot] = buffer;
+	}
+	nbCalls++;
+}
+
+void GLState::setCapability(GLenum capability, bool enabled)
+{
+	int slot = getCapabilitySlot(capability);
+
+	if (slot >= 0 && capabilities[slot] == (GLuint)enabled)
+	{
+		nbSkipped++;
+		if (validation)
+		{
+			check("capability", enabled, glIsEnabled(capability));
+		}
+		return;
+	}
+
+	if (enabled)
+	{
+		glEnable(capability);
+	}
+	else
+	{
+		glDisable(capability);
+	}
+
+	if (slot >= 0)
+	{
+		capabilities[slot] = enabled;
+	}
+	nbCalls++;
+}
+
+void GLState::enable(GLenum capability)
+{
+	setCapability(capability, true);
+}
+
+void GLState::disable(GLenum capability)
+{
+	setCapability(capability, false);
+}
+
+void GLState::depthFunc(GLenum function)
+{
+	if (depthFunction == function)
+	{
+		nbSkipped++;
+		return;
+	}
+
+	glDepthFunc(function);
+	depthFunction = function;
+	nbCalls++;
+}
+
+void GLState::depthMask(bool mask)
+{
+	if (depthWrite == (GLuint)mask)
+	{
+		nbSkipped++;
+		return;
+	}
+
+	glDepthMask(mask ? GL_TRUE : GL_FALSE);
+	depthWrite = mask;
+	nbCalls++;
+}
+
+void GLState::colorMask(bool mask)
+{
+	if (colorWrite == (GLuint)mask)
+	{
+		nbSkipped++;
+		return;
+	}
+
+	GLboolean value = mask ? GL_TRUE : GL_FALSE;
+	glColorMask(value, value, value, value);
+	colorWrite = mask;
+	nbCalls++;
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination)
+{
+	if (blendSource == source && blendDestination == destination)
+	{
+		nbSkipped++;
+		return;
+	}
+
+	glBlendFunc(source, destination);
+	blendSource = source;
+	blendDestination = destination;
+	nbCalls++;
+}
+
+void GLState::lineWidth(float width)
+{
+	if (currentLineWidth == width)
+	{
+		nbSkipped++;
+		return;
+	}
+
+	glLineWidth(width);
+	currentLineWidth = width;
+	nbCalls++;
+}
+
+void GLState::pointSize(float size)
+{
+	if (currentPointSize == size)
+	{
+		nbSkipped++;
+		return;
+	}
+
+	glPointSize(size);
+	currentPointSize = size;
+	nbCalls++;
+}
+
+void GLState::invalidate()
+{
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	activeTexture = UNKNOWN;
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		textures[i] = UNKNOWN;
+		textureTargets[i] = GL_TEXTURE_2D;
+	}
+	for (int i = 0; i < NB_BUFFER_TARGETS; i++)
+	{
+		buffers[i] = UNKNOWN;
+	}
+	for (int i = 0; i < MAX_BUFFER_INDICES; i++)
+	{
+		indexedBuffers[0][i] = UNKNOWN;
+		indexedBuffers[1][i] = UNKNOWN;
+	}
+	for (int i = 0; i < NB_CAPABILITIES; i++)
+	{
+		capabilities[i] = UNKNOWN;
+	}
+	depthFunction = UNKNOWN;
+	depthWrite = UNKNOWN;
+	colorWrite = UNKNOWN;
+	blendSource = UNKNOWN;
+	blendDestination = UNKNOWN;
+	currentLineWidth = -1.0f;
+	currentPointSize = -1.0f;
+}
+
+bool GLState::verify()
+{
+	bool ok = check("program", program, getInteger(GL_CURRENT_PROGRAM));
+	ok = check("vertex array", vertexArray, getInteger(GL_VERTEX_ARRAY_BINDING)) && ok;
+	ok = check("depth function", depthFunction, getInteger(GL_DEPTH_FUNC)) && ok;
+	ok = check("depth mask", depthWrite, getInteger(GL_DEPTH_WRITEMASK)) && ok;
+	ok = check("blend source", blendSource, getInteger(GL_BLEND_SRC_RGB)) && ok;
+	ok = check("blend source", blendSource, getInteger(GL_BLEND_SRC_ALPHA)) && ok;
+	ok = check("blend destination", blendDestination, getInteger(GL_BLEND_DST_RGB)) && ok;
+	ok = check("blend destination", blendDestination, getInteger(GL_BLEND_DST_ALPHA)) && ok;
+
+	//2 se os canais estiverem diferentes entre si, o que colorMask nunca faz
+	GLboolean colorMask[4];
+	glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+	int nbWritten = colorMask[0] + colorMask[1] + colorMask[2] + colorMask[3];
+	ok = check("color mask", colorWrite, nbWritten == 4 ? 1 : (nbWritten == 0 ? 0 : 2)) && ok;
+
+	for (int i = 0; i < NB_BUFFER_TARGETS; i++)
+	{
+		ok = check("buffer binding", buffers[i], getInteger(bufferBindings[i])) && ok;
+	}
+
+	for (int i = 0; i < NB_CAPABILITIES; i++)
+	{
+		ok = check("capability", capabilities[i], glIsEnabled(trackedCapabilities[i])) && ok;
+	}
+
+	for (int k = 0; k < 2; k++)
+	{
+		for (GLuint i = 0; i < MAX_BUFFER_INDICES; i++)
+		{
+			if (indexedBuffers[k][i] != UNKNOWN)
+			{
+				GLint actual = 0;
+				glGetIntegeri_v(bufferBindings[UNIFORM + k], i, &actual);
+				ok = check("indexed buffer binding", indexedBuffers[k][i], actual) && ok;
+			}
+		}
+	}
+
+	//A consulta de textura depende da unidade ativa, que e restaurada no final
+	GLint active = getInteger(GL_ACTIVE_TEXTURE);
+	ok = check("active texture", activeTexture == UNKNOWN ? UNKNOWN : GL_TEXTURE0 + activeTexture, active) && ok;
+	for (GLuint i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		if (textures[i] != UNKNOWN)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			GLenum binding = textureTargets[i] == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D;
+			ok = check("texture binding", textures[i], getInteger(binding)) && ok;
+		}
+	}
+	glActiveTexture(active);
+
+	GLfloat width = 0.0f, size = 0.0f;
+	glGetFloatv(GL_LINE_WIDTH, &width);
+	glGetFloatv(GL_POINT_SIZE, &size);
+	if ((currentLineWidth >= 0.0f && currentLineWidth != width) || (currentPointSize >= 0.0f && currentPointSize != size))
+	{
+		cout << "GLState mismatch: line width/point size" << endl;
+		ok = false;
+	}
+
+	return ok;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "GLExtensions.h"
+
+//Copia do estado do OpenGL mantida na CPU: chamadas que nao mudam nada nao chegam ao driver.
+//Binds feitos por fora desta classe (carga de recursos, edicao de curvas) devem ser
+//seguidos de invalidate(). Com a validacao ligada, cada chamada pulada e o estado inteiro
+//ao final do quadro (verify) sao comparados com glGet*
+class GLState
+{
+public:
+	GLState() { invalidate(); }
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vertexArray);
+	void bindTexture(GLuint unit, GLenum target, GLuint texture);
+	//Apaga a textura e, como o driver, desfaz os binds dela nas unidades
+	void deleteTexture(GLuint texture);
+	void bindBuffer(GLenum target, GLuint buffer);
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	void enable(GLenum capability);
+	void disable(GLenum capability);
+	void depthFunc(GLenum function);
+	void depthMask(bool mask);
+	//Os quatro canais juntos
+	void colorMask(bool mask);
+	//Mesmos fatores para a cor e o alfa
+	void blendFunc(GLenum source, GLenum destination);
+	void lineWidth(float width);
+	void pointSize(float size);
+	//Esquece o estado conhecido; o proximo bind de cada tipo sempre e enviado
+	void invalidate();
+
+	void setValidation(bool validation) { this->validation = validation; }
+	//Retorna false e imprime as diferencas se a copia nao bate com o driver
+	bool verify();
+
+	int getNbCalls() { return nbCalls; }
+	int getNbSkipped() { return nbSkipped; }
+	void resetCounters() { nbCalls = 0; nbSkipped = 0; }
+
+protected:
+	static const GLuint UNKNOWN = 0xFFFFFFFF;
+	static const int MAX_TEXTURE_UNITS = 16;
+	static const int MAX_BUFFER_INDICES = 16;
+	enum { ARRAY, PIXEL_PACK, PIXEL_UNPACK, UNIFORM, SHADER_STORAGE, NB_BUFFER_TARGETS };
+	enum { NB_CAPABILITIES = 8 };
+
+	static int getBufferSlot(GLenum target);
+	static int getCapabilitySlot(GLenum capability);
+	void setCapability(GLenum capability, bool enabled);
+	bool check(const char* name, GLuint shadow, GLint actual);
+
+	GLuint program, vertexArray, activeTexture;
+	GLuint textures[MAX_TEXTURE_UNITS];
+	GLenum textureTargets[MAX_TEXTURE_UNITS];
+	GLuint buffers[NB_BUFFER_TARGETS];
+	GLuint indexedBuffers[2][MAX_BUFFER_INDICES]; //UNIFORM e SHADER_STORAGE
+	GLuint capabilities[NB_CAPABILITIES];
+	GLuint depthFunction, depthWrite;
+	GLuint colorWrite;
+	GLenum blendSource, blendDestination;
+	float currentLineWidth, currentPointSize;
+
+	bool validation = false;
+	int nbCalls = 0, nbSkipped = 0;
+};
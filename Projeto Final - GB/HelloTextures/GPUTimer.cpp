@@ -0,0 +1,71 @@
+#include "GPUTimer.h"
+
+//Peso de cada resultado novo na media
+static const double AVERAGE_WEIGHT = 0.1;
+
+void GPUTimer::create()
+{
+	destroy();
+	glGenQueries(NB_QUERIES, queries);
+}
+
+void GPUTimer::destroy()
+{
+	if (queries[0])
+	{
+		glDeleteQueries(NB_QUERIES, queries);
+		for (int i = 0; i < NB_QUERIES; i++)
+		{
+			queries[i] = 0;
+		}
+	}
+	first = nbPending = 0;
+	measuring = false;
+	lastTime = averageTime = 0.0;
+	nbResults = 0;
+}
+
+void GPUTimer::begin()
+{
+	measuring = queries[0] && nbPending < NB_QUERIES;
+	if (measuring)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, queries[(first + nbPending) % NB_QUERIES]);
+	}
+}
+
+void GPUTimer::end()
+{
+	if (measuring)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		nbPending++;
+		measuring = false;
+	}
+}
+
+bool GPUTimer::poll()
+{
+	bool updated = false;
+	//Os resultados chegam na ordem de envio: para na primeira consulta ainda sem resultado
+	while (nbPending > 0)
+	{
+		GLuint available = 0;
+		glGetQueryObjectuiv(queries[first], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[first], GL_QUERY_RESULT, &elapsed);
+		lastTime = elapsed * 1e-6;
+		averageTime = nbResults == 0 ? lastTime : averageTime + (lastTime - averageTime) * AVERAGE_WEIGHT;
+		nbResults++;
+		updated = true;
+
+		first = (first + 1) % NB_QUERIES;
+		nbPending--;
+	}
+	return updated;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "GLExtensions.h"
+
+//Tempo de GPU de um trecho do quadro com consultas GL_TIME_ELAPSED. As consultas ficam em
+//um anel de NB_QUERIES e cada resultado so e lido quando o driver ja o tem, alguns quadros
+//depois, sem bloquear a CPU; se o anel estiver cheio o quadro nao e medido
+class GPUTimer
+{
+public:
+	GPUTimer() {}
+	~GPUTimer() { destroy(); }
+	void create();
+	void destroy();
+	//Envolvem os comandos medidos; nao podem se sobrepor a outra consulta GL_TIME_ELAPSED
+	void begin();
+	void end();
+	//Recolhe os resultados prontos; retorna true se chegou algum novo
+	bool poll();
+	//Em ms: o ultimo resultado lido e a media movel exponencial dos resultados
+	double getLastTime() { return lastTime; }
+	double getAverageTime() { return averageTime; }
+	int getNbResults() { return nbResults; }
+
+	enum { NB_QUERIES = 4 };
+
+protected:
+	GLuint queries[NB_QUERIES] = {};
+	int first = 0, nbPending = 0; //consultas enviadas e ainda nao lidas, a partir de first
+	bool measuring = false;
+	double lastTime = 0.0, averageTime = 0.0;
+	int nbResults = 0;
+};
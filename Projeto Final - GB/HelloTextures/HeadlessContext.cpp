@@ -0,0 +1,138 @@
+#include "HeadlessContext.h"
+
+#include <GLFW/glfw3.h>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+bool HeadlessContext::create(int major, int minor)
+{
+	destroy();
+
+	if (createEGL(major, minor))
+	{
+		return true;
+	}
+
+	if (!glfwInit())
+	{
+		return false;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	GLFWwindow* hidden = glfwCreateWindow(16, 16, "", nullptr, nullptr);
+	if (!hidden)
+	{
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(hidden);
+	window = hidden;
+	return true;
+}
+
+#ifdef __linux__
+
+bool HeadlessContext::createEGL(int major, int minor)
+{
+	//O display surfaceless nao precisa de X nem de DRM; sem a extensao, tenta o display padrao
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+	{
+		eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (eglDisplay == EGL_NO_DISPLAY)
+	{
+		eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint eglMajor, eglMinor;
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor))
+	{
+		return false;
+	}
+
+	EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = nullptr;
+	EGLint nbConfigs = 0;
+	eglChooseConfig(eglDisplay, configAttributes, &config, 1, &nbConfigs);
+
+	EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, major, EGL_CONTEXT_MINOR_VERSION, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+	EGLContext eglContext = EGL_NO_CONTEXT;
+	if (eglBindAPI(EGL_OPENGL_API))
+	{
+		//Sem config compativel o contexto ainda pode ser criado com EGL_KHR_no_config_context
+		eglContext = eglCreateContext(eglDisplay, nbConfigs > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+	}
+
+	if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+	{
+		if (eglContext != EGL_NO_CONTEXT)
+		{
+			eglDestroyContext(eglDisplay, eglContext);
+		}
+		eglTerminate(eglDisplay);
+		return false;
+	}
+
+	display = eglDisplay;
+	context = eglContext;
+	return true;
+}
+
+void HeadlessContext::destroy()
+{
+	if (display)
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+		eglTerminate(display);
+		display = nullptr;
+		context = nullptr;
+	}
+	if (window)
+	{
+		glfwDestroyWindow((GLFWwindow*)window);
+		glfwTerminate();
+		window = nullptr;
+	}
+}
+
+GLADloadproc HeadlessContext::getLoader()
+{
+	return display ? (GLADloadproc)eglGetProcAddress : (GLADloadproc)glfwGetProcAddress;
+}
+
+#else
+
+bool HeadlessContext::createEGL(int major, int minor)
+{
+	return false;
+}
+
+void HeadlessContext::destroy()
+{
+	if (window)
+	{
+		glfwDestroyWindow((GLFWwindow*)window);
+		glfwTerminate();
+		window = nullptr;
+	}
+}
+
+GLADloadproc HeadlessContext::getLoader()
+{
+	return (GLADloadproc)glfwGetProcAddress;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glad/glad.h>
+
+//Contexto OpenGL sem janela para renderizar em lote. No Linux usa EGL sem superficie
+//(EGL_MESA_platform_surfaceless, que roda no llvmpipe de servidores sem display; ligar com
+//-lEGL). Nas outras plataformas, ou se o EGL falhar, cai para uma janela GLFW invisivel.
+//Nao ha framebuffer padrao utilizavel: o quadro deve ir para um Framebuffer
+class HeadlessContext
+{
+public:
+	HeadlessContext() {}
+	~HeadlessContext() { destroy(); }
+	//Cria o contexto core e o torna corrente
+	bool create(int major, int minor);
+	void destroy();
+	//Para o gladLoadGLLoader e o loadGLExtensions
+	GLADloadproc getLoader();
+	const char* getBackendName() { return display ? "EGL" : "GLFW"; }
+
+protected:
+	bool createEGL(int major, int minor);
+
+	void* display = nullptr; //EGLDisplay
+	void* context = nullptr; //EGLContext
+	void* window = nullptr; //GLFWwindow
+};
@@ -1,10 +1,14 @@
 #pragma once
 #include "Curve.h"
+#include "Spline.h"
 class Hermite :
     public Curve
 {
 public:
     Hermite();
-    void generateCurve(int pointsPerSegment);
+    int getNbSegments();
+    glm::mat4x3 getGeometryMatrix(int segment);
+    void getAffectedSegments(int controlPoint, vector<int>& segments);
+    SplineSegment getSegment(int segment);
 };
 
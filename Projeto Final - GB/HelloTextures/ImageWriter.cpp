@@ -0,0 +1,740 @@
+#include "ImageWriter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+//Tabelas do deflate (RFC 1951): base e bits extras dos codigos de comprimento 257..285 e de distancia 0..29
+static const unsigned short LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const unsigned char LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const unsigned short DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const unsigned char DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static const int DEFLATE_WINDOW = 32768;
+static const int DEFLATE_MIN_MATCH = 3, DEFLATE_MAX_MATCH = 258;
+static const int DEFLATE_HASH_BITS = 15;
+//Candidatos visitados por posicao; mais que isso quase nao melhora a taxa em imagens renderizadas
+static const int DEFLATE_MAX_CHAIN = 8;
+
+//Escreve bits a partir do menos significativo, como o deflate espera
+struct BitWriter
+{
+	vector<unsigned char>& out;
+	unsigned int buffer = 0;
+	int nbBits = 0;
+
+	BitWriter(vector<unsigned char>& out) : out(out) {}
+
+	void write(unsigned int bits, int count)
+	{
+		buffer |= bits << nbBits;
+		nbBits += count;
+		while (nbBits >= 8)
+		{
+			out.push_back(buffer & 0xFF);
+			buffer >>= 8;
+			nbBits -= 8;
+		}
+	}
+
+	//Codigos de Huffman vao do bit mais significativo para o menos
+	void writeCode(unsigned int code, int count)
+	{
+		unsigned int reversed = 0;
+		for (int i = 0; i < count; i++)
+		{
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+		write(reversed, count);
+	}
+
+	void flush()
+	{
+		if (nbBits > 0)
+		{
+			out.push_back(buffer & 0xFF);
+		}
+		buffer = 0;
+		nbBits = 0;
+	}
+};
+
+//Codigos fixos do bloco tipo 1
+static void writeLiteral(BitWriter& bits, int symbol)
+{
+	if (symbol < 144)
+	{
+		bits.writeCode(0x30 + symbol, 8);
+	}
+	else if (symbol < 256)
+	{
+		bits.writeCode(0x190 + symbol - 144, 9);
+	}
+	else if (symbol < 280)
+	{
+		bits.writeCode(symbol - 256, 7);
+	}
+	else
+	{
+		bits.writeCode(0xC0 + symbol - 280, 8);
+	}
+}
+
+static void writeMatch(BitWriter& bits, int length, int distance)
+{
+	int l = 28;
+	while (LENGTH_BASE[l] > length)
+	{
+		l--;
+	}
+	writeLiteral(bits, 257 + l);
+	bits.write(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+	int d = 29;
+	while (DISTANCE_BASE[d] > distance)
+	{
+		d--;
+	}
+	bits.writeCode(d, 5);
+	bits.write(distance - DISTANCE_BASE[d], DISTANCE_EXTRA[d]);
+}
+
+static unsigned int hash3(const unsigned char* p)
+{
+	return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+//Stream zlib com um unico bloco de Huffman fixo e LZ77 por cadeias de hash
+static void deflate(const vector<unsigned char>& data, vector<unsigned char>& out)
+{
+	//CMF/FLG: deflate com janela de 32 KB, sem dicionario
+	out.push_back(0x78);
+	out.push_back(0x01);
+
+	BitWriter bits(out);
+	bits.write(1, 1); //BFINAL
+	bits.write(1, 2); //BTYPE = 01
+
+	int size = data.size();
+	vector<int> head(1 << DEFLATE_HASH_BITS, -1);
+	vector<int> previous(DEFLATE_WINDOW, -1);
+	const unsigned char* p = data.data();
+
+	int i = 0;
+	while (i < size)
+	{
+		int bestLength = 0, bestDistance = 0;
+
+		if (i + DEFLATE_MIN_MATCH <= size)
+		{
+			unsigned int h = hash3(p + i);
+			int maxLength = size - i < DEFLATE_MAX_MATCH ? size - i : DEFLATE_MAX_MATCH;
+
+			int candidate = head[h];
+			for (int chain = 0; chain < DEFLATE_MAX_CHAIN && candidate >= 0 && i - candidate <= DEFLATE_WINDOW; chain++)
+			{
+				if (p[candidate + bestLength] == p[i + bestLength])
+				{
+					int length = 0;
+					while (length < maxLength && p[candidate + length] == p[i + length])
+					{
+						length++;
+					}
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = i - candidate;
+						if (length == maxLength)
+						{
+							break;
+						}
+					}
+				}
+				int next = previous[candidate % DEFLATE_WINDOW];
+				candidate = next < candidate ? next : -1;
+			}
+		}
+
+		int advance = 1;
+		if (bestLength >= DEFLATE_MIN_MATCH)
+		{
+			writeMatch(bits, bestLength, bestDistance);
+			advance = bestLength;
+		}
+		else
+		{
+			writeLiteral(bits, p[i]);
+		}
+
+		//Todas as posicoes cobertas entram no dicionario
+		for (int end = i + advance; i < end; i++)
+		{
+			if (i + DEFLATE_MIN_MATCH <= size)
+			{
+				unsigned int h = hash3(p + i);
+				previous[i % DEFLATE_WINDOW] = head[h];
+				head[h] = i;
+			}
+		}
+	}
+
+	writeLiteral(bits, 256);
+	bits.flush();
+
+	//Adler-32 dos dados descomprimidos, big-endian
+	unsigned int a = 1, b = 0;
+	for (int j = 0; j < size; )
+	{
+		//5552 bytes e o maximo antes de b estourar 32 bits
+		int end = j + 5552 < size ? j + 5552 : size;
+		for (; j < end; j++)
+		{
+			a += p[j];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	unsigned int adler = b << 16 | a;
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		out.push_back((adler >> shift) & 0xFF);
+	}
+}
+
+//Tabela do CRC-32 do PNG, montada uma vez (a inicializacao de estaticos locais e segura entre threads)
+struct CRCTable
+{
+	unsigned int values[256];
+
+	CRCTable()
+	{
+		for (unsigned int n = 0; n < 256; n++)
+		{
+			unsigned int c = n;
+			for (int k = 0; k < 8; k++)
+			{
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			values[n] = c;
+		}
+	}
+};
+
+static unsigned int crc32(const unsigned char* data, size_t size, unsigned int crc = 0)
+{
+	static const CRCTable table;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void writeChunk(vector<unsigned char>& png, const char* type, const unsigned char* data, size_t size)
+{
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		png.push_back((size >> shift) & 0xFF);
+	}
+	size_t start = png.size();
+	png.insert(png.end(), type, type + 4);
+	png.insert(png.end(), data, data + size);
+
+	unsigned int crc = crc32(&png[start], size + 4);
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		png.push_back((crc >> shift) & 0xFF);
+	}
+}
+
+static unsigned char paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+}
+
+//Aplica um dos filtros do PNG (0 nenhum, 1 sub, 2 up, 4 paeth) e retorna a soma dos residuos
+//com sinal, a heuristica usual para escolher o filtro da linha
+static unsigned int filterRow(int filter, const unsigned char* row, const unsigned char* above, int size, unsigned char* out)
+{
+	unsigned int cost = 0;
+	for (int x = 0; x < size; x++)
+	{
+		int left = x >= 4 ? row[x - 4] : 0;
+		int up = above ? above[x] : 0;
+		int upLeft = above && x >= 4 ? above[x - 4] : 0;
+
+		unsigned char value = row[x];
+		switch (filter)
+		{
+		case 1: value -= left; break;
+		case 2: value -= up; break;
+		case 4: value -= paeth(left, up, upLeft); break;
+		}
+		out[x] = value;
+		cost += value < 128 ? value : 256 - value;
+	}
+	return cost;
+}
+
+void encodePNG(const unsigned char* rgba, int width, int height, int stride, vector<unsigned char>& png)
+{
+	static const int FILTERS[4] = { 0, 1, 2, 4 };
+	int rowSize = width * 4;
+
+	//Cada linha recebe o byte do filtro seguido dos residuos
+	vector<unsigned char> filtered((size_t)(rowSize + 1) * height);
+	vector<unsigned char> candidate(rowSize);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = rgba + (ptrdiff_t)y * stride;
+		const unsigned char* above = y > 0 ? row - stride : nullptr;
+		unsigned char* out = &filtered[(size_t)y * (rowSize + 1)];
+
+		unsigned int bestCost = 0xFFFFFFFF;
+		for (int f = 0; f < 4; f++)
+		{
+			unsigned int cost = filterRow(FILTERS[f], row, above, rowSize, candidate.data());
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				out[0] = FILTERS[f];
+				memcpy(out + 1, candidate.data(), rowSize);
+			}
+		}
+	}
+
+	vector<unsigned char> compressed;
+	compressed.reserve(filtered.size() / 2);
+	deflate(filtered, compressed);
+
+	static const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	png.assign(SIGNATURE, SIGNATURE + 8);
+
+	//Largura, altura, 8 bits, RGBA, deflate, filtro adaptativo, sem entrelacamento
+	unsigned char header[13] = { (unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+		(unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height, 8, 6, 0, 0, 0 };
+	writeChunk(png, "IHDR", header, sizeof(header));
+	writeChunk(png, "IDAT", compressed.data(), compressed.size());
+	writeChunk(png, "IEND", nullptr, 0);
+}
+
+bool writePNG(string path, const unsigned char* rgba, int width, int height, int stride)
+{
+	vector<unsigned char> png;
+	encodePNG(rgba, width, height, stride, png);
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool written = fwrite(png.data(), 1, png.size(), file) == png.size();
+	return fclose(file) == 0 && written;
+}
+
+bool writeRaw(string path, const unsigned char* rgba, int width, int height, int stride)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool written = true;
+	for (int y = 0; y < height && written; y++)
+	{
+		written = fwrite(rgba + (ptrdiff_t)y * stride, 4, width, file) == (size_t)width;
+	}
+	return fclose(file) == 0 && written;
+}
+
+//Caixa do median cut: cores de 15 bits (5 por canal) em colors[first, last)
+struct ColorBox
+{
+	int first, last;
+	int population;
+	int minimum[3], maximum[3];
+};
+
+static int getChannel(int color, int channel)
+{
+	return (color >> (10 - channel * 5)) & 31;
+}
+
+static void shrinkBox(ColorBox& box, const vector<int>& colors, const vector<int>& histogram)
+{
+	box.population = 0;
+	for (int c = 0; c < 3; c++)
+	{
+		box.minimum[c] = 31;
+		box.maximum[c] = 0;
+	}
+	for (int i = box.first; i < box.last; i++)
+	{
+		box.population += histogram[colors[i]];
+		for (int c = 0; c < 3; c++)
+		{
+			box.minimum[c] = min(box.minimum[c], getChannel(colors[i], c));
+			box.maximum[c] = max(box.maximum[c], getChannel(colors[i], c));
+		}
+	}
+}
+
+//Limiares da matriz de Bayer 4x4, centrados em zero, na escala de um degrau de 5 bits (8 niveis de 8 bits)
+static const int BAYER_4X4[16] = { -4, 0, -3, 1, 2, -2, 3, -1, -3, 1, -4, 0, 3, -1, 2, -2 };
+
+static int quantize15(const unsigned char* p, int x, int y)
+{
+	int offset = BAYER_4X4[(y & 3) * 4 + (x & 3)];
+	int r = min(255, max(0, p[0] + offset)) >> 3;
+	int g = min(255, max(0, p[1] + offset)) >> 3;
+	int b = min(255, max(0, p[2] + offset)) >> 3;
+	return r << 10 | g << 5 | b;
+}
+
+//Paleta de ate 256 cores e a tabela de cada cor de 15 bits para o indice na paleta
+static int buildPalette(const vector<unsigned short>& indices, unsigned char palette[256 * 3], vector<unsigned char>& lookup)
+{
+	vector<int> histogram(32768, 0);
+	for (int i = 0; i < indices.size(); i++)
+	{
+		histogram[indices[i]]++;
+	}
+
+	vector<int> colors;
+	for (int c = 0; c < 32768; c++)
+	{
+		if (histogram[c] > 0)
+		{
+			colors.push_back(c);
+		}
+	}
+
+	vector<ColorBox> boxes(1);
+	boxes[0].first = 0;
+	boxes[0].last = colors.size();
+	shrinkBox(boxes[0], colors, histogram);
+
+	//Divide na mediana do canal mais longo a caixa com maior extensao pesada pela populacao;
+	//na segunda metade so a extensao conta, para as cores raras nao ficarem em caixas enormes
+	while (boxes.size() < 256)
+	{
+		int best = -1;
+		double bestScore = 0;
+		for (int i = 0; i < boxes.size(); i++)
+		{
+			int extent = 0;
+			for (int c = 0; c < 3; c++)
+			{
+				extent = max(extent, boxes[i].maximum[c] - boxes[i].minimum[c]);
+			}
+			double score = boxes.size() < 128 ? (double)extent * boxes[i].population : (double)extent;
+			if (boxes[i].last - boxes[i].first > 1 && score > bestScore)
+			{
+				best = i;
+				bestScore = score;
+			}
+		}
+		if (best < 0)
+		{
+			break;
+		}
+
+		ColorBox box = boxes[best];
+		int channel = 0;
+		for (int c = 1; c < 3; c++)
+		{
+			if (box.maximum[c] - box.minimum[c] > box.maximum[channel] - box.minimum[channel])
+			{
+				channel = c;
+			}
+		}
+		sort(colors.begin() + box.first, colors.begin() + box.last, [channel](int a, int b) { return getChannel(a, channel) < getChannel(b, channel); });
+
+		int split = box.first, half = 0;
+		while (split < box.last - 1 && half + histogram[colors[split]] <= box.population / 2)
+		{
+			half += histogram[colors[split]];
+			split++;
+		}
+		split = max(split, box.first + 1);
+
+		ColorBox upper = box;
+		box.last = split;
+		upper.first = split;
+		shrinkBox(box, colors, histogram);
+		shrinkBox(upper, colors, histogram);
+		boxes[best] = box;
+		boxes.push_back(upper);
+	}
+
+	//Cor da paleta: media das cores da caixa, pesada pela populacao
+	lookup.assign(32768, 0);
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		double sum[3] = { 0, 0, 0 };
+		for (int k = boxes[i].first; k < boxes[i].last; k++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				int value = getChannel(colors[k], c);
+				sum[c] += (double)((value << 3) | (value >> 2)) * histogram[colors[k]];
+			}
+			lookup[colors[k]] = i;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			palette[i * 3 + c] = boxes[i].population > 0 ? (unsigned char)(sum[c] / boxes[i].population + 0.5) : 0;
+		}
+	}
+	return boxes.size();
+}
+
+//Saida do LZW em sub-blocos de ate 255 bytes
+struct GIFBlockWriter
+{
+	vector<unsigned char>& out;
+	unsigned char block[255];
+	int size = 0;
+	unsigned int buffer = 0;
+	int nbBits = 0;
+
+	GIFBlockWriter(vector<unsigned char>& out) : out(out) {}
+
+	void put(unsigned char byte)
+	{
+		block[size++] = byte;
+		if (size == 255)
+		{
+			flushBlock();
+		}
+	}
+
+	void write(unsigned int code, int count)
+	{
+		buffer |= code << nbBits;
+		nbBits += count;
+		while (nbBits >= 8)
+		{
+			put(buffer & 0xFF);
+			buffer >>= 8;
+			nbBits -= 8;
+		}
+	}
+
+	void flushBlock()
+	{
+		if (size > 0)
+		{
+			out.push_back(size);
+			out.insert(out.end(), block, block + size);
+			size = 0;
+		}
+	}
+
+	void finish()
+	{
+		if (nbBits > 0)
+		{
+			put(buffer & 0xFF);
+		}
+		flushBlock();
+		out.push_back(0);
+	}
+};
+
+static const int GIF_MIN_CODE_SIZE = 8;
+static const int GIF_MAX_CODES = 4096;
+static const int GIF_HASH_SIZE = 8192;
+
+static void encodeLZW(const vector<unsigned char>& pixels, vector<unsigned char>& out)
+{
+	const int clearCode = 1 << GIF_MIN_CODE_SIZE, endCode = clearCode + 1;
+
+	out.push_back(GIF_MIN_CODE_SIZE);
+	GIFBlockWriter bits(out);
+
+	//Tabela hash (prefixo, byte) -> codigo, com enderecamento aberto
+	vector<int> keys(GIF_HASH_SIZE), codes(GIF_HASH_SIZE);
+	fill(keys.begin(), keys.end(), -1);
+
+	int codeSize = GIF_MIN_CODE_SIZE + 1;
+	int lastCode = endCode;
+	bits.write(clearCode, codeSize);
+
+	int current = pixels.empty() ? -1 : pixels[0];
+	for (int i = 1; i < pixels.size(); i++)
+	{
+		int key = current << 8 | pixels[i];
+		int slot = (key * 2654435761u) >> 19;
+		while (keys[slot] >= 0 && keys[slot] != key)
+		{
+			slot = (slot + 1) & (GIF_HASH_SIZE - 1);
+		}
+
+		if (keys[slot] == key)
+		{
+			current = codes[slot];
+			continue;
+		}
+
+		bits.write(current, codeSize);
+		keys[slot] = key;
+		codes[slot] = ++lastCode;
+		if (lastCode >= (1 << codeSize))
+		{
+			codeSize++;
+		}
+		//Tabela cheia: recomeca o dicionario
+		if (lastCode == GIF_MAX_CODES - 1)
+		{
+			bits.write(clearCode, codeSize);
+			fill(keys.begin(), keys.end(), -1);
+			codeSize = GIF_MIN_CODE_SIZE + 1;
+			lastCode = endCode;
+		}
+		current = pixels[i];
+	}
+
+	if (current >= 0)
+	{
+		bits.write(current, codeSize);
+	}
+	bits.write(endCode, codeSize);
+	bits.finish();
+}
+
+static void putShort(vector<unsigned char>& out, int value)
+{
+	out.push_back(value & 0xFF);
+	out.push_back((value >> 8) & 0xFF);
+}
+
+void encodeGIFHeader(int width, int height, vector<unsigned char>& gif)
+{
+	static const char SIGNATURE[] = "GIF89a";
+	gif.insert(gif.end(), SIGNATURE, SIGNATURE + 6);
+	putShort(gif, width);
+	putShort(gif, height);
+	//Sem paleta global: cada quadro traz a sua
+	gif.push_back(0x70);
+	gif.push_back(0);
+	gif.push_back(0);
+
+	//NETSCAPE2.0: repete para sempre
+	static const char NETSCAPE[] = "NETSCAPE2.0";
+	gif.push_back(0x21);
+	gif.push_back(0xFF);
+	gif.push_back(11);
+	gif.insert(gif.end(), NETSCAPE, NETSCAPE + 11);
+	gif.push_back(3);
+	gif.push_back(1);
+	putShort(gif, 0);
+	gif.push_back(0);
+}
+
+void encodeGIFFrame(const unsigned char* rgba, int width, int height, int stride, int delay, vector<unsigned char>& gif)
+{
+	vector<unsigned short> colors((size_t)width * height);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = rgba + (ptrdiff_t)y * stride;
+		for (int x = 0; x < width; x++)
+		{
+			colors[(size_t)y * width + x] = quantize15(row + x * 4, x, y);
+		}
+	}
+
+	unsigned char palette[256 * 3] = {};
+	vector<unsigned char> lookup;
+	buildPalette(colors, palette, lookup);
+
+	vector<unsigned char> indices(colors.size());
+	for (size_t i = 0; i < colors.size(); i++)
+	{
+		indices[i] = lookup[colors[i]];
+	}
+
+	//Graphic Control Extension: tempo do quadro, sem transparencia
+	gif.push_back(0x21);
+	gif.push_back(0xF9);
+	gif.push_back(4);
+	gif.push_back(0x04);
+	putShort(gif, delay);
+	gif.push_back(0);
+	gif.push_back(0);
+
+	//Descritor da imagem com paleta local de 256 cores
+	gif.push_back(0x2C);
+	putShort(gif, 0);
+	putShort(gif, 0);
+	putShort(gif, width);
+	putShort(gif, height);
+	gif.push_back(0x87);
+	gif.insert(gif.end(), palette, palette + 256 * 3);
+
+	encodeLZW(indices, gif);
+}
+
+void encodeY4MHeader(int width, int height, int fps, vector<unsigned char>& y4m)
+{
+	char header[96];
+	int size = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height, fps);
+	y4m.insert(y4m.end(), header, header + size);
+}
+
+void encodeY4MFrame(const unsigned char* rgba, int width, int height, int stride, vector<unsigned char>& y4m)
+{
+	static const char FRAME[] = "FRAME\n";
+	y4m.insert(y4m.end(), FRAME, FRAME + 6);
+
+	int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	size_t start = y4m.size();
+	y4m.resize(start + (size_t)width * height + (size_t)chromaWidth * chromaHeight * 2);
+	unsigned char* luma = &y4m[start];
+	unsigned char* cb = luma + (size_t)width * height;
+	unsigned char* cr = cb + (size_t)chromaWidth * chromaHeight;
+
+	//BT.601 em ponto fixo (16 bits de fracao)
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = rgba + (ptrdiff_t)y * stride;
+		for (int x = 0; x < width; x++)
+		{
+			const unsigned char* p = row + x * 4;
+			luma[(size_t)y * width + x] = (19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16;
+		}
+	}
+
+	//Croma pela media de cada bloco 2x2 (nas bordas impares o bloco e menor)
+	for (int y = 0; y < chromaHeight; y++)
+	{
+		for (int x = 0; x < chromaWidth; x++)
+		{
+			int r = 0, g = 0, b = 0, n = 0;
+			for (int dy = 0; dy < 2 && y * 2 + dy < height; dy++)
+			{
+				const unsigned char* row = rgba + (ptrdiff_t)(y * 2 + dy) * stride;
+				for (int dx = 0; dx < 2 && x * 2 + dx < width; dx++)
+				{
+					const unsigned char* p = row + (x * 2 + dx) * 4;
+					r += p[0];
+					g += p[1];
+					b += p[2];
+					n++;
+				}
+			}
+			r /= n;
+			g /= n;
+			b /= n;
+			cb[(size_t)y * chromaWidth + x] = min(255, max(0, (-11059 * r - 21709 * g + 32768 * b + 8421376 + 32768) >> 16));
+			cr[(size_t)y * chromaWidth + x] = min(255, max(0, (32768 * r - 27439 * g - 5329 * b + 8421376 + 32768) >> 16));
+		}
+	}
+}
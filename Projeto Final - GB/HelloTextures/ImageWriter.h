@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//Gravacao de imagens RGBA8 sem dependencias externas. stride e a distancia em bytes entre
+//o inicio de duas linhas e pode ser negativo: com rgba apontando para a ultima linha, a
+//imagem lida do OpenGL (de baixo para cima) sai na orientacao certa sem copia extra
+
+//PNG com filtro escolhido por linha e deflate de Huffman fixo; comprime menos que a zlib,
+//mas cabe no orcamento de um quadro de captura
+bool writePNG(string path, const unsigned char* rgba, int width, int height, int stride);
+//Mesmo arquivo PNG, em memoria
+void encodePNG(const unsigned char* rgba, int width, int height, int stride, vector<unsigned char>& png);
+//Pixels crus, linha a linha, sem cabecalho (.rgba)
+bool writeRaw(string path, const unsigned char* rgba, int width, int height, int stride);
+
+//GIF animado em partes, para os quadros serem codificados em paralelo: o cabecalho (com
+//repeticao infinita), um bloco por quadro e o terminador de um byte (0x3B). Cada quadro
+//tem paleta propria de 256 cores por median cut, com dithering ordenado; delay em centesimos
+void encodeGIFHeader(int width, int height, vector<unsigned char>& gif);
+void encodeGIFFrame(const unsigned char* rgba, int width, int height, int stride, int delay, vector<unsigned char>& gif);
+const unsigned char GIF_TRAILER = 0x3B;
+
+//YUV4MPEG2 4:2:0 (BT.601, faixa completa), lido por ffmpeg e pela maioria dos editores
+void encodeY4MHeader(int width, int height, int fps, vector<unsigned char>& y4m);
+void encodeY4MFrame(const unsigned char* rgba, int width, int height, int stride, vector<unsigned char>& y4m);
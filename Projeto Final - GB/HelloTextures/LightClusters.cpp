@@ -0,0 +1,172 @@
+#include "LightClusters.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+#include <glm/gtc/type_ptr.hpp>
+
+//O Shader do projeto so monta vertex + fragment; o compute shader e compilado aqui
+static GLuint createComputeProgram(const char* path)
+{
+	ifstream file(path);
+	if (!file)
+	{
+		cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << endl;
+		return 0;
+	}
+	stringstream stream;
+	stream << file.rdbuf();
+	string code = stream.str();
+	const GLchar* source = code.c_str();
+
+	GLint success;
+	GLchar infoLog[512];
+	GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glGetShaderInfoLog(shader, 512, NULL, infoLog);
+		cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+	glDeleteShader(shader);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(program, 512, NULL, infoLog);
+		cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+bool LightClusters::create(const vector<PointLight>& lights)
+{
+	deleteResources();
+	if (!glDispatchCompute || !glMemoryBarrier)
+	{
+		return false;
+	}
+
+	program = createComputeProgram("../shaders/clusters.cs");
+	if (!program)
+	{
+		return false;
+	}
+
+	nbLights = lights.size();
+	glGenBuffers(3, buffers);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, max(nbLights, 1) * sizeof(PointLight), lights.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[1]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, NB_CLUSTERS * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[2]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, NB_CLUSTERS * CLUSTER_CAPACITY * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	counts.resize(NB_CLUSTERS);
+	timer.create();
+	return true;
+}
+
+void LightClusters::deleteResources()
+{
+	if (program)
+	{
+		glDeleteProgram(program);
+		glDeleteBuffers(3, buffers);
+		program = 0;
+		buffers[0] = buffers[1] = buffers[2] = 0;
+	}
+	timer.destroy();
+	nbLights = 0;
+}
+
+void LightClusters::setupShader(Shader* shader)
+{
+	shader->setBool("useClusters", isCreated());
+	shader->setBool("showClusters", isCreated() && heatmap);
+	glUniform3i(glGetUniformLocation(shader->ID, "clusterGrid"), GRID_X, GRID_Y, GRID_Z);
+	shader->setInt("clusterCapacity", CLUSTER_CAPACITY);
+}
+
+void LightClusters::update(GLState& state, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane)
+{
+	if (!isCreated())
+	{
+		return;
+	}
+	this->nearPlane = nearPlane;
+	this->farPlane = farPlane;
+	timer.poll();
+
+	state.useProgram(program);
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHTS_BINDING, buffers[0]);
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTS_BINDING, buffers[1]);
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INDICES_BINDING, buffers[2]);
+
+	//projection[0][0] e projection[1][1] sao 1 / tan da metade dos angulos de visao
+	glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	glUniform2f(glGetUniformLocation(program, "tanHalfFov"), 1.0f / projection[0][0], 1.0f / projection[1][1]);
+	glUniform1f(glGetUniformLocation(program, "nearPlane"), nearPlane);
+	glUniform1f(glGetUniformLocation(program, "farPlane"), farPlane);
+	glUniform3i(glGetUniformLocation(program, "clusterGrid"), GRID_X, GRID_Y, GRID_Z);
+	glUniform1i(glGetUniformLocation(program, "clusterCapacity"), CLUSTER_CAPACITY);
+	glUniform1i(glGetUniformLocation(program, "nbLights"), nbLights);
+
+	timer.begin();
+	glDispatchCompute((NB_CLUSTERS + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+	timer.end();
+	//Os fragment shaders do passo principal leem as listas
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void LightClusters::apply(Shader* shader, int viewportWidth, int viewportHeight)
+{
+	if (!isCreated())
+	{
+		return;
+	}
+
+	//Fatia = log(profundidade) * x + y, a inversa das profundidades de clusters.cs
+	float depthScale = GRID_Z / log(farPlane / nearPlane);
+	shader->setVec4("clusterScale", (float)GRID_X / viewportWidth, (float)GRID_Y / viewportHeight, depthScale, -log(nearPlane) * depthScale);
+	shader->setBool("showClusters", heatmap);
+}
+
+void LightClusters::countLights(GLState& state, float& average, int& maximum, int& nbOccupied)
+{
+	average = 0.0f;
+	maximum = nbOccupied = 0;
+	if (!isCreated())
+	{
+		return;
+	}
+
+	//A barreira de update() so cobre os shaders; a leitura pela API precisa da sua
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	state.bindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[1]);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, NB_CLUSTERS * sizeof(GLuint), counts.data());
+
+	long long total = 0;
+	for (int i = 0; i < NB_CLUSTERS; i++)
+	{
+		if (counts[i] > 0)
+		{
+			total += counts[i];
+			nbOccupied++;
+			maximum = max(maximum, (int)counts[i]);
+		}
+	}
+	average = nbOccupied > 0 ? (float)total / nbOccupied : 0.0f;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "Shader.h"
+#include "GLState.h"
+#include "GPUTimer.h"
+
+using namespace std;
+
+//Luz pontual como o shader le: posicao no mundo e alcance, cor
+struct PointLight
+{
+	glm::vec4 positionRadius;
+	glm::vec4 color;
+};
+
+//Iluminacao forward em clusters para as luzes pontuais da cena. O frustum da camera e
+//dividido em GRID_X x GRID_Y tiles de tela e GRID_Z fatias de profundidade exponenciais.
+//A cada quadro um compute shader (clusters.cs) testa a esfera de cada luz contra a caixa de
+//cada cluster no espaco da camera e grava ate CLUSTER_CAPACITY indices por cluster; o
+//sprite.fs acha o cluster do fragmento pela posicao na tela e pela profundidade e percorre
+//so as luzes dele
+class LightClusters
+{
+public:
+	LightClusters() {}
+	~LightClusters() { deleteResources(); }
+	//Compila o compute shader e envia as luzes; retorna false sem suporte a compute shaders
+	bool create(const vector<PointLight>& lights);
+	void deleteResources();
+	bool isCreated() { return program != 0; }
+	//Distribui as luzes nos clusters do quadro; troca o programa em uso
+	void update(GLState& state, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane);
+	//Envia a escala da grade ao shader dos objetos, que precisa estar em uso; os buffers
+	//continuam ligados desde o update
+	void apply(Shader* shader, int viewportWidth, int viewportHeight);
+	//useClusters, a grade e o mapa de calor; chamado mesmo sem create
+	void setupShader(Shader* shader);
+	void setHeatmap(bool heatmap) { this->heatmap = heatmap; }
+	bool getHeatmap() { return heatmap; }
+
+	int getNbLights() { return nbLights; }
+	double getGPUTime() { return timer.getAverageTime(); }
+	//Le as contagens do ultimo quadro (espera a GPU): media nos clusters com alguma luz e maximo
+	void countLights(GLState& state, float& average, int& maximum, int& nbOccupied);
+
+	enum { GRID_X = 16, GRID_Y = 9, GRID_Z = 24, NB_CLUSTERS = GRID_X * GRID_Y * GRID_Z, CLUSTER_CAPACITY = 256 };
+	//Pontos de ligacao dos SSBOs, depois dos do CurveBuffer e da MaterialLibrary
+	enum { LIGHTS_BINDING = 4, COUNTS_BINDING = 5, INDICES_BINDING = 6 };
+	//Invocacoes por grupo; cada grupo le as luzes em blocos desse tamanho na memoria compartilhada
+	enum { GROUP_SIZE = 128 };
+
+protected:
+	GLuint program = 0;
+	GLuint buffers[3] = { 0, 0, 0 }; //luzes, contagens, indices
+	vector<GLuint> counts; //copia de countLights, alocada no create
+	int nbLights = 0;
+	float nearPlane = 0.1f, farPlane = 100.0f;
+	bool heatmap = false;
+	GPUTimer timer;
+};
@@ -0,0 +1,732 @@
+#include "MaterialLibrary.h"
+#include "stb_image.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+
+#include "AtlasPacker.h"
+#include "MipChain.h"
+
+//Le so o tamanho da imagem; o lugar dela (atlas ou array) e decidido no upload.
+//Caminho vazio ou falha de leitura usam uma textura branca de 1x1
+int MaterialLibrary::addImage(string path)
+{
+	for (int i = 0; i < images.size(); i++)
+	{
+		if (images[i].path == path)
+		{
+			return i;
+		}
+	}
+
+	Image image;
+	image.path = path;
+	image.pixels = nullptr;
+	image.found = false;
+
+	if (!path.empty())
+	{
+		int nrChannels;
+		image.found = stbi_info(("../textures/" + path).c_str(), &image.width, &image.height, &nrChannels) != 0;
+		if (!image.found)
+		{
+			cout << "Failed to load texture" << endl;
+		}
+	}
+
+	if (!image.found)
+	{
+		image.width = image.height = 1;
+	}
+
+	image.array = image.layer = -1;
+	image.atlased = false;
+	image.x = image.y = 0;
+	images.push_back(image);
+
+	return images.size() - 1;
+}
+
+int MaterialLibrary::addMaterial(glm::vec3 ka, float kd, glm::vec3 ks, float ns, string texturePath)
+{
+	int image = addImage(texturePath);
+
+	GPUMaterial material;
+	material.ka = glm::vec4(ka, kd);
+	material.ks = glm::vec4(ks, ns);
+	material.texture = glm::ivec4(0);
+	material.handle = glm::uvec4(0);
+	material.uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+	for (int i = 0; i < materials.size(); i++)
+	{
+		if (materials[i].ka == material.ka && materials[i].ks == material.ks && materialImages[i] == image)
+		{
+			return i;
+		}
+	}
+
+	materials.push_back(material);
+	materialImages.push_back(image);
+	return materials.size() - 1;
+}
+
+string MaterialLibrary::getTexturePath(int materialId)
+{
+	const Image& image = images[materialImages[materialId]];
+	return image.found ? "../textures/" + image.path : "";
+}
+
+static int alignUp(int value, int alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+void MaterialLibrary::packImages()
+{
+	vector<int> small;
+	int totalArea = 0;
+
+	for (int i = 0; i < images.size(); i++)
+	{
+		if (images[i].width <= ATLAS_MAX_IMAGE && images[i].height <= ATLAS_MAX_IMAGE)
+		{
+			small.push_back(i);
+			totalArea += alignUp(images[i].width + 2 * ATLAS_GUTTER, ATLAS_ALIGN) * alignUp(images[i].height + 2 * ATLAS_GUTTER, ATLAS_ALIGN);
+		}
+	}
+
+	//Uma imagem sozinha no atlas so perderia resolucao nos mipmaps
+	if (small.size() < 2)
+	{
+		small.clear();
+	}
+
+	//Mais altas primeiro: o skyline fica mais plano e sobra menos espaco
+	sort(small.begin(), small.end(), [this](int a, int b)
+	{
+		return images[a].height != images[b].height ? images[a].height > images[b].height : images[a].width > images[b].width;
+	});
+
+	//Menor pagina em que tudo cabe; se nem a maior basta, usa varias paginas dela
+	int pageSize = ATLAS_MAX_PAGE;
+	for (int size = 512; size < ATLAS_MAX_PAGE && !small.empty(); size *= 2)
+	{
+		if (totalArea > size * size)
+		{
+			continue;
+		}
+
+		AtlasPacker packer(size, size);
+		bool fits = true;
+		for (int i = 0; i < small.size() && fits; i++)
+		{
+			Image& image = images[small[i]];
+			fits = packer.insert(alignUp(image.width + 2 * ATLAS_GUTTER, ATLAS_ALIGN), alignUp(image.height + 2 * ATLAS_GUTTER, ATLAS_ALIGN), image.x, image.y);
+		}
+
+		if (fits)
+		{
+			pageSize = size;
+			break;
+		}
+	}
+
+	if (!small.empty())
+	{
+		//Abaixo de ATLAS_MAX_LEVEL a borda nao separa mais as regioes
+		int nbLevels = min((int)ATLAS_MAX_LEVEL + 1, MipChain::getNbLevels(pageSize, pageSize));
+		TextureArray atlas = { pageSize, pageSize, 0, 0, 0, true, nbLevels, 0, CompressedTexture(), nbLevels, nbLevels, -1 };
+		vector<AtlasPacker> pages;
+
+		for (int i = 0; i < small.size(); i++)
+		{
+			Image& image = images[small[i]];
+			int width = alignUp(image.width + 2 * ATLAS_GUTTER, ATLAS_ALIGN);
+			int height = alignUp(image.height + 2 * ATLAS_GUTTER, ATLAS_ALIGN);
+
+			image.layer = -1;
+			for (int page = 0; page < pages.size() && image.layer < 0; page++)
+			{
+				if (pages[page].insert(width, height, image.x, image.y))
+				{
+					image.layer = page;
+				}
+			}
+
+			if (image.layer < 0)
+			{
+				pages.push_back(AtlasPacker(pageSize, pageSize));
+				pages.back().insert(width, height, image.x, image.y);
+				image.layer = pages.size() - 1;
+			}
+
+			image.array = arrays.size();
+			image.atlased = true;
+		}
+
+		atlas.nbLayers = pages.size();
+		arrays.push_back(atlas);
+	}
+
+	for (int i = 0; i < images.size(); i++)
+	{
+		Image& image = images[i];
+		if (image.atlased)
+		{
+			continue;
+		}
+
+		image.array = -1;
+		for (int j = 0; j < arrays.size(); j++)
+		{
+			if (!arrays[j].atlas && arrays[j].width == image.width && arrays[j].height == image.height)
+			{
+				image.array = j;
+				break;
+			}
+		}
+
+		if (image.array < 0)
+		{
+			int nbLevels = MipChain::getNbLevels(image.width, image.height);
+			TextureArray textureArray = { image.width, image.height, 0, 0, 0, false, nbLevels, 0, CompressedTexture(), nbLevels, nbLevels, -1 };
+			arrays.push_back(textureArray);
+			image.array = arrays.size() - 1;
+		}
+
+		image.layer = arrays[image.array].nbLayers++;
+	}
+}
+
+void MaterialLibrary::loadPixels(Image& image)
+{
+	if (image.pixels)
+	{
+		return;
+	}
+
+	if (image.found)
+	{
+		int width, height, nrChannels;
+		image.pixels = stbi_load(("../textures/" + image.path).c_str(), &width, &height, &nrChannels, 4);
+	}
+
+	if (!image.pixels)
+	{
+		image.width = image.height = 1;
+		image.pixels = (unsigned char*)malloc(4);
+		memset(image.pixels, 0xFF, 4);
+	}
+}
+
+void MaterialLibrary::freePixels(Image& image)
+{
+	stbi_image_free(image.pixels);
+	image.pixels = nullptr;
+}
+
+//No atlas a imagem e copiada cercada pela borda: os texels da borda repetem o lado
+//oposto da imagem, assim o filtro linear e os mipmaps reproduzem GL_REPEAT na regiao
+void MaterialLibrary::composeLayer(int array, int layer, vector<unsigned char>& pixels)
+{
+	const TextureArray& textureArray = arrays[array];
+	pixels.assign((size_t)textureArray.width * textureArray.height * 4, 0);
+	unsigned int* target = (unsigned int*)pixels.data();
+
+	for (int i = 0; i < images.size(); i++)
+	{
+		Image& image = images[i];
+		if (image.array != array || image.layer != layer)
+		{
+			continue;
+		}
+
+		loadPixels(image);
+		const unsigned int* source = (const unsigned int*)image.pixels;
+
+		if (!image.atlased)
+		{
+			memcpy(target, source, (size_t)image.width * image.height * 4);
+			continue;
+		}
+
+		for (int y = 0; y < image.height + 2 * ATLAS_GUTTER; y++)
+		{
+			int sy = ((y - ATLAS_GUTTER) % image.height + image.height) % image.height;
+			unsigned int* row = target + (size_t)(image.y + y) * textureArray.width + image.x;
+			for (int x = 0; x < image.width + 2 * ATLAS_GUTTER; x++)
+			{
+				int sx = ((x - ATLAS_GUTTER) % image.width + image.width) % image.width;
+				row[x] = source[sy * image.width + sx];
+			}
+		}
+	}
+}
+
+//A chave cobre tudo que muda o conteudo do array: tamanho, niveis e, para cada imagem,
+//arquivo de origem e posicao
+unsigned long long MaterialLibrary::getCacheKey(int array)
+{
+	const TextureArray& textureArray = arrays[array];
+	int layout[4] = { textureArray.width, textureArray.height, textureArray.nbLayers, textureArray.nbLevels };
+	unsigned long long key = TextureCache::hash(layout, sizeof(layout));
+
+	for (int i = 0; i < images.size(); i++)
+	{
+		const Image& image = images[i];
+		if (image.array == array)
+		{
+			int placement[5] = { image.layer, image.x, image.y, image.width, image.height };
+			key = TextureCache::hash(placement, sizeof(placement), key);
+			if (image.found)
+			{
+				key = TextureCache::hashFileStamp("../textures/" + image.path, key);
+			}
+		}
+	}
+
+	return key;
+}
+
+//Comprime todas as camadas e niveis do array. BC3 so quando alguma imagem tem alfa;
+//a qualidade de cada imagem no nivel 0 e informada em PSNR
+void MaterialLibrary::bakeArray(int array, CompressedTexture& texture)
+{
+	const TextureArray& textureArray = arrays[array];
+	bool hasAlpha = false;
+
+	for (int i = 0; i < images.size(); i++)
+	{
+		Image& image = images[i];
+		if (image.array != array)
+		{
+			continue;
+		}
+
+		loadPixels(image);
+		for (int j = 0; j < image.width * image.height && !hasAlpha; j++)
+		{
+			hasAlpha = image.pixels[j * 4 + 3] != 255;
+		}
+	}
+
+	texture.format = hasAlpha ? BLOCK_BC3 : BLOCK_BC1;
+	texture.width = textureArray.width;
+	texture.height = textureArray.height;
+	texture.nbLayers = textureArray.nbLayers;
+	texture.nbLevels = textureArray.nbLevels;
+	texture.allocate();
+
+	vector<unsigned char> pixels, decoded;
+	MipChain mips;
+
+	for (int layer = 0; layer < textureArray.nbLayers; layer++)
+	{
+		composeLayer(array, layer, pixels);
+		mips.build(pixels.data(), textureArray.width, textureArray.height, textureArray.nbLevels, textureArray.atlas ? MIP_BOX : MIP_KAISER);
+
+		for (int level = 0; level < textureArray.nbLevels; level++)
+		{
+			unsigned char* blocks = texture.data.data() + texture.getLevelOffset(level) + texture.getLevelSize(level) / texture.nbLayers * layer;
+			compressBlocks(texture.format, mips.getPixels(level), mips.getWidth(level), mips.getHeight(level), blocks);
+		}
+
+		decoded.resize(pixels.size());
+		decompressBlocks(texture.format, texture.data.data() + texture.getLevelSize(0) / texture.nbLayers * layer, textureArray.width, textureArray.height, decoded.data());
+
+		for (int i = 0; i < images.size(); i++)
+		{
+			const Image& image = images[i];
+			if (image.array == array && image.layer == layer && image.found)
+			{
+				size_t offset = image.atlased ? ((size_t)(image.y + ATLAS_GUTTER) * textureArray.width + image.x + ATLAS_GUTTER) * 4 : 0;
+				float psnr = computePSNR(pixels.data() + offset, decoded.data() + offset, image.width, image.height, textureArray.width, hasAlpha ? 4 : 3);
+				cout << image.path << ": " << (hasAlpha ? "BC3" : "BC1") << ", PSNR " << psnr << " dB" << endl;
+			}
+		}
+	}
+}
+
+void MaterialLibrary::buildLevels(int array, CompressedTexture& texture)
+{
+	const TextureArray& textureArray = arrays[array];
+
+	texture.format = BLOCK_RGBA8;
+	texture.width = textureArray.width;
+	texture.height = textureArray.height;
+	texture.nbLayers = textureArray.nbLayers;
+	texture.nbLevels = textureArray.nbLevels;
+	texture.allocate();
+
+	vector<unsigned char> pixels;
+	MipChain mips;
+
+	for (int layer = 0; layer < textureArray.nbLayers; layer++)
+	{
+		composeLayer(array, layer, pixels);
+		mips.build(pixels.data(), textureArray.width, textureArray.height, textureArray.nbLevels, textureArray.atlas ? MIP_BOX : MIP_KAISER);
+
+		for (int level = 0; level < textureArray.nbLevels; level++)
+		{
+			size_t layerSize = texture.getLevelSize(level) / texture.nbLayers;
+			memcpy(texture.data.data() + texture.getLevelOffset(level) + layerSize * layer, mips.getPixels(level), layerSize);
+		}
+	}
+}
+
+void MaterialLibrary::uploadArray(int array, bool compress)
+{
+	TextureArray& textureArray = arrays[array];
+	CompressedTexture& texture = textureArray.levels;
+
+	if (compress)
+	{
+		unsigned long long key = getCacheKey(array);
+
+		if (!cache.load(key, texture))
+		{
+			bakeArray(array, texture);
+			cache.save(key, texture);
+		}
+	}
+	else
+	{
+		buildLevels(array, texture);
+	}
+
+	for (int i = 0; i < images.size(); i++)
+	{
+		if (images[i].array == array)
+		{
+			freePixels(images[i]);
+		}
+	}
+
+	int level = 0;
+	if (textureBudget > 0)
+	{
+		while (level < textureArray.nbLevels - 1 && max(texture.getLevelWidth(level), texture.getLevelHeight(level)) > STREAMING_START_SIZE)
+		{
+			level++;
+		}
+	}
+
+	GLState state;
+	createTexture(state, array, level);
+	textureArray.wantedLevel = textureArray.nbLevels;
+	textureArray.lastUsedFrame = -1;
+
+	//Sem streaming os niveis nao sao mais necessarios depois do envio
+	if (textureBudget == 0)
+	{
+		vector<unsigned char>().swap(texture.data);
+	}
+}
+
+void MaterialLibrary::createTexture(GLState& state, int array, int level)
+{
+	TextureArray& textureArray = arrays[array];
+	const CompressedTexture& texture = textureArray.levels;
+
+	GLuint object;
+	glGenTextures(1, &object);
+	state.bindTexture(0, GL_TEXTURE_2D_ARRAY, object);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, texture.nbLevels - 1 - level);
+
+	//O nivel residente mais fino vira o nivel 0 do objeto; as UVs sao normalizadas,
+	//entao o shader e as transformacoes do atlas nao mudam
+	for (int i = level; i < texture.nbLevels; i++)
+	{
+		const unsigned char* data = texture.data.data() + texture.getLevelOffset(i);
+
+		if (texture.format == BLOCK_RGBA8)
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, i - level, GL_RGBA8, texture.getLevelWidth(i), texture.getLevelHeight(i), texture.nbLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+		else
+		{
+			GLenum format = texture.format == BLOCK_BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, i - level, format, texture.getLevelWidth(i), texture.getLevelHeight(i), texture.nbLayers, 0,
+				(GLsizei)texture.getLevelSize(i), data);
+		}
+	}
+
+	if (textureArray.texture != 0)
+	{
+		if (textureArray.handle != 0)
+		{
+			glMakeTextureHandleNonResidentARB(textureArray.handle);
+			textureArray.handle = 0;
+		}
+		state.deleteTexture(textureArray.texture);
+	}
+
+	textureArray.texture = object;
+	textureArray.residentLevel = level;
+	textureArray.memorySize = getLevelsSize(array, level);
+
+	//O handle congela os parametros da textura, entao vem depois de tudo configurado
+	if (bindless)
+	{
+		textureArray.handle = glGetTextureHandleARB(object);
+		glMakeTextureHandleResidentARB(textureArray.handle);
+	}
+}
+
+size_t MaterialLibrary::getLevelsSize(int array, int level)
+{
+	const CompressedTexture& texture = arrays[array].levels;
+	return texture.getLevelOffset(texture.nbLevels) - texture.getLevelOffset(level);
+}
+
+void MaterialLibrary::updateHandles(GLState& state)
+{
+	for (int i = 0; i < materials.size(); i++)
+	{
+		GLuint64 handle = arrays[images[materialImages[i]].array].handle;
+		materials[i].handle = glm::uvec4((GLuint)(handle & 0xFFFFFFFF), (GLuint)(handle >> 32), 0, 0);
+	}
+
+	if (SSBO != 0)
+	{
+		state.bindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, materials.size() * sizeof(GPUMaterial), materials.data());
+	}
+}
+
+void MaterialLibrary::requestResidency(int materialId, float screenSize)
+{
+	const Image& image = images[materialImages[materialId]];
+	TextureArray& textureArray = arrays[image.array];
+
+	//O GPU escolhe o mipmap por texels por pixel; a textura cobre o objeto uma vez
+	int level = 0;
+	if (screenSize >= 0.0f)
+	{
+		float texelsPerPixel = max(image.width, image.height) / max(screenSize, 1.0f);
+		level = texelsPerPixel > 1.0f ? (int)log2f(texelsPerPixel) : 0;
+	}
+
+	textureArray.wantedLevel = min(textureArray.wantedLevel, min(level, textureArray.nbLevels - 1));
+	textureArray.lastUsedFrame = streamingFrame;
+}
+
+//Niveis dos arrays se candidate subir um nivel. Acima do orcamento o array usado ha
+//mais tempo (LRU) perde o nivel mais fino; arrays usados no quadro so perdem niveis alem
+//dos que pediram. Retorna false, sem descartar nada, se mesmo assim nao couber
+bool MaterialLibrary::planResidency(int candidate, int frame, vector<int>& planned)
+{
+	size_t total = 0;
+	for (int i = 0; i < arrays.size(); i++)
+	{
+		planned[i] = arrays[i].residentLevel - (i == candidate ? 1 : 0);
+		total += getLevelsSize(i, planned[i]);
+	}
+
+	while (total > textureBudget)
+	{
+		int victim = -1;
+		for (int i = 0; i < arrays.size(); i++)
+		{
+			const TextureArray& textureArray = arrays[i];
+			bool evictable = i != candidate && planned[i] < textureArray.nbLevels - 1 &&
+				(textureArray.lastUsedFrame < frame || planned[i] < textureArray.wantedLevel);
+
+			if (evictable && (victim < 0 || textureArray.lastUsedFrame < arrays[victim].lastUsedFrame))
+			{
+				victim = i;
+			}
+		}
+
+		if (victim < 0)
+		{
+			return false;
+		}
+
+		total -= getLevelsSize(victim, planned[victim]) - getLevelsSize(victim, planned[victim] + 1);
+		planned[victim]++;
+	}
+
+	return true;
+}
+
+void MaterialLibrary::updateStreaming(GLState& state)
+{
+	int frame = streamingFrame++;
+
+	if (textureBudget == 0)
+	{
+		return;
+	}
+
+	//Um nivel por quadro, para o envio nao travar o quadro: sobe o array mais longe do
+	//que pediu entre os que cabem no orcamento
+	vector<int>& candidates = streamingCandidates;
+	candidates.clear();
+	for (int i = 0; i < arrays.size(); i++)
+	{
+		if (arrays[i].lastUsedFrame == frame && arrays[i].wantedLevel < arrays[i].residentLevel)
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	sort(candidates.begin(), candidates.end(), [this](int a, int b)
+	{
+		return arrays[a].residentLevel - arrays[a].wantedLevel > arrays[b].residentLevel - arrays[b].wantedLevel;
+	});
+
+	vector<int>& levels = streamingLevels;
+	bool planned = false;
+	for (int i = 0; i < candidates.size() && !planned; i++)
+	{
+		planned = planResidency(candidates[i], frame, levels);
+	}
+
+	for (int i = 0; i < arrays.size(); i++)
+	{
+		if (planned && levels[i] != arrays[i].residentLevel)
+		{
+			createTexture(state, i, levels[i]);
+		}
+		arrays[i].wantedLevel = arrays[i].nbLevels;
+	}
+
+	if (planned && bindless)
+	{
+		updateHandles(state);
+	}
+}
+
+size_t MaterialLibrary::getResidentSize()
+{
+	size_t size = 0;
+	for (int i = 0; i < arrays.size(); i++)
+	{
+		size += arrays[i].memorySize;
+	}
+	return size;
+}
+
+void MaterialLibrary::upload(bool useBindless, bool compress)
+{
+	bindless = useBindless && glGetTextureHandleARB && glMakeTextureHandleResidentARB;
+
+	packImages();
+	streamingCandidates.reserve(arrays.size());
+	streamingLevels.resize(arrays.size());
+
+	if (!bindless && arrays.size() > MAX_TEXTURE_ARRAYS)
+	{
+		cout << arrays.size() << " texture sizes, only " << MAX_TEXTURE_ARRAYS << " texture arrays can be bound without bindless textures" << endl;
+	}
+
+	auto start = chrono::high_resolution_clock::now();
+	size_t memorySize = 0, uncompressedSize = 0;
+
+	for (int i = 0; i < arrays.size(); i++)
+	{
+		uploadArray(i, compress);
+		memorySize += arrays[i].memorySize;
+		uncompressedSize += (size_t)arrays[i].width * arrays[i].height * arrays[i].nbLayers * 4 * 4 / 3;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	double uploadMs = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+
+	for (int i = 0; i < materials.size(); i++)
+	{
+		const Image& image = images[materialImages[i]];
+		materials[i].texture = glm::ivec4(image.array, image.layer, image.atlased ? 1 : 0, 0);
+
+		if (image.atlased)
+		{
+			float pageSize = (float)arrays[image.array].width;
+			materials[i].uvTransform = glm::vec4(image.width / pageSize, image.height / pageSize,
+				(image.x + ATLAS_GUTTER) / pageSize, (image.y + ATLAS_GUTTER) / pageSize);
+		}
+
+		GLuint64 handle = arrays[image.array].handle;
+		materials[i].handle = glm::uvec4((GLuint)(handle & 0xFFFFFFFF), (GLuint)(handle >> 32), 0, 0);
+	}
+
+	if (SSBO == 0)
+	{
+		glGenBuffers(1, &SSBO);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(GPUMaterial), materials.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	int nbAtlased = 0;
+	for (int i = 0; i < images.size(); i++)
+	{
+		nbAtlased += images[i].atlased ? 1 : 0;
+	}
+	cout << images.size() << " textures in " << arrays.size() << " texture arrays (" << nbAtlased << " packed into the atlas)" << endl;
+	cout << "Textures: " << memorySize / (1024.0 * 1024.0) << " MB in VRAM (" << uncompressedSize / (1024.0 * 1024.0) << " MB as RGBA8), loaded in " << uploadMs << " ms" << endl;
+	if (textureBudget > 0)
+	{
+		cout << "Texture streaming with a " << textureBudget / (1024.0 * 1024.0) << " MB budget, starting at " << STREAMING_START_SIZE << "x" << STREAMING_START_SIZE << " mipmaps" << endl;
+	}
+}
+
+void MaterialLibrary::bind(GLState& state)
+{
+	state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_BINDING, SSBO);
+
+	if (bindless)
+	{
+		return;
+	}
+
+	for (int i = 0; i < arrays.size() && i < MAX_TEXTURE_ARRAYS; i++)
+	{
+		state.bindTexture(i, GL_TEXTURE_2D_ARRAY, arrays[i].texture);
+	}
+}
+
+void MaterialLibrary::setupShader(Shader* shader)
+{
+	for (int i = 0; i < MAX_TEXTURE_ARRAYS; i++)
+	{
+		shader->setInt("diffuseMaps[" + to_string(i) + "]", i);
+	}
+	shader->setBool("useBindless", bindless);
+}
+
+void MaterialLibrary::deleteResources()
+{
+	for (int i = 0; i < arrays.size(); i++)
+	{
+		if (arrays[i].handle != 0)
+		{
+			glMakeTextureHandleNonResidentARB(arrays[i].handle);
+		}
+		glDeleteTextures(1, &arrays[i].texture);
+	}
+
+	for (int i = 0; i < images.size(); i++)
+	{
+		stbi_image_free(images[i].pixels);
+	}
+
+	if (SSBO != 0)
+	{
+		glDeleteBuffers(1, &SSBO);
+		SSBO = 0;
+	}
+
+	materials.clear();
+	materialImages.clear();
+	images.clear();
+	arrays.clear();
+}
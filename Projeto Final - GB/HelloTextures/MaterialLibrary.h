@@ -0,0 +1,136 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "TextureCache.h"
+
+using namespace std;
+
+//Materiais e texturas difusas da cena. Imagens pequenas sao empacotadas em paginas de um
+//atlas (com borda para os mipmaps) e o material guarda a transformacao de UV ate a sua
+//regiao; as demais viram camadas de um GL_TEXTURE_2D_ARRAY por tamanho. Todos os arrays
+//sao ligados uma vez por quadro e o fragment shader encontra a textura pelo materialId.
+//Com GL_ARB_bindless_texture o shader usa os handles guardados no SSBO de materiais e
+//nao ha limite de arrays. Os mipmaps sao feitos em CPU (MipChain, filtro caixa no atlas
+//para as regioes nao se misturarem). Com compressao os arrays sao codificados em BC1/BC3
+//e guardados no TextureCache; nas execucoes seguintes as imagens nem sao decodificadas.
+//Com um orcamento de memoria os arrays sao transmitidos: cada um comeca em um mipmap
+//pequeno e ganha niveis conforme o tamanho na tela dos objetos que o usam
+class MaterialLibrary
+{
+public:
+	MaterialLibrary() {}
+	//Materiais iguais (mesmas propriedades e textura) recebem o mesmo identificador
+	int addMaterial(glm::vec3 ka, float kd, glm::vec3 ks, float ns, string texturePath);
+	//Monta o atlas, cria os arrays de textura e o SSBO; os pixels em CPU sao liberados.
+	//compress exige GL_EXT_texture_compression_s3tc
+	void upload(bool useBindless, bool compress);
+	//Liga os arrays nas unidades 0..n-1 e o SSBO de materiais
+	void bind(GLState& state);
+	//Uniforms do shader que nao mudam entre quadros
+	void setupShader(Shader* shader);
+	void deleteResources();
+	//Orcamento de VRAM para as texturas; 0 deixa todos os niveis residentes. Vale a partir
+	//do proximo upload, que entao mantem os niveis em memoria de CPU
+	void setTextureBudget(size_t bytes) { textureBudget = bytes; }
+	//Pedido do quadro para o material; screenSize e o diametro do objeto em pixels,
+	//negativo quando desconhecido (pede o nivel 0)
+	void requestResidency(int materialId, float screenSize);
+	//Atende os pedidos do quadro: um array sobe um nivel por quadro e, acima do orcamento,
+	//os arrays usados ha mais tempo perdem os niveis mais finos
+	void updateStreaming(GLState& state);
+	size_t getResidentSize();
+	size_t getTextureBudget() { return textureBudget; }
+	int getNbMaterials() { return materials.size(); }
+	int getNbTextureArrays() { return arrays.size(); }
+	bool isBindless() { return bindless; }
+	//Propriedades para quem desenha sem o SSBO (SoftwareRenderer): ka e kd em w, ks e q em w
+	glm::vec4 getAmbient(int materialId) { return materials[materialId].ka; }
+	glm::vec4 getSpecular(int materialId) { return materials[materialId].ks; }
+	//Arquivo da textura difusa; vazio se o material usa a textura branca
+	string getTexturePath(int materialId);
+
+	enum { MATERIALS_BINDING = 3, MAX_TEXTURE_ARRAYS = 8 };
+	//Imagens com os dois lados ate ATLAS_MAX_IMAGE vao para o atlas. A borda de ATLAS_GUTTER
+	//texels e o alinhamento de ATLAS_ALIGN mantem as regioes separadas ate ATLAS_MAX_LEVEL
+	enum { ATLAS_MAX_IMAGE = 1024, ATLAS_MAX_PAGE = 2048, ATLAS_GUTTER = 8, ATLAS_ALIGN = 16, ATLAS_MAX_LEVEL = 3 };
+	//Com streaming, o primeiro nivel residente de cada array e o primeiro com os dois lados ate esse tamanho
+	enum { STREAMING_START_SIZE = 64 };
+
+protected:
+	//Layout std430 do struct Material em sprite.fs
+	struct GPUMaterial
+	{
+		glm::vec4 ka; //w = kd
+		glm::vec4 ks; //w = q
+		glm::ivec4 texture; //array, camada, 1 se esta no atlas
+		glm::uvec4 handle; //xy = handle bindless do array
+		glm::vec4 uvTransform; //xy = escala, zw = deslocamento da regiao no atlas
+	};
+
+	struct Image
+	{
+		string path;
+		int width, height;
+		unsigned char* pixels;
+		int array, layer;
+		bool atlased;
+		bool found; //falso usa a textura branca
+		int x, y; //canto da regiao (com borda) na pagina do atlas
+	};
+
+	struct TextureArray
+	{
+		int width, height, nbLayers;
+		GLuint texture;
+		GLuint64 handle;
+		bool atlas;
+		int nbLevels;
+		size_t memorySize; //bytes em VRAM, com os mipmaps
+
+		//O objeto de textura so tem os niveis a partir de residentLevel; os demais ficam
+		//em levels (memoria de CPU) enquanto houver streaming
+		CompressedTexture levels;
+		int residentLevel;
+		int wantedLevel; //menor nivel pedido no quadro, nbLevels se nenhum
+		int lastUsedFrame;
+	};
+
+	int addImage(string path);
+	//Distribui as imagens pequenas nas paginas do atlas e as demais em arrays por tamanho
+	void packImages();
+	//Os pixels so sao decodificados quando o array nao esta no cache
+	void loadPixels(Image& image);
+	void freePixels(Image& image);
+	//Imagens de uma camada, com as bordas do atlas, em uma imagem RGBA do tamanho do array
+	void composeLayer(int array, int layer, vector<unsigned char>& pixels);
+	unsigned long long getCacheKey(int array);
+	void bakeArray(int array, CompressedTexture& texture);
+	//Niveis RGBA8 sem compressao, no mesmo layout do CompressedTexture
+	void buildLevels(int array, CompressedTexture& texture);
+	void uploadArray(int array, bool compress);
+	//Troca o objeto de textura do array por um com os niveis a partir de level
+	void createTexture(GLState& state, int array, int level);
+	size_t getLevelsSize(int array, int level);
+	bool planResidency(int candidate, int frame, vector<int>& planned);
+	void updateHandles(GLState& state);
+
+	vector<GPUMaterial> materials;
+	vector<int> materialImages; //imagem de cada material, resolvida em array/camada no upload
+	vector<Image> images;
+	vector<TextureArray> arrays;
+	vector<int> streamingCandidates, streamingLevels; //rascunho do updateStreaming, dimensionado no upload
+	TextureCache cache;
+	GLuint SSBO = 0;
+	bool bindless = false;
+	size_t textureBudget = 0;
+	int streamingFrame = 0;
+};
@@ -1,283 +1,537 @@
 #include "Mesh.h"
-#include "stb_image.h"
-#include "Bezier.h"
+#include "MappedFile.h"
+#include "TextParser.h"
 
-void Mesh::initialSceneConfig(string fileName, glm::vec3 position, float scale, float angle, string axis, vector<glm::vec3> controlPoints) {
-	this->fileName = fileName;
+void Mesh::initialSceneConfig(string fileName, glm::vec3 position, float scale, float angle, string axis, vector<glm::vec3> controlPoints, int nbInstances) {
+	if (!source)
+	{
+		source.reset(new MeshSource());
+	}
+
+	source->fileName = fileName;
+	source->controlPoints = move(controlPoints);
+	this->nbInstances = nbInstances;
 	this->position = position;
-	this->scale = glm::vec3(scale, scale, scale);
+	this->scale = scale;
 	this->angle = angle;
-	this->controlPoints = controlPoints;
 
 	if (axis == "X")
 	{
-		this->axis = glm::vec3(1.0, 0.0, 0.0);
+		this->axis = 0;
 	}
 	else if (axis == "Y")
 	{
-		this->axis = glm::vec3(0.0, 1.0, 0.0);
+		this->axis = 1;
 	}
 	else if (axis == "Z")
 	{
-		this->axis = glm::vec3(0.0, 0.0, 1.0);
+		this->axis = 2;
 	}
 }
 
-void Mesh::initialize(Shader* shader)
+void Mesh::setPathConfig(string curveType, bool closedCurve, string parameterization, float pathPhase) {
+	source->curveType = curveType;
+	source->closedCurve = closedCurve;
+	source->parameterization = parameterization;
+	this->pathPhase = pathPhase;
+}
+
+void Mesh::initialize(Shader* shader, CurveRegistry* curveRegistry, MaterialLibrary* materials, Arena& scratch, bool keepGeometry)
 {
 	this->shader = shader;
+	this->curveRegistry = curveRegistry;
 
-	loadOBJ();
-	loadMTL();
-	loadTexture();
-	setupSprite();
+	//Os temporarios da carga ficam no arena e sao descartados ao final
+	size_t marker = scratch.getMarker();
+	MeshGeometry geometry;
 
-	if (controlPoints.size() > 0) {
-		Bezier bezier;
-		this->bezier = bezier;
-		this->bezier.setControlPoints(controlPoints);
-		this->bezier.setShader(shader);
-		this->bezier.generateCurve(100);
-		nbCurvePoints = this->bezier.getNbCurvePoints();
+	string mtlFilePath = loadOBJ(scratch, geometry);
+	materialId = loadMTL(mtlFilePath, materials);
+	setupSprite(geometry);
+	keepGeometry = keepGeometry || !shader;
+
+	if (source->controlPoints.size() > 0) {
+		path = curveRegistry->acquire(source->curveType, source->parameterization, source->closedCurve, source->controlPoints);
+	}
+
+	//Depois do envio para a GPU o objeto guarda apenas os identificadores
+	if (keepGeometry)
+	{
+		source->positions.assign(geometry.positions, geometry.positions + nbVertices * 3);
+		source->textureCoords.assign(geometry.textureCoords, geometry.textureCoords + nbVertices * 2);
+		source->normals.assign(geometry.normals, geometry.normals + nbVertices * 3);
+	}
+	else
+	{
+		source.reset();
 	}
+
+	scratch.rewind(marker);
+}
+
+Mesh::Mesh(Mesh&& other) noexcept
+{
+	moveFrom(other);
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		moveFrom(other);
+	}
+	return *this;
+}
+
+//Copia os campos e deixa o outro objeto sem recursos, para que o destrutor dele nao libere nada
+void Mesh::moveFrom(Mesh& other)
+{
+	VAO = other.VAO;
+	depthVAO = other.depthVAO;
+	for (int i = 0; i < 3; i++)
+	{
+		VBO[i] = other.VBO[i];
+		other.VBO[i] = 0;
+	}
+	materialId = other.materialId;
+	nbVertices = other.nbVertices;
+	position = other.position;
+	scale = other.scale;
+	angle = other.angle;
+	boundingRadius = other.boundingRadius;
+	axis = other.axis;
+	shader = other.shader;
+	curveRegistry = other.curveRegistry;
+	path = other.path;
+	pathPhase = other.pathPhase;
+	nbInstances = other.nbInstances;
+	source = move(other.source);
+
+	other.VAO = 0;
+	other.depthVAO = 0;
+	other.path = -1;
 }
 
 void Mesh::updatePosition(glm::vec3 position) {
 	this->position = position;
 }
 
-void Mesh::update()
+void Mesh::update(Shader* program)
 {
-	if (controlPoints.size() > 0) {
-		glm::vec3 pointOnCurve = bezier.getPointOnCurve(curvePointIndex);
-		this->position = pointOnCurve;
-		curvePointIndex = (curvePointIndex + 1) % nbCurvePoints;
+	if (!program)
+	{
+		program = shader;
 	}
 
+	//Em trajetoria a posicao e calculada no vertex shader a partir do CurveBuffer
+	program->setBool("usePath", path >= 0);
+
+	if (path >= 0)
+	{
+		program->setInt("pathCurve", curveRegistry->getCurveId(path));
+		program->setFloat("pathPhase", pathPhase);
+		program->setFloat("pathPhaseStep", 1.0f / nbInstances);
+	}
+	glm::mat4 model = getModelMatrix();
+	program->setMat4("model", glm::value_ptr(model));
+}
+
+glm::mat4 Mesh::getModelMatrix()
+{
 	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, position);
-	model = glm::rotate(model, glm::radians(angle), axis);
-	model = glm::scale(model, scale);
-	shader->setMat4("model", glm::value_ptr(model));
+	if (path < 0)
+	{
+		model = glm::translate(model, position);
+	}
+	glm::vec3 rotationAxis(0.0f);
+	rotationAxis[axis] = 1.0f;
+	model = glm::rotate(model, glm::radians(angle), rotationAxis);
+	model = glm::scale(model, glm::vec3(scale));
+	return model;
 }
 
-void Mesh::draw()
+glm::vec3 Mesh::getPathOffset(int instance, float pathTime)
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glBindVertexArray(VAO);
-	shader->setVec3("ka", ka[0], ka[1], ka[2]);
-	shader->setFloat("kd", kd);
-	shader->setVec3("ks", ks[0], ks[1], ks[2]);
-	shader->setFloat("q", ns);
-	glDrawArrays(GL_TRIANGLES, 0, positions.size() / 3);
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	if (path < 0)
+	{
+		return glm::vec3(0.0f);
+	}
+
+	//pointOnCurve de sprite.vs: um segmento por segundo, instancias defasadas de 1/nbInstances
+	Curve* curve = curveRegistry->getCurve(path);
+	float nSegments = (float)curve->getNbSegments();
+	float t = pathTime / nSegments + pathPhase + instance * (1.0f / nbInstances);
+	t -= floor(t);
+	float ft = glm::clamp(t, 0.0f, 1.0f) * nSegments;
+	float segment = min(floor(ft), nSegments - 1.0f);
+	float u = ft - segment;
+	return curve->getSegmentCoefficients((int)segment) * glm::vec4(u * u * u, u * u, u, 1.0f);
 }
 
-void Mesh::deleteVertexArray() {
-	glDeleteVertexArrays(1, &VAO);
+void Mesh::draw(GLState& state, bool setMaterial, Shader* program)
+{
+	//As texturas de todos os materiais ja estao ligadas (MaterialLibrary::bind)
+	state.bindVertexArray(VAO);
+	if (setMaterial)
+	{
+		(program ? program : shader)->setInt("materialId", materialId);
+	}
+	glDrawArraysInstanced(GL_TRIANGLES, 0, nbVertices, nbInstances);
 }
 
-void Mesh::loadOBJ()
+void Mesh::drawDepth(GLState& state)
 {
-	vector<glm::vec3> vertexIndices;
-	vector<glm::vec2> textureIndices;
-	vector<glm::vec3> normalIndices;
+	state.bindVertexArray(depthVAO);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, nbVertices, nbInstances);
+}
 
-	ifstream file("../objects/" + fileName);
-	if (!file.is_open())
+void Mesh::getBoundingSphere(float pathTime, glm::vec3& center, float& radius)
+{
+	//A rotacao e a escala sao em torno da origem do modelo, entao a esfera de raio
+	//boundingRadius * scale fica centrada na posicao de cada instancia
+	float objectRadius = boundingRadius * scale;
+	if (path < 0)
 	{
-		cerr << "Failed to open file: " << fileName << endl;
+		center = position;
+		radius = objectRadius;
 		return;
 	}
 
-	string line;
-	while (getline(file, line))
+	glm::vec3 boundsMin = getPathOffset(0, pathTime), boundsMax = boundsMin;
+	for (int i = 1; i < nbInstances; i++)
 	{
-		istringstream iss(line);
-		string prefix;
-		iss >> prefix;
+		glm::vec3 offset = getPathOffset(i, pathTime);
+		boundsMin = glm::min(boundsMin, offset);
+		boundsMax = glm::max(boundsMax, offset);
+	}
+	center = (boundsMin + boundsMax) * 0.5f;
+	radius = glm::length(boundsMax - boundsMin) * 0.5f + objectRadius;
+}
 
-		if (prefix == "mtllib")
-		{
-			iss >> mtlFilePath;
-		}
-		else if (prefix == "v")
+void Mesh::getPathBounds(glm::vec3& center, float& radius)
+{
+	float objectRadius = boundingRadius * scale;
+	if (path < 0)
+	{
+		center = position;
+		radius = objectRadius;
+		return;
+	}
+
+	//Cada segmento a u^3 + b u^2 + c u + d, com u em [0, 1], fica no fecho convexo dos seus
+	//pontos de controle de Bezier, qualquer que seja o tipo da curva
+	Curve* curve = curveRegistry->getCurve(path);
+	glm::vec3 boundsMin(getPathOffset(0, 0.0f)), boundsMax = boundsMin;
+	for (int segment = 0; segment < curve->getNbSegments(); segment++)
+	{
+		glm::mat4x3 coefficients = curve->getSegmentCoefficients(segment);
+		glm::vec3 a = coefficients[0], b = coefficients[1], c = coefficients[2], d = coefficients[3];
+		glm::vec3 points[4] = { d, d + c / 3.0f, d + (2.0f * c + b) / 3.0f, a + b + c + d };
+		for (const glm::vec3& point : points)
 		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			vertexIndices.push_back(glm::vec3(x, y, z));
+			boundsMin = glm::min(boundsMin, point);
+			boundsMax = glm::max(boundsMax, point);
 		}
-		else if (prefix == "vt")
+	}
+	center = (boundsMin + boundsMax) * 0.5f;
+	radius = glm::length(boundsMax - boundsMin) * 0.5f + objectRadius;
+}
+
+uint64_t Mesh::getSortKey(const glm::mat4& view, float farPlane)
+{
+	//Objetos em trajetoria sao posicionados no vertex shader; ficam na frente
+	float depth = 0.0f;
+	if (path < 0)
+	{
+		depth = -(view * glm::vec4(position, 1.0f)).z / farPlane;
+	}
+
+	return RenderQueue::makeKey(shader->ID, materialId, VAO, depth);
+}
+
+float Mesh::getScreenSize(const glm::mat4& view, const glm::mat4& projection, int viewportHeight)
+{
+	if (path >= 0)
+	{
+		return -1.0f;
+	}
+
+	//Atras da camera nao aparece; projection[1][1] = 1 / tan(fov / 2)
+	float depth = -(view * glm::vec4(position, 1.0f)).z;
+	if (depth <= 0.0f)
+	{
+		return 0.0f;
+	}
+	return boundingRadius * scale * projection[1][1] / depth * viewportHeight;
+}
+
+void Mesh::release() {
+	if (VAO != 0)
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteVertexArrays(1, &depthVAO);
+		glDeleteBuffers(3, VBO);
+		VAO = 0;
+		depthVAO = 0;
+		VBO[0] = VBO[1] = VBO[2] = 0;
+	}
+
+	if (path >= 0)
+	{
+		curveRegistry->release(path);
+		path = -1;
+	}
+}
+
+//Le um indice v, v/t, v//n ou v/t/n; indices negativos sao relativos ao fim da lista
+static void parseFaceVertex(const char*& p, const char* end, int counts[3], int indices[3])
+{
+	for (int k = 0; k < 3; k++)
+	{
+		int index = 0;
+		if (parseInt(p, end, index))
 		{
-			float u, v;
-			iss >> u >> v;
-			textureIndices.push_back(glm::vec2(u, v));
+			indices[k] = index < 0 ? counts[k] + index : index - 1;
 		}
-		else if (prefix == "vn")
+		else
 		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			normalIndices.push_back(glm::vec3(x, y, z));
+			indices[k] = -1;
 		}
-		else if (prefix == "f")
-		{
-			string v1, v2, v3;
-			iss >> v1 >> v2 >> v3;
-
-			glm::ivec3 vIndices, tIndices, nIndices;
-			istringstream(v1.substr(0, v1.find('/'))) >> vIndices.x;
-			istringstream(v1.substr(v1.find('/') + 1, v1.rfind('/') - v1.find('/') - 1)) >> tIndices.x;
-			istringstream(v1.substr(v1.rfind('/') + 1)) >> nIndices.x;
-			istringstream(v2.substr(0, v2.find('/'))) >> vIndices.y;
-			istringstream(v2.substr(v2.find('/') + 1, v2.rfind('/') - v2.find('/') - 1)) >> tIndices.y;
-			istringstream(v2.substr(v2.rfind('/') + 1)) >> nIndices.y;
-			istringstream(v3.substr(0, v3.find('/'))) >> vIndices.z;
-			istringstream(v3.substr(v3.find('/') + 1, v3.rfind('/') - v3.find('/') - 1)) >> tIndices.z;
-			istringstream(v3.substr(v3.rfind('/') + 1)) >> nIndices.z;
 
-			for (int i = 0; i < 3; i++)
+		if (p == end || *p != '/')
+		{
+			for (k++; k < 3; k++)
 			{
-				const glm::vec3& vertex = vertexIndices[vIndices[i] - 1];
-				const glm::vec2& texture = textureIndices[tIndices[i] - 1];
-				const glm::vec3& normal = normalIndices[nIndices[i] - 1];
-
-				positions.push_back(vertex.x);
-				positions.push_back(vertex.y);
-				positions.push_back(vertex.z);
-				textureCoords.push_back(texture.x);
-				textureCoords.push_back(texture.y);
-				normals.push_back(normal.x);
-				normals.push_back(normal.y);
-				normals.push_back(normal.z);
+				indices[k] = -1;
 			}
+			return;
 		}
+		p++;
 	}
-
-	file.close();
 }
 
-void Mesh::loadMTL()
+//Duas passadas sobre o arquivo mapeado: a primeira conta as linhas de cada tipo para
+//alocar tudo de uma vez no arena, a segunda preenche os arrays
+string Mesh::loadOBJ(Arena& scratch, MeshGeometry& geometry)
 {
-	string line, readValue;
-	ifstream mtlFile("../objects/" + mtlFilePath);
+	string mtlFilePath;
+	geometry = MeshGeometry();
 
-	while (!mtlFile.eof())
+	MappedFile file;
+	if (!file.open("../objects/" + source->fileName))
 	{
-		getline(mtlFile, line);
+		return mtlFilePath;
+	}
 
-		istringstream iss(line);
+	const char* begin = file.getData();
+	const char* end = begin + file.getSize();
+	int nbV = 0, nbVt = 0, nbVn = 0, nbFaces = 0;
 
-		if (line.find("map_Kd") == 0)
+	for (const char* p = begin; p < end; skipLine(p, end))
+	{
+		skipSpaces(p, end);
+		if (p + 1 < end && p[0] == 'v' && isSpace(p[1]))
 		{
-			iss >> readValue >> textureFilePath;
+			nbV++;
 		}
-		else if (line.find("Ka") == 0)
+		else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
 		{
-			float ka1, ka2, ka3;
-			iss >> readValue >> ka1 >> ka2 >> ka3;
-			ka.push_back(ka1);
-			ka.push_back(ka2);
-			ka.push_back(ka3);
+			nbVt++;
 		}
-		else if (line.find("Ks") == 0)
+		else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
 		{
-			float ks1, ks2, ks3;
-			iss >> readValue >> ks1 >> ks2 >> ks3;
-			ks.push_back(ks1);
-			ks.push_back(ks2);
-			ks.push_back(ks3);
+			nbVn++;
 		}
-		else if (line.find("Ns") == 0)
+		else if (p + 1 < end && p[0] == 'f' && isSpace(p[1]))
 		{
-			iss >> readValue >> ns;
+			nbFaces++;
 		}
 	}
 
-	if (ka.size() == 0) {
-		ka.push_back(1.0f);
-		ka.push_back(1.0f);
-		ka.push_back(1.0f);
+	glm::vec3* vertices = scratch.push<glm::vec3>(nbV);
+	glm::vec2* textures = scratch.push<glm::vec2>(nbVt);
+	glm::vec3* normalList = scratch.push<glm::vec3>(nbVn);
+	geometry.positions = scratch.push<GLfloat>(nbFaces * 9);
+	geometry.textureCoords = scratch.push<GLfloat>(nbFaces * 6);
+	geometry.normals = scratch.push<GLfloat>(nbFaces * 9);
+
+	if (!vertices || !textures || !normalList || !geometry.positions || !geometry.textureCoords || !geometry.normals)
+	{
+		geometry = MeshGeometry();
+		return mtlFilePath;
 	}
 
-	if (ks.size() == 0) {
-		ks.push_back(0.5f);
-		ks.push_back(0.5f);
-		ks.push_back(0.5f);
+	int counts[3] = { 0, 0, 0 };
+	int invalidFaces = 0;
+	GLfloat* positions = geometry.positions;
+	GLfloat* textureCoords = geometry.textureCoords;
+	GLfloat* normals = geometry.normals;
+
+	for (const char* p = begin; p < end; skipLine(p, end))
+	{
+		const char* token;
+		size_t length = readToken(p, end, token);
+
+		if (isKeyword(token, length, "mtllib"))
+		{
+			length = readToken(p, end, token);
+			mtlFilePath.assign(token, length);
+		}
+		else if (isKeyword(token, length, "v"))
+		{
+			glm::vec3& vertex = vertices[counts[0]++];
+			vertex = glm::vec3(0.0f);
+			parseVec3(p, end, vertex);
+		}
+		else if (isKeyword(token, length, "vt"))
+		{
+			glm::vec2& texture = textures[counts[1]++];
+			texture = glm::vec2(0.0f);
+			parseVec2(p, end, texture);
+		}
+		else if (isKeyword(token, length, "vn"))
+		{
+			glm::vec3& normal = normalList[counts[2]++];
+			normal = glm::vec3(0.0f);
+			parseVec3(p, end, normal);
+		}
+		else if (isKeyword(token, length, "f"))
+		{
+			int indices[3][3];
+			bool valid = true;
+
+			for (int i = 0; i < 3; i++)
+			{
+				skipSpaces(p, end);
+				parseFaceVertex(p, end, counts, indices[i]);
+				valid = valid && indices[i][0] >= 0 && indices[i][0] < counts[0] && indices[i][1] < counts[1] && indices[i][2] < counts[2];
+			}
+
+			if (!valid)
+			{
+				invalidFaces++;
+				continue;
+			}
+
+			//Componentes ausentes (v//n, v/t) ficam zeradas
+			for (int i = 0; i < 3; i++)
+			{
+				const glm::vec3& vertex = vertices[indices[i][0]];
+				glm::vec2 texture = indices[i][1] >= 0 ? textures[indices[i][1]] : glm::vec2(0.0f);
+				glm::vec3 normal = indices[i][2] >= 0 ? normalList[indices[i][2]] : glm::vec3(0.0f);
+
+				*positions++ = vertex.x;
+				*positions++ = vertex.y;
+				*positions++ = vertex.z;
+				*textureCoords++ = texture.x;
+				*textureCoords++ = texture.y;
+				*normals++ = normal.x;
+				*normals++ = normal.y;
+				*normals++ = normal.z;
+			}
+		}
 	}
 
-	mtlFile.close();
-}
+	if (invalidFaces > 0)
+	{
+		cerr << source->fileName << ": " << invalidFaces << " faces with invalid indices skipped" << endl;
+	}
 
-void Mesh::loadTexture()
-{
-	string path = "../textures/" + textureFilePath;
-	GLuint texID;
+	geometry.nbVertices = (positions - geometry.positions) / 3;
 
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
+	return mtlFilePath;
+}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+int Mesh::loadMTL(string mtlFilePath, MaterialLibrary* materials)
+{
+	string textureFilePath;
+	bool readKa = false, readKs = false;
+	glm::vec3 ka(1.0f), ks(0.5f);
+	float ns = 250.0f, kd = 0.5f;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	MappedFile file;
+	if (mtlFilePath.empty() || !file.open("../objects/" + mtlFilePath))
+	{
+		return materials->addMaterial(ka, kd, ks, ns, textureFilePath);
+	}
 
-	int width, height, nrChannels;
-	unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+	const char* p = file.getData();
+	const char* end = p + file.getSize();
 
-	if (data)
+	for (; p < end; skipLine(p, end))
 	{
-		if (nrChannels == 3)
+		const char* token;
+		size_t length = readToken(p, end, token);
+
+		if (isKeyword(token, length, "map_Kd"))
 		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+			length = readToken(p, end, token);
+			textureFilePath.assign(token, length);
 		}
-		else
+		//Vale o primeiro material do arquivo
+		else if (isKeyword(token, length, "Ka") && !readKa)
 		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+			readKa = parseVec3(p, end, ka);
+		}
+		else if (isKeyword(token, length, "Ks") && !readKs)
+		{
+			readKs = parseVec3(p, end, ks);
+		}
+		else if (isKeyword(token, length, "Ns"))
+		{
+			parseFloat(p, end, ns);
 		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		cout << "Failed to load texture" << endl;
 	}
-	stbi_image_free(data);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	textureID = texID;
+
+	return materials->addMaterial(ka, kd, ks, ns, textureFilePath);
 }
 
-void Mesh::setupSprite()
+void Mesh::setupSprite(const MeshGeometry& geometry)
 {
-	GLuint VAO, VBO[3];
+	nbVertices = geometry.nbVertices;
+
+	boundingRadius = 0.0f;
+	for (int i = 0; i < nbVertices; i++)
+	{
+		const GLfloat* v = geometry.positions + i * 3;
+		boundingRadius = max(boundingRadius, glm::length(glm::vec3(v[0], v[1], v[2])));
+	}
+
+	if (!shader)
+	{
+		return;
+	}
 
 	glGenVertexArrays(1, &VAO);
-	glGenBuffers(2, VBO);
+	glGenBuffers(3, VBO);
 
 	glBindVertexArray(VAO);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(GLfloat), positions.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, nbVertices * 3 * sizeof(GLfloat), geometry.positions, GL_STATIC_DRAW);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 	glEnableVertexAttribArray(0);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
-	glBufferData(GL_ARRAY_BUFFER, textureCoords.size() * sizeof(GLfloat), textureCoords.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, nbVertices * 2 * sizeof(GLfloat), geometry.textureCoords, GL_STATIC_DRAW);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
 	glEnableVertexAttribArray(1);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO[2]);
-	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(GLfloat), normals.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, nbVertices * 3 * sizeof(GLfloat), geometry.normals, GL_STATIC_DRAW);
 	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
 	glEnableVertexAttribArray(2);
 
+	//Passos de profundidade leem so as posicoes: 12 bytes por vertice em um unico stream
+	glGenVertexArrays(1, &depthVAO);
+	glBindVertexArray(depthVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(0);
+
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
-
-	glEnable(GL_DEPTH_TEST);
-
-	this->VAO = VAO;
 }
 
 void Mesh::scaleDown() {
@@ -297,15 +551,15 @@ void Mesh::decreaseAngle() {
 }
 
 void Mesh::rotateX() {
-	axis = glm::vec3(1.0, 0.0, 0.0);
+	axis = 0;
 }
 
 void Mesh::rotateY() {
-	axis = glm::vec3(0.0, 1.0, 0.0);
+	axis = 1;
 }
 
 void Mesh::rotateZ() {
-	axis = glm::vec3(0.0, 0.0, 1.0);
+	axis = 2;
 }
 
 void Mesh::translateX(float distance) {
@@ -318,4 +572,17 @@ void Mesh::translateY(float distance) {
 
 void Mesh::translateZ(float distance) {
 	position.z += distance;
+}
+
+void Mesh::moveControlPoint(int index, glm::vec3 offset) {
+	if (path < 0)
+	{
+		return;
+	}
+
+	curveRegistry->moveControlPoint(path, index, offset);
+}
+
+int Mesh::getNbControlPoints() {
+	return path >= 0 ? curveRegistry->getCurve(path)->getNbControlPoints() : 0;
 }
\ No newline at end of file
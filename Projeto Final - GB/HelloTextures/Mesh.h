@@ -7,23 +7,62 @@
 
 #include "Shader.h"
 #include <vector>
-#include "Bezier.h"
+#include <memory>
+#include "CurveRegistry.h"
+#include "Arena.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "MaterialLibrary.h"
 
+//Dados usados apenas na carga do objeto; liberados depois do envio para a GPU,
+//a menos que a geometria seja mantida (keepGeometry)
+struct MeshSource
+{
+	string fileName;
+	string curveType = "bezier", parameterization = "centripetal";
+	bool closedCurve = false;
+	vector<glm::vec3> controlPoints;
+	vector<GLfloat> positions, textureCoords, normals;
+};
+
+//Arrays de vertices expandidos por triangulo, alocados no arena de carga
+struct MeshGeometry
+{
+	GLfloat* positions = nullptr;
+	GLfloat* textureCoords = nullptr;
+	GLfloat* normals = nullptr;
+	int nbVertices = 0;
+};
+
+//Handle de um objeto da cena: dono do VAO, dos VBOs e da textura, so pode ser movido
 class Mesh
 {
 public:
 	Mesh() {}
-	~Mesh() {}
-	void initialSceneConfig(string fileName, glm::vec3 position, float scale, float angle, string axis, vector<glm::vec3> controlPoints);
-	void initialize(Shader* shader);
-	void update();
-	void draw();
+	~Mesh() { release(); }
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+	Mesh(Mesh&& other) noexcept;
+	Mesh& operator=(Mesh&& other) noexcept;
+	void initialSceneConfig(string fileName, glm::vec3 position, float scale, float angle, string axis, vector<glm::vec3> controlPoints, int nbInstances = 1);
+	void setPathConfig(string curveType, bool closedCurve, string parameterization, float pathPhase = 0.0f);
+	//Sem shader o objeto e so para o SoftwareRenderer: nao cria buffers na GPU e mantem a geometria
+	void initialize(Shader* shader, CurveRegistry* curveRegistry, MaterialLibrary* materials, Arena& scratch, bool keepGeometry = false);
+	//Envia a trajetoria e a matriz model ao shader do objeto ou, se informado, a outro com
+	//os mesmos uniforms (o de profundidade da ShadowMap)
+	void update(Shader* program = nullptr);
+	//Binds passam pelo GLState; o materialId so e enviado se setMaterial, ao shader do objeto
+	//ou ao programa informado (o do G-buffer do DeferredRenderer)
+	void draw(GLState& state, bool setMaterial = true, Shader* program = nullptr);
+	//So as posicoes, com o VAO de profundidade; o programa em uso faz o resto
+	void drawDepth(GLState& state);
 	void updatePosition(glm::vec3 position);
-	void loadOBJ();
-	void loadMTL();
-	void loadTexture();
-	void setupSprite();
-	void deleteVertexArray();
+	string loadOBJ(Arena& scratch, MeshGeometry& geometry);
+	//Registra o material do arquivo na MaterialLibrary e retorna o identificador
+	int loadMTL(string mtlFilePath, MaterialLibrary* materials);
+	void setupSprite(const MeshGeometry& geometry);
+	//Libera os recursos de GPU e a trajetoria; chamado pelo destrutor
+	void release();
 	void scaleDown();
 	void scaleUp();
 	void increaseAngle();
@@ -34,28 +73,52 @@ public:
 	void translateX(float distance);
 	void translateY(float distance);
 	void translateZ(float distance);
+	int getNbControlPoints();
+	void moveControlPoint(int index, glm::vec3 offset);
+	GLuint getProgram() { return shader->ID; }
+	GLuint getVertexArray() { return VAO; }
+	int getMaterialId() { return materialId; }
+	int getNbInstances() { return nbInstances; }
+	//Em trajetoria a matriz nao tem a translacao; a posicao vem de getPathOffset
+	glm::mat4 getModelMatrix();
+	//Mesmo deslocamento que o vertex shader soma a posicao da instancia no tempo pathTime
+	glm::vec3 getPathOffset(int instance, float pathTime);
+	//Esfera que contem todas as instancias no tempo pathTime, no mundo
+	void getBoundingSphere(float pathTime, glm::vec3& center, float& radius);
+	//Esfera que contem o objeto em qualquer instante: a trajetoria inteira, nao so as instancias
+	void getPathBounds(glm::vec3& center, float& radius);
+	//Chave da RenderQueue; a profundidade e a distancia ao longo da camera dividida por farPlane
+	uint64_t getSortKey(const glm::mat4& view, float farPlane);
+	//Diametro aproximado do objeto na tela, em pixels; -1 para objetos em trajetoria,
+	//cuja posicao so o vertex shader conhece
+	float getScreenSize(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+	//Geometria em CPU, disponivel apenas com keepGeometry
+	const MeshSource* getSource() { return source.get(); }
 
 protected:
-	string fileName = "", mtlFilePath = "", textureFilePath = "";
-
-	vector<GLfloat> positions, textureCoords, normals, ka, ks;
-	float ns = 250.0f, kd = 0.5f;
-	vector <glm::vec3> controlPoints;
+	void moveFrom(Mesh& other);
 
-	GLuint VAO; //Identificador do VAO
+	GLuint VAO = 0; //Identificador do VAO
+	GLuint depthVAO = 0; //So o atributo 0, lido do VBO[0]
+	GLuint VBO[3] = { 0, 0, 0 };
+	GLsizei nbVertices = 0;
 
 	//Informaes sobre as transformaes a serem aplicadas no objeto
 	glm::vec3 position;
-	glm::vec3 scale;
-	float angle;
-	glm::vec3 axis;
+	float scale = 1.0f;
+	float angle = 0.0f;
+	float boundingRadius = 1.0f; //maior distancia de um vertice a origem do modelo
+	int axis = 2; //0 = X, 1 = Y, 2 = Z
+
+	int materialId = 0;
 
 	//Referncia do shader
-	Shader* shader;
+	Shader* shader = nullptr;
 
-	GLuint textureID;
-	Bezier bezier;
-	int nbCurvePoints;
-	int curvePointIndex = 0;
-};
+	CurveRegistry* curveRegistry = nullptr;
+	int path = -1; //Trajetoria compartilhada no CurveRegistry
+	float pathPhase = 0.0f;
+	int nbInstances = 1;
 
+	unique_ptr<MeshSource> source;
+};
@@ -0,0 +1,248 @@
+#include "MipChain.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+int MipChain::getNbLevels(int width, int height)
+{
+	int nbLevels = 1;
+	while (width > 1 || height > 1)
+	{
+		width = max(1, width / 2);
+		height = max(1, height / 2);
+		nbLevels++;
+	}
+	return nbLevels;
+}
+
+//Conversoes sRGB <-> linear por tabela; a volta usa 12 bits de linear, mais fino
+//que o passo de 8 bits do sRGB mesmo nos tons escuros
+struct SRGBTables
+{
+	enum { ENCODE_SIZE = 4096 };
+
+	float decode[256];
+	unsigned char encode[ENCODE_SIZE];
+
+	SRGBTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			float c = i / 255.0f;
+			decode[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		for (int i = 0; i < ENCODE_SIZE; i++)
+		{
+			float l = i / (float)(ENCODE_SIZE - 1);
+			float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+			encode[i] = (unsigned char)(c * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const SRGBTables srgbTables;
+
+//Contribuicoes de um eixo: cada texel de destino soma count taps a partir de first.
+//position e a coordenada de origem antes de repetir a imagem; source ja repetida
+struct FilterTaps
+{
+	int size;
+	vector<int> first, count;
+	vector<int> position, source;
+	vector<float> weight;
+};
+
+static float kaiserWindow(float x, float alpha)
+{
+	//I0 pela serie de potencias, suficiente para alpha pequeno
+	auto besselI0 = [](float v)
+	{
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 16; k++)
+		{
+			term *= (v / (2.0f * k)) * (v / (2.0f * k));
+			sum += term;
+		}
+		return sum;
+	};
+
+	if (fabsf(x) > 1.0f)
+	{
+		return 0.0f;
+	}
+	return besselI0(alpha * sqrtf(1.0f - x * x)) / besselI0(alpha);
+}
+
+static float filterWeight(MipFilter filter, float d)
+{
+	const float kaiserRadius = 4.0f, kaiserAlpha = 4.0f;
+
+	if (filter == MIP_BOX)
+	{
+		return fabsf(d) < 1.0f ? 1.0f : 0.0f;
+	}
+
+	//d em texels de origem para reducao 2x; o sinc corta em metade da frequencia
+	float sinc = d == 0.0f ? 1.0f : sinf(3.14159265f * d * 0.5f) / (3.14159265f * d * 0.5f);
+	return sinc * kaiserWindow(d / kaiserRadius, kaiserAlpha);
+}
+
+//Taps de srcSize -> dstSize texels. Texels fora da imagem repetem pelo lado oposto,
+//como o GL_REPEAT usado no visualizador
+static void buildTaps(MipFilter filter, int srcSize, int dstSize, FilterTaps& taps)
+{
+	float scale = (float)srcSize / dstSize;
+	float radius = (filter == MIP_BOX ? 1.0f : 4.0f) * scale * 0.5f;
+
+	taps.size = srcSize;
+	taps.first.resize(dstSize);
+	taps.count.resize(dstSize);
+	taps.position.clear();
+	taps.source.clear();
+	taps.weight.clear();
+
+	for (int x = 0; x < dstSize; x++)
+	{
+		float center = (x + 0.5f) * scale;
+		int first = taps.source.size();
+		float total = 0.0f;
+
+		for (int s = (int)floorf(center - radius); s < center + radius; s++)
+		{
+			float w = filterWeight(filter, (s + 0.5f - center) / (scale * 0.5f));
+			if (w != 0.0f)
+			{
+				taps.position.push_back(s);
+				taps.source.push_back(((s % srcSize) + srcSize) % srcSize);
+				taps.weight.push_back(w);
+				total += w;
+			}
+		}
+
+		for (int i = first; i < taps.source.size(); i++)
+		{
+			taps.weight[i] /= total;
+		}
+
+		taps.first[x] = first;
+		taps.count[x] = taps.source.size() - first;
+	}
+}
+
+static __m128 decodeTexel(const unsigned char* texel)
+{
+	return _mm_setr_ps(srgbTables.decode[texel[0]], srgbTables.decode[texel[1]], srgbTables.decode[texel[2]], texel[3] * (1.0f / 255.0f));
+}
+
+static void encodeTexel(__m128 color, unsigned char* texel)
+{
+	alignas(16) float c[4];
+	color = _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	_mm_store_ps(c, _mm_mul_ps(color, _mm_setr_ps(SRGBTables::ENCODE_SIZE - 1, SRGBTables::ENCODE_SIZE - 1, SRGBTables::ENCODE_SIZE - 1, 255.0f)));
+
+	for (int i = 0; i < 3; i++)
+	{
+		texel[i] = srgbTables.encode[(int)(c[i] + 0.5f)];
+	}
+	texel[3] = (unsigned char)(c[3] + 0.5f);
+}
+
+//Linhas [firstRow, lastRow) do destino: filtra na horizontal as linhas de origem que
+//elas usam (um texel RGBA por registrador) e depois combina essas linhas na vertical
+static void downsampleRows(const unsigned char* src, int srcWidth, unsigned char* dst, int dstWidth,
+	const FilterTaps* tapsX, const FilterTaps* tapsY, int firstRow, int lastRow)
+{
+	//Linhas de origem usadas pela faixa, antes de repetir a imagem: nas bordas a mesma
+	//linha pode aparecer duas vezes, no meio cada uma e filtrada uma vez so
+	int firstPosition = tapsY->position[tapsY->first[firstRow]];
+	int lastPosition = tapsY->position[tapsY->first[lastRow - 1] + tapsY->count[lastRow - 1] - 1] + 1;
+
+	vector<float> rows((size_t)(lastPosition - firstPosition) * dstWidth * 4);
+	vector<float> linear((size_t)srcWidth * 4);
+
+	for (int p = firstPosition; p < lastPosition; p++)
+	{
+		//A linha de origem e convertida para linear uma vez so; cada texel entra em varios taps
+		const unsigned char* srcRow = src + (size_t)(((p % tapsY->size) + tapsY->size) % tapsY->size) * srcWidth * 4;
+		for (int x = 0; x < srcWidth; x++)
+		{
+			_mm_storeu_ps(&linear[x * 4], decodeTexel(srcRow + x * 4));
+		}
+
+		float* row = &rows[(size_t)(p - firstPosition) * dstWidth * 4];
+		for (int x = 0; x < dstWidth; x++)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (int i = tapsX->first[x]; i < tapsX->first[x] + tapsX->count[x]; i++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tapsX->weight[i]), _mm_loadu_ps(&linear[tapsX->source[i] * 4])));
+			}
+			_mm_storeu_ps(row + x * 4, sum);
+		}
+	}
+
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		unsigned char* dstRow = dst + (size_t)y * dstWidth * 4;
+
+		for (int x = 0; x < dstWidth; x++)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (int t = tapsY->first[y]; t < tapsY->first[y] + tapsY->count[y]; t++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tapsY->weight[t]), _mm_loadu_ps(&rows[((size_t)(tapsY->position[t] - firstPosition) * dstWidth + x) * 4])));
+			}
+			encodeTexel(sum, dstRow + x * 4);
+		}
+	}
+}
+
+void MipChain::build(const unsigned char* rgba, int width, int height, int nbLevels, MipFilter filter, int nbThreads)
+{
+	base = rgba;
+	this->width = width;
+	this->height = height;
+	levels.resize(max(0, nbLevels - 1));
+
+	if (nbThreads <= 0)
+	{
+		nbThreads = max(1, (int)thread::hardware_concurrency());
+	}
+
+	FilterTaps tapsX, tapsY;
+
+	for (int i = 0; i < levels.size(); i++)
+	{
+		Level& level = levels[i];
+		level.width = max(1, getWidth(i) / 2);
+		level.height = max(1, getHeight(i) / 2);
+		level.pixels.resize((size_t)level.width * level.height * 4);
+
+		buildTaps(filter, getWidth(i), level.width, tapsX);
+		buildTaps(filter, getHeight(i), level.height, tapsY);
+
+		//Faixas de pelo menos 32 linhas. Cada texel e calculado igual em qualquer faixa,
+		//entao o resultado nao depende do numero de threads
+		int nbBands = max(1, min(nbThreads, level.height / 32));
+		if (nbBands == 1)
+		{
+			downsampleRows(getPixels(i), getWidth(i), level.pixels.data(), level.width, &tapsX, &tapsY, 0, level.height);
+			continue;
+		}
+
+		vector<thread> workers;
+		for (int b = 0; b < nbBands; b++)
+		{
+			workers.push_back(thread(downsampleRows, getPixels(i), getWidth(i), level.pixels.data(), level.width,
+				&tapsX, &tapsY, level.height * b / nbBands, level.height * (b + 1) / nbBands));
+		}
+
+		for (int b = 0; b < workers.size(); b++)
+		{
+			workers[b].join();
+		}
+	}
+}
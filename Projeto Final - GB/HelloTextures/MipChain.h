@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+//Filtro de reducao entre niveis. O Kaiser (sinc janelado, 8 taps) preserva mais
+//detalhe; o caixa nunca le fora do bloco 2x2 de origem, o que o atlas precisa
+enum MipFilter
+{
+	MIP_BOX,
+	MIP_KAISER
+};
+
+//Cadeia de mipmaps RGBA8 gerada em CPU, para texturas que nao podem usar
+//glGenerateMipmap (as comprimidas) e para o resultado nao depender do driver.
+//A filtragem e feita em espaco linear (cor sRGB, alfa linear) com SSE2, em faixas
+//de linhas divididas entre threads. O nivel 0 e a propria imagem de entrada, que
+//nao e copiada
+class MipChain
+{
+public:
+	MipChain() {}
+	//Niveis ate 1x1
+	static int getNbLevels(int width, int height);
+	//nbThreads = 0 usa todos os nucleos
+	void build(const unsigned char* rgba, int width, int height, int nbLevels, MipFilter filter = MIP_KAISER, int nbThreads = 0);
+	int getNbLevels() { return levels.size() + 1; }
+	int getWidth(int level) { return level == 0 ? width : levels[level - 1].width; }
+	int getHeight(int level) { return level == 0 ? height : levels[level - 1].height; }
+	const unsigned char* getPixels(int level) { return level == 0 ? base : levels[level - 1].pixels.data(); }
+
+protected:
+	struct Level
+	{
+		int width, height;
+		vector<unsigned char> pixels;
+	};
+
+	const unsigned char* base = nullptr;
+	int width = 0, height = 0;
+	vector<Level> levels;
+};
@@ -4,10 +4,13 @@
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
+#include <cstdint>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <thread>
+#include <chrono>
+#include <memory>
 using namespace std;
 
 #include <glad/glad.h>
@@ -22,105 +25,834 @@ using namespace std;
 #include "Hermite.h"
 #include "Bezier.h"
 #include "CatmullRom.h"
+#include "CurveRegistry.h"
+#include "SceneFile.h"
+#include "Arena.h"
+#include "AllocationCounter.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "MaterialLibrary.h"
+#include "GLExtensions.h"
+#include "Benchmark.h"
+#include "HeadlessContext.h"
+#include "Framebuffer.h"
+#include "FrameCapture.h"
+#include "SoftwareRenderer.h"
+#include "RayTracer.h"
+#include "ShadowMap.h"
+#include "LightClusters.h"
+#include "DepthPrepass.h"
+#include "DeferredRenderer.h"
+#include "GPUTimer.h"
+#include "FrameProfiler.h"
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void readSceneConfig(string path);
+void translateSelected(glm::vec3 offset);
+void reportCapture(FrameCapture& capture);
 
 const GLuint WIDTH = 800, HEIGHT = 600;
 glm::vec3 cameraFrontInitial, cameraPosInitial, cameraUpInitial, lightPos, lightColor;
+SceneRenderer sceneRenderer = SCENE_FORWARD;
+vector<PointLight> pointLights; //pointLight e lightField da cena, alem da luz principal
 vector<Mesh> sceneObjects;
 int selectedObject = 0;
+int selectedControlPoint = -1; //-1: comandos de translacao movem o objeto
 Camera camera;
-
-int main()
+CurveRegistry curveRegistry;
+Arena loadArena; //Temporarios da carga da cena
+Arena frameArena; //Memoria de rascunho de um quadro, liberada ao final dele
+GLState glState;
+RenderQueue renderQueue;
+MaterialLibrary materials;
+ShadowMap shadowMap;
+LightClusters lightClusters;
+DepthPrepass depthPrepass;
+DeferredRenderer deferredRenderer;
+FrameProfiler profiler;
+bool showPaths = false;
+bool toggleRecording = false; //Tecla R: a gravacao comeca ou termina no proximo quadro
+
+int main(int argc, char** argv)
 {
-	glfwInit();
-	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "VISUALIZADOR DE CENAS 3D", nullptr, nullptr);
-	glfwMakeContextCurrent(window);
+	if (argc > 2 && string(argv[1]) == "--bench")
+	{
+		return runBenchmark(argv[2]);
+	}
 
-	glfwSetKeyCallback(window, key_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
+	if (argc > 3 && string(argv[1]) == "--compile-scene")
+	{
+		SceneFile scene;
+		return scene.load(argv[2]) && scene.writeBinary(argv[3]) ? 0 : -1;
+	}
 
-	glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
+	//Parametros: [arquivo de cena] [--texture-budget MB]; orcamento 0 desliga o streaming.
+	//Modo em lote: --headless N renderiza N quadros fora da tela com passo de tempo fixo e
+	//grava cada um em --output (padrao ../frames) no --format png, raw, gif ou y4m, no tamanho
+	//--size LxA. Na janela a tecla R grava no mesmo formato (GIF se nao for informado).
+	//--software renderiza em CPU com --threads N (padrao todos os nucleos) e --simd scalar,
+	//sse2, avx2 ou avx512 (padrao o melhor da CPU na janela e sse2 em lote, para os quadros
+	//serem os mesmos em qualquer maquina); em lote nao precisa de OpenGL, na janela
+	//o OpenGL so apresenta a imagem. --raytrace renderiza com o RayTracer, sempre em lote (1
+	//quadro se --headless nao for informado), com --samples N (N x N amostras por pixel,
+	//padrao 2) e --bounces N (reflexos, padrao 2); tambem usa --threads. No OpenGL as sombras
+	//usam mapas de --shadow-size N texels por cascata (padrao 2048) e o passo delas fica em
+	//--shadow-budget ms de GPU por quadro (padrao 2 na janela; em lote so se informado, para
+	//os quadros nao dependerem da medicao); --no-shadows desliga. As luzes pontuais da cena
+	//sao distribuidas em clusters; --cluster-heatmap (ou a tecla H) mostra quantas ha em cada um.
+	//--depth-prepass (tecla E) desenha a profundidade antes do passo principal e --overdraw
+	//(tecla O) mostra quantos fragmentos cada pixel sombreou. A cena escolhe o caminho forward ou
+	//deferred (renderer); --renderer forward ou deferred troca a escolha. O FrameProfiler mede
+	//cada trecho do quadro: --profile-graph (tecla G) mostra o grafico e --profile arquivo grava
+	//todos os quadros em CSV, ou no formato de trace do Chrome se o arquivo terminar em .json
+	string scenePath = "../config/cena-config.txt";
+	size_t textureBudget = 256;
+	int nbHeadlessFrames = 0;
+	string outputDirectory = "../frames";
+	string formatName;
+	int width = WIDTH, height = HEIGHT;
+	bool software = false;
+	int nbThreads = 0;
+	string simdName;
+	bool raytrace = false;
+	int samples = 2, bounces = 2;
+	bool shadows = true;
+	int shadowSize = 2048;
+	double shadowBudget = -1.0;
+	bool clusterHeatmap = false;
+	bool prepass = false, overdraw = false;
+	string rendererName;
+	bool profileGraph = false;
+	string profilePath;
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--texture-budget" && i + 1 < argc)
+		{
+			//Em MB: negativos desligam o streaming, como 0, e o limite evita o estouro do << 20
+			long long megabytes = strtoll(argv[++i], nullptr, 10);
+			if (megabytes < 0)
+			{
+				cout << "Invalid texture budget " << megabytes << " MB, streaming disabled" << endl;
+			}
+			textureBudget = (size_t)min(max(megabytes, 0LL), (long long)(SIZE_MAX >> 20));
+		}
+		else if (arg == "--headless" && i + 1 < argc)
+		{
+			nbHeadlessFrames = atoi(argv[++i]);
+		}
+		else if (arg == "--output" && i + 1 < argc)
+		{
+			outputDirectory = argv[++i];
+		}
+		else if (arg == "--format" && i + 1 < argc)
+		{
+			formatName = argv[++i];
+		}
+		else if (arg == "--software")
+		{
+			software = true;
+		}
+		else if (arg == "--threads" && i + 1 < argc)
+		{
+			nbThreads = atoi(argv[++i]);
+		}
+		else if (arg == "--simd" && i + 1 < argc)
+		{
+			simdName = argv[++i];
+		}
+		else if (arg == "--raytrace")
+		{
+			raytrace = true;
+		}
+		else if (arg == "--samples" && i + 1 < argc)
+		{
+			samples = atoi(argv[++i]);
+		}
+		else if (arg == "--bounces" && i + 1 < argc)
+		{
+			bounces = atoi(argv[++i]);
+		}
+		else if (arg == "--no-shadows")
+		{
+			shadows = false;
+		}
+		else if (arg == "--shadow-size" && i + 1 < argc)
+		{
+			shadowSize = max(atoi(argv[++i]), 16);
+		}
+		else if (arg == "--shadow-budget" && i + 1 < argc)
+		{
+			shadowBudget = atof(argv[++i]);
+		}
+		else if (arg == "--cluster-heatmap")
+		{
+			clusterHeatmap = true;
+		}
+		else if (arg == "--depth-prepass")
+		{
+			prepass = true;
+		}
+		else if (arg == "--overdraw")
+		{
+			overdraw = true;
+		}
+		else if (arg == "--renderer" && i + 1 < argc)
+		{
+			rendererName = argv[++i];
+		}
+		else if (arg == "--profile-graph")
+		{
+			profileGraph = true;
+		}
+		else if (arg == "--profile" && i + 1 < argc)
+		{
+			profilePath = argv[++i];
+		}
+		else if (arg == "--size" && i + 1 < argc)
+		{
+			if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+			{
+				width = WIDTH;
+				height = HEIGHT;
+			}
+		}
+		else
+		{
+			scenePath = arg;
+		}
+	}
+	//O tracado de raios e offline: usa o caminho em CPU, sem contexto OpenGL
+	if (raytrace)
+	{
+		software = true;
+		nbHeadlessFrames = max(nbHeadlessFrames, 1);
+	}
+	bool headless = nbHeadlessFrames > 0;
 
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	CaptureFormat captureFormat = headless ? CAPTURE_PNG : CAPTURE_GIF;
+	if (formatName == "png")
+	{
+		captureFormat = CAPTURE_PNG;
+	}
+	else if (formatName == "raw")
+	{
+		captureFormat = CAPTURE_RAW;
+	}
+	else if (formatName == "gif")
+	{
+		captureFormat = CAPTURE_GIF;
+	}
+	else if (formatName == "y4m")
+	{
+		captureFormat = CAPTURE_Y4M;
+	}
 
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	GLFWwindow* window = nullptr;
+	HeadlessContext headlessContext;
+	GLADloadproc loader = (GLADloadproc)glfwGetProcAddress;
+
+	if (headless && software)
+	{
+		//Nenhum contexto: a cena e o SoftwareRenderer nao fazem chamadas OpenGL
+	}
+	else if (headless)
 	{
-		cout << "Failed to initialize GLAD" << endl;
-		return -1;
+		if (!headlessContext.create(4, 5))
+		{
+			cout << "Failed to create headless OpenGL context" << endl;
+			return -1;
+		}
+		loader = headlessContext.getLoader();
 	}
+	else
+	{
+		glfwInit();
+		window = glfwCreateWindow(WIDTH, HEIGHT, "VISUALIZADOR DE CENAS 3D", nullptr, nullptr);
+		glfwMakeContextCurrent(window);
 
-	const GLubyte* renderer = glGetString(GL_RENDERER);
-	const GLubyte* version = glGetString(GL_VERSION);
-	cout << "Renderer: " << renderer << endl;
-	cout << "OpenGL version supported " << version << endl;
+		glfwSetKeyCallback(window, key_callback);
+		glfwSetCursorPosCallback(window, mouse_callback);
 
-	Shader shader("../shaders/sprite.vs", "../shaders/sprite.fs");
+		glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
 
-	readSceneConfig("../config/cena-config.txt");
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	}
 
-	int width, height;
-	glfwGetFramebufferSize(window, &width, &height);
-	glViewport(0, 0, width, height);
+	if (!(headless && software))
+	{
+		if (!gladLoadGLLoader(loader))
+		{
+			cout << "Failed to initialize GLAD" << endl;
+			return -1;
+		}
+		loadGLExtensions(loader);
 
-	glUseProgram(shader.ID);
+		const GLubyte* renderer = glGetString(GL_RENDERER);
+		const GLubyte* version = glGetString(GL_VERSION);
+		cout << "Renderer: " << renderer << endl;
+		cout << "OpenGL version supported " << version << endl;
+	}
 
-	camera.initialize(&shader, width, height, cameraPosInitial, cameraFrontInitial, cameraUpInitial);
+	//Em software a cena e carregada sem shader, so em memoria de CPU
+	unique_ptr<Shader> shader, curveShader;
+	if (!software)
+	{
+		shader.reset(new Shader("../shaders/sprite.vs", "../shaders/sprite.fs"));
+		curveShader.reset(new Shader("../shaders/curve.vs", "../shaders/curve.fs"));
+	}
+	//Recebe a luz, as sombras e os clusters: sprite.fs, ou o passo de iluminacao no caminho deferred
+	Shader* lightingShader = shader.get();
+
+	size_t loadAllocations = getHeapAllocationCount();
+
+	readSceneConfig(scenePath);
+	if (rendererName == "forward" || rendererName == "deferred")
+	{
+		sceneRenderer = rendererName == "deferred" ? SCENE_DEFERRED : SCENE_FORWARD;
+	}
+
+	//Sem janela o quadro vai para um framebuffer do tamanho pedido, lido pelo FrameCapture.
+	//Em software o FrameCapture recebe a imagem do SoftwareRenderer e, na janela, o
+	//framebuffer guarda essa imagem para a copia na tela
+	Framebuffer framebuffer;
+	FrameCapture frameCapture;
+	SoftwareRenderer softwareRenderer;
+	RayTracer rayTracer;
+	GPUTimer mainPassTimer; //passo principal do OpenGL, mostrado no quadro 60
+	if (headless && software)
+	{
+		if (!frameCapture.initialize(width, height, outputDirectory, captureFormat, "capture", 60, false))
+		{
+			cout << "Failed to set up frame capture" << endl;
+			return -1;
+		}
+		cout << "Rendering " << nbHeadlessFrames << " frames at " << width << "x" << height << (raytrace ? " (ray tracing)" : " (software)") << " to " << outputDirectory << endl;
+	}
+	else if (headless)
+	{
+		if (!framebuffer.create(width, height) || !frameCapture.initialize(width, height, outputDirectory, captureFormat))
+		{
+			cout << "Failed to set up offscreen rendering" << endl;
+			return -1;
+		}
+		framebuffer.bind();
+		cout << "Rendering " << nbHeadlessFrames << " frames at " << width << "x" << height << " (" << headlessContext.getBackendName() << ") to " << outputDirectory << endl;
+	}
+	else
+	{
+		glfwGetFramebufferSize(window, &width, &height);
+		glViewport(0, 0, width, height);
+		if (software && !framebuffer.create(width, height))
+		{
+			cout << "Failed to create presentation framebuffer" << endl;
+			return -1;
+		}
+	}
+
+	if (!software)
+	{
+		glState.useProgram(shader->ID);
+	}
+
+	camera.initialize(shader.get(), width, height, cameraPosInitial, cameraFrontInitial, cameraUpInitial);
 
 	for (int i = 0; i < sceneObjects.size(); i++)
 	{
-		sceneObjects[i].initialize(&shader);
+		sceneObjects[i].initialize(shader.get(), &curveRegistry, &materials, loadArena);
 	}
 
-	shader.setVec3("lightPos", lightPos.x, lightPos.y, lightPos.z);
-	shader.setVec3("lightColor", lightColor.x, lightColor.y, lightColor.z);
+	if (raytrace)
+	{
+		rayTracer.initialize(width, height, nbThreads);
+		rayTracer.loadMaterials(materials);
+		rayTracer.setLight(lightPos, lightColor);
+		rayTracer.setQuality(samples, bounces);
+		cout << materials.getNbMaterials() << " materials, ray tracer with " << rayTracer.getNbThreads() << " threads, " << max(samples, 1) * max(samples, 1)
+			<< " samples per pixel, " << max(bounces, 0) << " bounces" << endl;
+	}
+	else if (software)
+	{
+		softwareRenderer.initialize(width, height, nbThreads);
+		softwareRenderer.loadMaterials(materials);
+		softwareRenderer.setLight(lightPos, lightColor);
+		if (!simdName.empty())
+		{
+			softwareRenderer.setShadingKernel(findPhongKernel(simdName.c_str()));
+		}
+		else if (headless)
+		{
+			//Quadros de referencia: a mesma versao em qualquer CPU x64. As versoes geram os mesmos
+			//bytes (o --bench phong confere), mas assim uma regressao nelas nao muda as referencias
+			softwareRenderer.setShadingKernel(PHONG_SSE2);
+		}
+		cout << materials.getNbMaterials() << " materials, software renderer with " << softwareRenderer.getNbThreads() << " threads, "
+			<< getPhongKernelName(softwareRenderer.getShadingKernel()) << " shading" << endl;
+	}
+	else
+	{
+		curveRegistry.upload();
+		materials.setTextureBudget(textureBudget << 20);
+		materials.upload(hasGLExtension("GL_ARB_bindless_texture"), hasGLExtension("GL_EXT_texture_compression_s3tc"));
+		materials.setupShader(shader.get());
+		cout << materials.getNbMaterials() << " materials in " << materials.getNbTextureArrays() << " texture arrays" << (materials.isBindless() ? " (bindless)" : "") << endl;
+
+		//No caminho deferred a luz, as sombras e os clusters vao para o passo de iluminacao
+		if (sceneRenderer == SCENE_DEFERRED)
+		{
+			if (deferredRenderer.create(width, height))
+			{
+				glState.useProgram(deferredRenderer.getGeometryShader()->ID);
+				materials.setupShader(deferredRenderer.getGeometryShader());
+				lightingShader = deferredRenderer.getLightingShader();
+				glState.useProgram(lightingShader->ID);
+				cout << "Deferred shading: " << DeferredRenderer::NB_TARGETS << " G-buffer targets, " << deferredRenderer.getBytesPerPixel() << " bytes per pixel" << endl;
+				if (prepass || overdraw)
+				{
+					cout << "Depth pre-pass and overdraw view only apply to forward shading" << endl;
+				}
+			}
+			else
+			{
+				cout << "Failed to create G-buffer, using forward shading" << endl;
+			}
+		}
+
+		if (shadows)
+		{
+			if (shadowMap.create(shadowSize))
+			{
+				shadowMap.setLight(lightPos, sceneObjects);
+				shadowMap.setBudget(shadowBudget >= 0.0 ? shadowBudget : (headless ? 0.0 : 2.0));
+				cout << "Shadow maps: " << ShadowMap::NB_CASCADES << " cascades of " << shadowSize << "x" << shadowSize << endl;
+			}
+			else
+			{
+				cout << "Failed to create shadow maps" << endl;
+			}
+		}
+		shadowMap.setupShader(lightingShader);
 
-	while (!glfwWindowShouldClose(window))
+		if (!pointLights.empty())
+		{
+			if (lightClusters.create(pointLights))
+			{
+				cout << pointLights.size() << " point lights in " << LightClusters::NB_CLUSTERS << " clusters (" << LightClusters::GRID_X << "x"
+					<< LightClusters::GRID_Y << "x" << LightClusters::GRID_Z << ")" << endl;
+			}
+			else
+			{
+				cout << "Failed to set up light clusters: " << pointLights.size() << " point lights ignored" << endl;
+			}
+		}
+		lightClusters.setHeatmap(clusterHeatmap);
+		lightClusters.setupShader(lightingShader);
+		if (!deferredRenderer.isCreated())
+		{
+			depthPrepass.create();
+		}
+		depthPrepass.setEnabled(prepass);
+		depthPrepass.setOverdraw(overdraw);
+		mainPassTimer.create();
+	}
+	//Sem contexto OpenGL so os tempos de CPU; o grafico precisa do OpenGL
+	profiler.create(!(headless && software));
+	profiler.setGraph(profileGraph && !(headless && software));
+	profiler.setRecording(!profilePath.empty());
+
+	//A carga faz binds direto no OpenGL
+	glState.invalidate();
+#ifdef _DEBUG
+	glState.setValidation(true);
+#endif
+	cout << curveRegistry.getNbPaths() << " unique paths for " << curveRegistry.getNbReferences() << " objects" << endl;
+	cout << "Scene loaded with " << getHeapAllocationCount() - loadAllocations << " heap allocations" << endl;
+
+	//Contagem de alocacoes em regime permanente, medida uma vez entre os quadros 60 e 180
+	const int firstMeasuredFrame = 60, lastMeasuredFrame = 180;
+	size_t frameAllocations = 0;
+	int frame = 0;
+
+	if (!software)
 	{
-		glfwPollEvents();
+		glState.useProgram(lightingShader->ID);
+		lightingShader->setVec3("lightPos", lightPos.x, lightPos.y, lightPos.z);
+		lightingShader->setVec3("lightColor", lightColor.x, lightColor.y, lightColor.z);
+	}
 
-		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	//Em lote o tempo avanca 1/60 s por quadro, independente de quanto o quadro leva
+	const double headlessTimeStep = 1.0 / 60.0;
+	chrono::steady_clock::time_point renderStart = chrono::steady_clock::now();
+	long long totalRays = 0;
+	double totalTraceTime = 0.0;
 
-		glLineWidth(10);
-		glPointSize(20);
+	while (headless ? frame < nbHeadlessFrames : !glfwWindowShouldClose(window))
+	{
+		profiler.beginFrame();
+		if (!headless)
+		{
+			profiler.begin("input");
+			glfwPollEvents();
+
+			if (toggleRecording)
+			{
+				toggleRecording = false;
+				if (frameCapture.isActive())
+				{
+					frameCapture.finish();
+					frameCapture.deleteResources();
+					reportCapture(frameCapture);
+				}
+				else
+				{
+					char name[32];
+					snprintf(name, sizeof(name), "capture_%05d", frame);
+					if (frameCapture.initialize(width, height, outputDirectory, captureFormat, name, 60, !software))
+					{
+						cout << "Recording to " << outputDirectory << endl;
+					}
+					else
+					{
+						frameCapture.deleteResources();
+					}
+				}
+			}
+			profiler.end();
+		}
 
-		camera.update();
+		float pathTime = headless ? (float)(frame * headlessTimeStep) : (float)glfwGetTime();
+		if (raytrace)
+		{
+			profiler.begin("ray tracing");
+			rayTracer.setCamera(camera.getViewMatrix(), camera.getProjectionMatrix(), camera.getPosition());
+			rayTracer.begin(glm::vec3(1.0f, 1.0f, 1.0f));
+			for (int i = 0; i < sceneObjects.size(); i++)
+			{
+				rayTracer.draw(sceneObjects[i], pathTime);
+			}
+			rayTracer.end();
+			profiler.end();
+
+			long long nbRays = rayTracer.getNbPrimaryRays() + rayTracer.getNbShadowRays() + rayTracer.getNbReflectionRays();
+			totalRays += nbRays;
+			totalTraceTime += rayTracer.getTraceTime();
+			cout << "Frame " << frame << ": BVH " << rayTracer.getNbNodes() << " nodes over " << rayTracer.getNbTriangles() << " triangles in " << rayTracer.getBuildTime() << " ms, "
+				<< rayTracer.getNbPrimaryRays() << " camera + " << rayTracer.getNbShadowRays() << " shadow + " << rayTracer.getNbReflectionRays() << " reflection rays in "
+				<< rayTracer.getTraceTime() << " ms (" << nbRays / (rayTracer.getTraceTime() * 1e3) << " Mrays/s)" << endl;
+			profiler.begin("capture");
+			frameCapture.captureImage(rayTracer.getColorBuffer(), frame);
+			profiler.end();
+		}
+		else if (software)
+		{
+			profiler.begin("rasterization");
+			softwareRenderer.setCamera(camera.getViewMatrix(), camera.getProjectionMatrix(), camera.getPosition());
+			softwareRenderer.begin(glm::vec3(1.0f, 1.0f, 1.0f));
+			for (int i = 0; i < sceneObjects.size(); i++)
+			{
+				softwareRenderer.draw(sceneObjects[i], pathTime);
+			}
+			softwareRenderer.end();
+			profiler.end();
+
+			if (frame == firstMeasuredFrame)
+			{
+				cout << "Software renderer: " << softwareRenderer.getNbTriangles() << " triangles rasterized" << endl;
+			}
+			if (frameCapture.isActive())
+			{
+				profiler.begin("capture");
+				frameCapture.captureImage(softwareRenderer.getColorBuffer(), frame);
+				profiler.end();
+			}
+			if (!headless)
+			{
+				profiler.begin("present", true);
+				framebuffer.upload(softwareRenderer.getColorBuffer());
+				framebuffer.present(width, height);
+				profiler.end();
+				if (profiler.getGraph())
+				{
+					profiler.begin("profiler graph", true);
+					profiler.drawGraph(glState, width, height);
+					profiler.end();
+				}
+			}
+		}
+		else
+		{
+			//A sobreposicao soma as cores dos fragmentos sobre o preto
+			profiler.begin("update", true);
+			float clearColor = depthPrepass.getOverdraw() ? 0.0f : 1.0f;
+			glClearColor(clearColor, clearColor, clearColor, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glState.enable(GL_DEPTH_TEST);
+			glState.lineWidth(10);
+			glState.pointSize(20);
+
+			glState.useProgram(shader->ID);
+			curveRegistry.getCurveBuffer().bind(glState);
+			camera.update();
+			shader->setFloat("pathTime", pathTime);
+
+			//Fila do quadro, montada no arena do quadro e ordenada por estado
+			glm::mat4 view = camera.getViewMatrix();
+			glm::mat4 projection = camera.getProjectionMatrix();
+			profiler.end();
+
+			//As cascatas de sombra sao desenhadas antes, com o programa de profundidade; o
+			//descarte dos objetos fora de cada cascata entra no trecho delas
+			profiler.begin("shadows", true);
+			shadowMap.render(glState, sceneObjects, view, projection, camera.getNearPlane(), camera.getFarPlane(), pathTime);
+			profiler.end();
+			profiler.begin("clusters", true);
+			lightClusters.update(glState, view, projection, camera.getNearPlane(), camera.getFarPlane());
+			profiler.end();
+			profiler.begin("prepass", true);
+			depthPrepass.render(glState, frameArena, sceneObjects, view, projection, camera.getFarPlane(), pathTime);
+			profiler.end();
+			glState.useProgram(lightingShader->ID);
+			shadowMap.apply(glState, lightingShader);
+			lightClusters.apply(lightingShader, width, height);
+
+			profiler.begin("queue");
+			renderQueue.begin(frameArena, sceneObjects.size());
+			for (int i = 0; i < sceneObjects.size(); i++)
+			{
+				renderQueue.push(sceneObjects[i].getSortKey(view, camera.getFarPlane()), &sceneObjects[i]);
+				materials.requestResidency(sceneObjects[i].getMaterialId(), sceneObjects[i].getScreenSize(view, projection, height));
+			}
+			profiler.end();
+
+			//Os mipmaps pedidos pelo quadro sobem antes do bind das texturas
+			profiler.begin("streaming", true);
+			materials.updateStreaming(glState);
+			materials.bind(glState);
+			profiler.end();
+
+			bool reportStateChanges = frame == firstMeasuredFrame;
+			int unsortedStateChanges = reportStateChanges ? renderQueue.countStateChanges() : 0;
+
+			profiler.begin("sort");
+			renderQueue.sort();
+			profiler.end();
+			glState.resetCounters();
+			mainPassTimer.poll();
+			if (deferredRenderer.isCreated())
+			{
+				profiler.begin("deferred", true);
+				deferredRenderer.render(glState, renderQueue, view, projection, camera.getPosition(), pathTime);
+				profiler.end();
+			}
+			else
+			{
+				profiler.begin("main pass", true);
+				depthPrepass.beginMainPass(glState, shader.get());
+				mainPassTimer.begin();
+				renderQueue.submit(glState);
+				mainPassTimer.end();
+				depthPrepass.endMainPass(glState);
+				profiler.end();
+			}
+
+			if (reportStateChanges)
+			{
+				cout << "Render queue: " << renderQueue.getNbItems() << " draws, state changes " << unsortedStateChanges << " unsorted / "
+					<< renderQueue.countStateChanges() << " sorted, " << glState.getNbCalls() << " binds issued, " << glState.getNbSkipped() << " skipped" << endl;
+				cout << "Textures resident: " << materials.getResidentSize() / (1024.0 * 1024.0) << " MB" << endl;
+				if (shadowMap.isCreated())
+				{
+					cout << "Shadow maps: " << shadowMap.getNbDraws() << " draws, " << shadowMap.getNbCulled() << " culled, " << shadowMap.getGPUTime()
+						<< " ms GPU, far cascades every " << shadowMap.getUpdateInterval() << " frames" << endl;
+				}
+				if (lightClusters.isCreated())
+				{
+					float averageLights;
+					int maxLights, nbOccupied;
+					lightClusters.countLights(glState, averageLights, maxLights, nbOccupied);
+					cout << "Light clusters: " << lightClusters.getNbLights() << " lights, assigned in " << lightClusters.getGPUTime() << " ms GPU, "
+						<< averageLights << " per occupied cluster (max " << maxLights << ", " << nbOccupied << " clusters occupied)" << endl;
+				}
+				if (depthPrepass.isEnabled())
+				{
+					cout << "Depth pre-pass: " << depthPrepass.getNbDraws() << " draws, " << depthPrepass.getGPUTime() << " ms GPU" << endl;
+				}
+				if (deferredRenderer.isCreated())
+				{
+					cout << "Deferred shading: geometry " << deferredRenderer.getGeometryTime() << " ms GPU, lighting " << deferredRenderer.getLightingTime() << " ms GPU" << endl;
+				}
+				else
+				{
+					GLuint nbFragments = depthPrepass.countFragments();
+					cout << "Main pass: " << mainPassTimer.getAverageTime() << " ms GPU, " << nbFragments << " fragments shaded ("
+						<< nbFragments / (float)(width * height) << " per pixel)" << endl;
+				}
+			}
+
+			if (showPaths)
+			{
+				profiler.begin("paths", true);
+				glState.useProgram(curveShader->ID);
+				curveShader->setMat4("projection", glm::value_ptr(projection));
+				curveShader->setMat4("view", glm::value_ptr(view));
+				curveRegistry.getCurveBuffer().drawCurves(glState, curveShader.get(), 500, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+				profiler.end();
+			}
+
+			//O grafico mostra os quadros ja terminados e entra na captura
+			if (profiler.getGraph())
+			{
+				profiler.begin("profiler graph", true);
+				profiler.drawGraph(glState, width, height);
+				profiler.end();
+			}
+
+			if (frameCapture.isActive())
+			{
+				profiler.begin("capture", true);
+				frameCapture.capture(glState, frame);
+				profiler.end();
+			}
+		}
 
-		for (int i = 0; i < sceneObjects.size(); i++)
+		if (!headless)
 		{
-			sceneObjects[i].update();
-			sceneObjects[i].draw();
+			profiler.begin("sleep");
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			profiler.end();
+
+			profiler.begin("swap");
+			glfwSwapBuffers(window);
+			profiler.end();
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		frameArena.reset();
 
-		glfwSwapBuffers(window);
+#ifdef _DEBUG
+		if (!software)
+		{
+			glState.verify();
+		}
+#endif
+		profiler.endFrame();
+
+		frame++;
+		if (frame == firstMeasuredFrame)
+		{
+			frameAllocations = getHeapAllocationCount();
+		}
+		else if (frame == lastMeasuredFrame)
+		{
+			cout << "Heap allocations per frame: " << (getHeapAllocationCount() - frameAllocations) / (float)(lastMeasuredFrame - firstMeasuredFrame) << endl;
+		}
 	}
 
-	for (int i = 0; i < sceneObjects.size(); i++)
+	if (frameCapture.isActive())
 	{
-		sceneObjects[i].deleteVertexArray();
+		frameCapture.finish();
+		reportCapture(frameCapture);
+	}
+	if (headless)
+	{
+		//Inclui a espera pela codificacao dos ultimos quadros
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - renderStart).count();
+		cout << "Rendered " << frame << " frames in " << seconds << " s: " << frame / seconds << " fps" << endl;
+		if (raytrace && totalTraceTime > 0.0)
+		{
+			double raysPerSecond = totalRays / (totalTraceTime * 1e3);
+			cout << "Ray tracing: " << raysPerSecond << " Mrays/s, " << raysPerSecond / rayTracer.getNbThreads() << " per thread" << endl;
+		}
+	}
+	profiler.report();
+	if (!profilePath.empty())
+	{
+		if (profiler.write(profilePath))
+		{
+			cout << "Frame profile written to " << profilePath << endl;
+		}
+		else
+		{
+			cout << "Failed to write frame profile to " << profilePath << endl;
+		}
 	}
 
-	glfwTerminate();
+	//Os objetos liberam VAO, VBOs, textura e trajetoria enquanto o contexto ainda existe
+	sceneObjects.clear();
+	curveRegistry.clear();
+	materials.deleteResources();
+	shadowMap.destroy();
+	lightClusters.deleteResources();
+	depthPrepass.destroy();
+	deferredRenderer.destroy();
+	mainPassTimer.destroy();
+	profiler.destroy();
+	frameCapture.deleteResources();
+	framebuffer.destroy();
+
+	if (headless)
+	{
+		headlessContext.destroy();
+	}
+	else
+	{
+		glfwTerminate();
+	}
 	return 0;
 }
 
+void reportCapture(FrameCapture& capture)
+{
+	cout << "Captured " << capture.getNbWritten() << " frames, " << capture.getBytesWritten() / (1024.0 * 1024.0) << " MB; render thread "
+		<< capture.getAverageCaptureTime() << " ms/frame (max " << capture.getMaxCaptureTime() << " ms), " << capture.getNbStalls() << " stalls, " << capture.getNbLost() << " lost" << endl;
+}
+
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
 {
 	camera.move(window, key, action);
 
-	if (key == GLFW_KEY_ENTER && action == GLFW_PRESS)
+	if (key == GLFW_KEY_C && action == GLFW_PRESS)
+	{
+		showPaths = !showPaths;
+	}
+	else if (key == GLFW_KEY_R && action == GLFW_PRESS)
+	{
+		toggleRecording = true;
+	}
+	else if (key == GLFW_KEY_H && action == GLFW_PRESS)
+	{
+		lightClusters.setHeatmap(!lightClusters.getHeatmap());
+	}
+	else if (key == GLFW_KEY_E && action == GLFW_PRESS)
+	{
+		depthPrepass.setEnabled(!depthPrepass.isEnabled());
+	}
+	else if (key == GLFW_KEY_O && action == GLFW_PRESS)
+	{
+		depthPrepass.setOverdraw(!depthPrepass.getOverdraw());
+	}
+	else if (key == GLFW_KEY_G && action == GLFW_PRESS)
+	{
+		profiler.setGraph(!profiler.getGraph());
+	}
+	else if (key == GLFW_KEY_ENTER && action == GLFW_PRESS)
 	{
 		selectedObject++;
+		selectedControlPoint = -1;
 
 		if (selectedObject >= sceneObjects.size()) {
 			selectedObject = 0;
 		}
-	} 
+	}
+	else if (key == GLFW_KEY_P && action == GLFW_PRESS)
+	{
+		selectedControlPoint++;
+
+		if (selectedControlPoint >= sceneObjects[selectedObject].getNbControlPoints()) {
+			selectedControlPoint = -1;
+		}
+	}
 	else if (key == GLFW_KEY_MINUS && action == GLFW_PRESS) 
 	{
 		sceneObjects[selectedObject].scaleDown();
@@ -131,19 +863,19 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	}
 	else if (key == GLFW_KEY_UP && action == GLFW_PRESS)
 	{
-		sceneObjects[selectedObject].translateY(0.1f);
+		translateSelected(glm::vec3(0.0f, 0.1f, 0.0f));
 	}
 	else if (key == GLFW_KEY_DOWN && action == GLFW_PRESS)
 	{
-		sceneObjects[selectedObject].translateY(-0.1f);
+		translateSelected(glm::vec3(0.0f, -0.1f, 0.0f));
 	}
 	else if (key == GLFW_KEY_4 && action == GLFW_PRESS)
 	{
-		sceneObjects[selectedObject].translateZ(0.1f);
+		translateSelected(glm::vec3(0.0f, 0.0f, 0.1f));
 	}
 	else if (key == GLFW_KEY_5 && action == GLFW_PRESS)
 	{
-		sceneObjects[selectedObject].translateZ(-0.1f);
+		translateSelected(glm::vec3(0.0f, 0.0f, -0.1f));
 	}
 	else if (key == GLFW_KEY_8 && action == GLFW_PRESS)
 	{
@@ -167,11 +899,28 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	}
 	else if (key == GLFW_KEY_RIGHT && action == GLFW_PRESS)
 	{
-		sceneObjects[selectedObject].translateX(0.1f);
+		translateSelected(glm::vec3(0.1f, 0.0f, 0.0f));
 	}
 	else if (key == GLFW_KEY_LEFT && action == GLFW_PRESS)
 	{
-		sceneObjects[selectedObject].translateX(-0.1f);
+		translateSelected(glm::vec3(-0.1f, 0.0f, 0.0f));
+	}
+}
+
+//Translada o objeto selecionado ou, se houver, o ponto de controle selecionado da sua trajetoria
+void translateSelected(glm::vec3 offset)
+{
+	if (selectedControlPoint >= 0)
+	{
+		sceneObjects[selectedObject].moveControlPoint(selectedControlPoint, offset);
+		//A atualizacao dos SSBOs faz binds fora do GLState
+		glState.invalidate();
+	}
+	else
+	{
+		sceneObjects[selectedObject].translateX(offset.x);
+		sceneObjects[selectedObject].translateY(offset.y);
+		sceneObjects[selectedObject].translateZ(offset.z);
 	}
 }
 
@@ -181,110 +930,41 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 }
 
 void readSceneConfig(string path) {
-	vector<string> objectsFileName, objectsAxis;
-	vector<glm::vec3> objectsPosition;
-	vector<vector<glm::vec3>> objectsControlPoints;
-	int objectIndex = 0;
-	vector<float> objectsScale, objectsAngle;
-
-	string line;
-	ifstream configFile(path);
+	SceneFile scene;
 
-	while (getline(configFile, line))
+	if (!scene.load(path))
 	{
-		istringstream iss(line);
-		string prefix;
-		iss >> prefix;
+		return;
+	}
 
-		if (prefix == "cameraPos") 
-		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			cameraPosInitial = glm::vec3(x, y, z);
-		}
-		else if (prefix == "cameraFront") 
-		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			cameraFrontInitial = glm::vec3(x, y, z);
-		}
-		else if (prefix == "cameraUp")
-		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			cameraUpInitial = glm::vec3(x, y, z);
-		}
-		else if (prefix == "lightPos")
-		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			lightPos = glm::vec3(x, y, z);
-		}
-		else if (prefix == "lightColor")
-		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			lightColor = glm::vec3(x, y, z);
-		}
-		else if (prefix == "fileName")
-		{
-			string fileName;
-			iss >> fileName;
-			objectsFileName.push_back(fileName);
-		}
-		else if (prefix == "position")
-		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			objectsPosition.push_back(glm::vec3(x, y, z));
-		}
-		else if (prefix == "scale")
-		{
-			float scale;
-			iss >> scale;
-			objectsScale.push_back(scale);
-		}
-		else if (prefix == "angle")
-		{
-			float angle;
-			iss >> angle;
-			objectsAngle.push_back(angle);
-		}
-		else if (prefix == "axis")
-		{
-			string axis;
-			iss >> axis;
-			objectsAxis.push_back(axis);
-		}
-		else if (prefix == "startCurve")
-		{
-			vector<glm::vec3> controlPoints;
-			objectsControlPoints.push_back(controlPoints);
-		}
-		else if (prefix == "curvePoint")
-		{
-			float x, y, z;
-			iss >> x >> y >> z;
-			objectsControlPoints[objectIndex].push_back(glm::vec3(x, y, z));
-		}
-		else if (prefix == "endCurve")
-		{
-			objectIndex++;
-		}
-		else if (prefix == "noCurve")
-		{
-			vector<glm::vec3> emptyControlPoints;
-			objectsControlPoints.push_back(emptyControlPoints);
-			objectIndex++;
-		}
+	cameraPosInitial = scene.getCameraPos();
+	cameraFrontInitial = scene.getCameraFront();
+	cameraUpInitial = scene.getCameraUp();
+	lightPos = scene.getLightPos();
+	lightColor = scene.getLightColor();
+	sceneRenderer = scene.getRenderer();
+
+	pointLights.reserve(pointLights.size() + scene.getNbLights());
+	for (int i = 0; i < scene.getNbLights(); i++)
+	{
+		const SceneLightRecord& record = scene.getLight(i);
+		PointLight light;
+		light.positionRadius = glm::vec4(record.position[0], record.position[1], record.position[2], record.radius);
+		light.color = glm::vec4(record.color[0], record.color[1], record.color[2], 1.0f);
+		pointLights.push_back(light);
 	}
 
-	configFile.close();
+	sceneObjects.reserve(sceneObjects.size() + scene.getNbObjects());
 
-	for (int i = 0; i < objectsFileName.size(); i++)
+	for (int i = 0; i < scene.getNbObjects(); i++)
 	{
-		Mesh object;
-		object.initialSceneConfig(objectsFileName[i], objectsPosition[i], objectsScale[i], objectsAngle[i], objectsAxis[i], objectsControlPoints[i]);
-		sceneObjects.push_back(object);
+		const SceneObjectRecord& record = scene.getObject(i);
+		const glm::vec3* controlPoints = scene.getControlPoints(record);
+
+		sceneObjects.emplace_back();
+		Mesh& object = sceneObjects.back();
+		object.initialSceneConfig(scene.getString(record.fileName), glm::vec3(record.position[0], record.position[1], record.position[2]), record.scale, record.angle,
+			string(1, record.axis), vector<glm::vec3>(controlPoints, controlPoints + record.nbControlPoints), record.instances);
+		object.setPathConfig(scene.getString(record.curveType), record.closedCurve != 0, scene.getString(record.parameterization), record.phase);
 	}
-}
\ No newline at end of file
+}
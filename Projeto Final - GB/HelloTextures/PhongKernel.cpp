@@ -0,0 +1,193 @@
+#include "PhongKernel.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include "PhongKernelSIMD.h"
+
+using namespace std;
+
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int registers[4])
+{
+#ifdef _MSC_VER
+	__cpuidex((int*)registers, leaf, subleaf);
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+//XCR0: quais registradores o sistema operacional salva na troca de contexto
+static unsigned long long xgetbv()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+struct CPUFeatures
+{
+	bool avx2 = false, avx512 = false;
+
+	CPUFeatures()
+	{
+		unsigned int registers[4];
+		cpuid(0, 0, registers);
+		unsigned int maxLeaf = registers[0];
+		if (maxLeaf < 7)
+		{
+			return;
+		}
+
+		cpuid(1, 0, registers);
+		bool osxsave = (registers[2] & (1u << 27)) != 0;
+		bool avx = (registers[2] & (1u << 28)) != 0;
+		if (!osxsave || !avx)
+		{
+			return;
+		}
+
+		unsigned long long xcr0 = xgetbv();
+		bool ymm = (xcr0 & 0x6) == 0x6; //XMM e YMM
+		bool zmm = (xcr0 & 0xE6) == 0xE6; //e tambem opmask, ZMM0-15 e ZMM16-31
+
+		cpuid(7, 0, registers);
+		avx2 = ymm && (registers[1] & (1u << 5)) != 0;
+		avx512 = zmm && (registers[1] & (1u << 16)) != 0;
+	}
+};
+
+static const CPUFeatures& getCPUFeatures()
+{
+	static CPUFeatures features;
+	return features;
+}
+
+bool isPhongKernelSupported(PhongKernelType type)
+{
+	switch (type)
+	{
+	case PHONG_AVX2:
+		return getCPUFeatures().avx2;
+	case PHONG_AVX512:
+		return getCPUFeatures().avx512;
+	default:
+		return true;
+	}
+}
+
+PhongKernelType getBestPhongKernel()
+{
+	if (isPhongKernelSupported(PHONG_AVX512))
+	{
+		return PHONG_AVX512;
+	}
+	if (isPhongKernelSupported(PHONG_AVX2))
+	{
+		return PHONG_AVX2;
+	}
+	return PHONG_SSE2;
+}
+
+PhongKernel getPhongKernel(PhongKernelType type)
+{
+	static const PhongKernel kernels[NB_PHONG_KERNELS] = { shadePhongScalar, shadePhongSSE2, shadePhongAVX2, shadePhongAVX512 };
+	return kernels[type];
+}
+
+const char* getPhongKernelName(PhongKernelType type)
+{
+	static const char* names[NB_PHONG_KERNELS] = { "scalar", "sse2", "avx2", "avx512" };
+	return names[type];
+}
+
+PhongKernelType findPhongKernel(const char* name)
+{
+	for (int i = 0; i < NB_PHONG_KERNELS; i++)
+	{
+		if (strcmp(name, getPhongKernelName((PhongKernelType)i)) == 0 && isPhongKernelSupported((PhongKernelType)i))
+		{
+			return (PhongKernelType)i;
+		}
+	}
+	return getBestPhongKernel();
+}
+
+//Mesmo calculo das versoes SIMD, lane a lane, com a semantica das instrucoes delas: min e
+//max devolvem o segundo operando com NaN, como minps e maxps, e a conversao truncada devolve
+//0x80000000 fora do intervalo, como cvttps2dq. As operacoes inteiras sao sem sinal para o
+//estouro dar a volta como nos registradores
+namespace
+{
+	struct Scalar
+	{
+		enum { LANES = 4 };
+		struct F { float v[LANES]; };
+		struct I { int32_t v[LANES]; };
+		struct M { bool v[LANES]; };
+
+		static F set1(float a) { F r; for (int k = 0; k < LANES; k++) r.v[k] = a; return r; }
+		static I set1i(int32_t a) { I r; for (int k = 0; k < LANES; k++) r.v[k] = a; return r; }
+		static F load(const float* p) { F r; memcpy(r.v, p, sizeof(r.v)); return r; }
+		static I loadi(const int32_t* p) { I r; memcpy(r.v, p, sizeof(r.v)); return r; }
+		static void storei(uint32_t* p, I a) { memcpy(p, a.v, sizeof(a.v)); }
+
+		static F add(F a, F b) { for (int k = 0; k < LANES; k++) a.v[k] += b.v[k]; return a; }
+		static F sub(F a, F b) { for (int k = 0; k < LANES; k++) a.v[k] -= b.v[k]; return a; }
+		static F mul(F a, F b) { for (int k = 0; k < LANES; k++) a.v[k] *= b.v[k]; return a; }
+		static F div(F a, F b) { for (int k = 0; k < LANES; k++) a.v[k] /= b.v[k]; return a; }
+		static F madd(F a, F b, F c) { return add(mul(a, b), c); }
+		static F min(F a, F b) { for (int k = 0; k < LANES; k++) a.v[k] = a.v[k] < b.v[k] ? a.v[k] : b.v[k]; return a; }
+		static F max(F a, F b) { for (int k = 0; k < LANES; k++) a.v[k] = a.v[k] > b.v[k] ? a.v[k] : b.v[k]; return a; }
+		static F sqrt(F a) { for (int k = 0; k < LANES; k++) a.v[k] = std::sqrt(a.v[k]); return a; }
+		static F floor(F a) { for (int k = 0; k < LANES; k++) a.v[k] = std::floor(a.v[k]); return a; }
+
+		static I toInt(F a)
+		{
+			I r;
+			for (int k = 0; k < LANES; k++)
+			{
+				r.v[k] = a.v[k] >= -2147483648.0f && a.v[k] < 2147483648.0f ? (int32_t)a.v[k] : INT32_MIN;
+			}
+			return r;
+		}
+		static F toFloat(I a) { F r; for (int k = 0; k < LANES; k++) r.v[k] = (float)a.v[k]; return r; }
+		static I asInt(F a) { I r; memcpy(r.v, a.v, sizeof(r.v)); return r; }
+		static F asFloat(I a) { F r; memcpy(r.v, a.v, sizeof(r.v)); return r; }
+
+		static I addi(I a, I b) { for (int k = 0; k < LANES; k++) a.v[k] = (int32_t)((uint32_t)a.v[k] + (uint32_t)b.v[k]); return a; }
+		static I subi(I a, I b) { for (int k = 0; k < LANES; k++) a.v[k] = (int32_t)((uint32_t)a.v[k] - (uint32_t)b.v[k]); return a; }
+		static I andi(I a, I b) { for (int k = 0; k < LANES; k++) a.v[k] &= b.v[k]; return a; }
+		static I ori(I a, I b) { for (int k = 0; k < LANES; k++) a.v[k] |= b.v[k]; return a; }
+		static I slli(I a, int n) { for (int k = 0; k < LANES; k++) a.v[k] = (int32_t)((uint32_t)a.v[k] << n); return a; }
+		static I srli(I a, int n) { for (int k = 0; k < LANES; k++) a.v[k] = (int32_t)((uint32_t)a.v[k] >> n); return a; }
+		static I mullo(I a, I b) { for (int k = 0; k < LANES; k++) a.v[k] = (int32_t)((uint32_t)a.v[k] * (uint32_t)b.v[k]); return a; }
+
+		static M less(F a, F b) { M r; for (int k = 0; k < LANES; k++) r.v[k] = a.v[k] < b.v[k]; return r; }
+		static M lessi(I a, I b) { M r; for (int k = 0; k < LANES; k++) r.v[k] = a.v[k] < b.v[k]; return r; }
+		static F select(M m, F a, F b) { for (int k = 0; k < LANES; k++) a.v[k] = m.v[k] ? a.v[k] : b.v[k]; return a; }
+		static I selecti(M m, I a, I b) { for (int k = 0; k < LANES; k++) a.v[k] = m.v[k] ? a.v[k] : b.v[k]; return a; }
+
+		static F gather(const float* base, I index) { F r; for (int k = 0; k < LANES; k++) r.v[k] = base[index.v[k]]; return r; }
+		static I gatheri(const int32_t* base, I index) { I r; for (int k = 0; k < LANES; k++) r.v[k] = base[index.v[k]]; return r; }
+
+		//LANES e um quad
+		template<int lane>
+		static F quadLane(F a) { return set1(a.v[lane]); }
+	};
+}
+
+void shadePhongScalar(const PhongUniforms& uniforms, PhongBatch& batch)
+{
+	shadePhong<Scalar>(uniforms, batch);
+}
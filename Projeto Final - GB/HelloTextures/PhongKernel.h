@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+//Sombreamento de Phong de sprite.fs em lotes, para o SoftwareRenderer. Os pixels chegam
+//em quads 2x2 (4 lanes consecutivas: (0,0), (1,0), (0,1), (1,1)), como na GPU: as
+//derivadas da UV saem das diferencas dentro do quad e escolhem o mipmap. Cada versao SIMD
+//processa 4, 8 ou 16 lanes (1, 2 ou 4 quads) por vez; pow, log2 e exp2 sao aproximacoes
+//polinomiais (erro relativo ~1e-6). Todas as versoes, inclusive a escalar, fazem as mesmas
+//operacoes e geram os mesmos bytes. A versao e escolhida pelo CPUID na primeira chamada
+
+//Lote em SoA; nbLanes e multiplo de PHONG_BATCH_ALIGN (quads repetidos completam o fim)
+struct PhongBatch
+{
+	enum { MAX_LANES = 256 };
+
+	alignas(64) float positionX[MAX_LANES];
+	alignas(64) float positionY[MAX_LANES];
+	alignas(64) float positionZ[MAX_LANES];
+	alignas(64) float normalX[MAX_LANES];
+	alignas(64) float normalY[MAX_LANES];
+	alignas(64) float normalZ[MAX_LANES];
+	alignas(64) float u[MAX_LANES];
+	alignas(64) float v[MAX_LANES];
+	alignas(64) int32_t material[MAX_LANES]; //igual nas 4 lanes do quad
+	alignas(64) uint32_t color[MAX_LANES]; //saida RGBA8
+	alignas(64) int32_t pixel[MAX_LANES]; //destino na imagem; -1 em lanes auxiliares (nao e lido pelo kernel)
+	int nbLanes = 0;
+};
+
+const int PHONG_BATCH_ALIGN = 16;
+
+//Mipmaps de todas as texturas em um unico vetor de texels RGBA8, para um gather com a mesma
+//base servir lanes de materiais diferentes. Materiais sem textura apontam para um texel branco
+const int PHONG_MAX_LEVELS = 16;
+
+//Dados constantes do lote: luz, camera e materiais em SoA
+struct PhongUniforms
+{
+	float lightPos[3], lightColor[3], cameraPos[3];
+	const float* ka[3];
+	const float* kd;
+	const float* ks[3];
+	const float* q;
+	//Por material: numero de niveis e, por nivel (material * PHONG_MAX_LEVELS + nivel), inicio e tamanho
+	const int32_t* nbLevels;
+	const int32_t* levelOffset;
+	const int32_t* levelWidth;
+	const int32_t* levelHeight;
+	const uint32_t* texels;
+};
+
+typedef void (*PhongKernel)(const PhongUniforms& uniforms, PhongBatch& batch);
+
+enum PhongKernelType
+{
+	PHONG_SCALAR, //referencia lane a lane, sem SIMD
+	PHONG_SSE2,
+	PHONG_AVX2,
+	PHONG_AVX512,
+	NB_PHONG_KERNELS
+};
+
+//Verifica no CPUID e no XCR0 se a CPU e o sistema operacional suportam o conjunto de instrucoes
+bool isPhongKernelSupported(PhongKernelType type);
+PhongKernelType getBestPhongKernel();
+PhongKernel getPhongKernel(PhongKernelType type);
+const char* getPhongKernelName(PhongKernelType type);
+//Tipo pelo nome (scalar, sse2, avx2, avx512); o melhor suportado se o nome nao existir
+PhongKernelType findPhongKernel(const char* name);
+
+void shadePhongScalar(const PhongUniforms& uniforms, PhongBatch& batch);
+void shadePhongSSE2(const PhongUniforms& uniforms, PhongBatch& batch);
+void shadePhongAVX2(const PhongUniforms& uniforms, PhongBatch& batch);
+void shadePhongAVX512(const PhongUniforms& uniforms, PhongBatch& batch);
@@ -0,0 +1,73 @@
+//Compilado com AVX2 mesmo que o projeto nao use /arch:AVX2 (no Visual Studio o
+//arquivo tem o proprio EnableEnhancedInstructionSet); so e chamado se o CPUID confirmar
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
+#include <immintrin.h>
+
+#include "PhongKernelSIMD.h"
+
+namespace
+{
+	struct AVX2
+	{
+		enum { LANES = 8 };
+		typedef __m256 F;
+		typedef __m256i I;
+		typedef __m256 M;
+
+		static F set1(float a) { return _mm256_set1_ps(a); }
+		static I set1i(int32_t a) { return _mm256_set1_epi32(a); }
+		static F load(const float* p) { return _mm256_load_ps(p); }
+		static I loadi(const int32_t* p) { return _mm256_load_si256((const __m256i*)p); }
+		static void storei(uint32_t* p, I a) { _mm256_store_si256((__m256i*)p, a); }
+
+		static F add(F a, F b) { return _mm256_add_ps(a, b); }
+		static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+		static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+		static F div(F a, F b) { return _mm256_div_ps(a, b); }
+		//Multiplicacao e soma separadas, como nas outras versoes: FMA arredondaria uma vez so
+		static F madd(F a, F b, F c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+		static F min(F a, F b) { return _mm256_min_ps(a, b); }
+		static F max(F a, F b) { return _mm256_max_ps(a, b); }
+		static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+		static F floor(F a) { return _mm256_floor_ps(a); }
+
+		static I toInt(F a) { return _mm256_cvttps_epi32(a); }
+		static F toFloat(I a) { return _mm256_cvtepi32_ps(a); }
+		static I asInt(F a) { return _mm256_castps_si256(a); }
+		static F asFloat(I a) { return _mm256_castsi256_ps(a); }
+
+		static I addi(I a, I b) { return _mm256_add_epi32(a, b); }
+		static I subi(I a, I b) { return _mm256_sub_epi32(a, b); }
+		static I andi(I a, I b) { return _mm256_and_si256(a, b); }
+		static I ori(I a, I b) { return _mm256_or_si256(a, b); }
+		static I slli(I a, int n) { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+		static I srli(I a, int n) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+		static I mullo(I a, I b) { return _mm256_mullo_epi32(a, b); }
+
+		static M less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static M lessi(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+		static F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+		static I selecti(M m, I a, I b) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m)); }
+
+		static F gather(const float* base, I index) { return _mm256_i32gather_ps(base, index, 4); }
+		static I gatheri(const int32_t* base, I index) { return _mm256_i32gather_epi32((const int*)base, index, 4); }
+
+		//Cada metade de 128 bits e um quad
+		template<int lane>
+		static F quadLane(F a) { return _mm256_permute_ps(a, _MM_SHUFFLE(lane, lane, lane, lane)); }
+	};
+}
+
+void shadePhongAVX2(const PhongUniforms& uniforms, PhongBatch& batch)
+{
+	shadePhong<AVX2>(uniforms, batch);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,74 @@
+//Compilado com AVX-512F mesmo que o projeto nao use /arch:AVX512 (no Visual Studio o
+//arquivo tem o proprio EnableEnhancedInstructionSet); so e chamado se o CPUID confirmar
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx512f")
+#endif
+
+#include <immintrin.h>
+
+#include "PhongKernelSIMD.h"
+
+namespace
+{
+	struct AVX512
+	{
+		enum { LANES = 16 };
+		typedef __m512 F;
+		typedef __m512i I;
+		typedef __mmask16 M;
+
+		static F set1(float a) { return _mm512_set1_ps(a); }
+		static I set1i(int32_t a) { return _mm512_set1_epi32(a); }
+		static F load(const float* p) { return _mm512_load_ps(p); }
+		static I loadi(const int32_t* p) { return _mm512_load_si512((const void*)p); }
+		static void storei(uint32_t* p, I a) { _mm512_store_si512((void*)p, a); }
+
+		static F add(F a, F b) { return _mm512_add_ps(a, b); }
+		static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+		static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+		static F div(F a, F b) { return _mm512_div_ps(a, b); }
+		//Multiplicacao e soma separadas, como nas outras versoes: FMA arredondaria uma vez so
+		static F madd(F a, F b, F c) { return _mm512_add_ps(_mm512_mul_ps(a, b), c); }
+		static F min(F a, F b) { return _mm512_min_ps(a, b); }
+		static F max(F a, F b) { return _mm512_max_ps(a, b); }
+		static F sqrt(F a) { return _mm512_sqrt_ps(a); }
+		static F floor(F a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+		static I toInt(F a) { return _mm512_cvttps_epi32(a); }
+		static F toFloat(I a) { return _mm512_cvtepi32_ps(a); }
+		static I asInt(F a) { return _mm512_castps_si512(a); }
+		static F asFloat(I a) { return _mm512_castsi512_ps(a); }
+
+		static I addi(I a, I b) { return _mm512_add_epi32(a, b); }
+		static I subi(I a, I b) { return _mm512_sub_epi32(a, b); }
+		static I andi(I a, I b) { return _mm512_and_si512(a, b); }
+		static I ori(I a, I b) { return _mm512_or_si512(a, b); }
+		static I slli(I a, int n) { return _mm512_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+		static I srli(I a, int n) { return _mm512_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+		static I mullo(I a, I b) { return _mm512_mullo_epi32(a, b); }
+
+		//Comparacoes geram mascaras de 16 bits em vez de vetores
+		static M less(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		static M lessi(I a, I b) { return _mm512_cmplt_epi32_mask(a, b); }
+		static F select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+		static I selecti(M m, I a, I b) { return _mm512_mask_blend_epi32(m, b, a); }
+
+		static F gather(const float* base, I index) { return _mm512_i32gather_ps(index, base, 4); }
+		static I gatheri(const int32_t* base, I index) { return _mm512_i32gather_epi32(index, base, 4); }
+
+		//Cada bloco de 128 bits e um quad
+		template<int lane>
+		static F quadLane(F a) { return _mm512_permute_ps(a, _MM_SHUFFLE(lane, lane, lane, lane)); }
+	};
+}
+
+void shadePhongAVX512(const PhongUniforms& uniforms, PhongBatch& batch)
+{
+	shadePhong<AVX512>(uniforms, batch);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
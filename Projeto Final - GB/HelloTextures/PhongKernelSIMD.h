@@ -0,0 +1,220 @@
+#pragma once
+
+#include "PhongKernel.h"
+
+//Corpo do kernel de Phong, escrito uma vez sobre a interface V (tipos F, I e M e operacoes
+//escalares, de SSE2, AVX2 ou AVX-512) e instanciado em um .cpp por conjunto de instrucoes,
+//cada um compilado para a sua CPU. Fica em namespace anonimo: nada daqui pode ser compartilhado
+//entre esses .cpp, senao o ligador poderia usar a copia AVX-512 em uma CPU sem ela.
+//Todas as versoes geram os mesmos bytes: so usam operacoes com arredondamento exato do IEEE
+//(sem FMA nem rsqrt, cujos resultados mudam entre conjuntos de instrucoes e fabricantes) na
+//mesma ordem, e o compilador nao pode fundir multiplicacoes e somas
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+namespace
+{
+	template<class V>
+	inline typename V::F dot3(typename V::F ax, typename V::F ay, typename V::F az, typename V::F bx, typename V::F by, typename V::F bz)
+	{
+		return V::madd(ax, bx, V::madd(ay, by, V::mul(az, bz)));
+	}
+
+	template<class V>
+	inline void normalize3(typename V::F& x, typename V::F& y, typename V::F& z)
+	{
+		typename V::F length2 = dot3<V>(x, y, z, x, y, z);
+		typename V::F r = V::div(V::set1(1.0f), V::sqrt(length2));
+		x = V::mul(x, r);
+		y = V::mul(y, r);
+		z = V::mul(z, r);
+	}
+
+	//x > 0. Expoente do float mais ln da mantissa em [sqrt(1/2), sqrt(2)) pela serie de atanh
+	template<class V>
+	inline typename V::F log2Approx(typename V::F x)
+	{
+		typedef typename V::F F;
+		typedef typename V::I I;
+		I bits = V::asInt(x);
+		F exponent = V::toFloat(V::subi(V::srli(bits, 23), V::set1i(127)));
+		F mantissa = V::asFloat(V::ori(V::andi(bits, V::set1i(0x007FFFFF)), V::set1i(0x3F800000)));
+		typename V::M big = V::less(V::set1(1.41421356f), mantissa);
+		mantissa = V::select(big, V::mul(mantissa, V::set1(0.5f)), mantissa);
+		exponent = V::add(exponent, V::select(big, V::set1(1.0f), V::set1(0.0f)));
+
+		F s = V::div(V::sub(mantissa, V::set1(1.0f)), V::add(mantissa, V::set1(1.0f)));
+		F s2 = V::mul(s, s);
+		F p = V::madd(s2, V::set1(2.0f / 7.0f), V::set1(2.0f / 5.0f));
+		p = V::madd(s2, p, V::set1(2.0f / 3.0f));
+		p = V::madd(s2, p, V::set1(2.0f));
+		return V::madd(V::mul(s, p), V::set1(1.44269504f), exponent);
+	}
+
+	//2^x: inteiro mais proximo no expoente e Taylor de grau 6 em [-1/2, 1/2]
+	template<class V>
+	inline typename V::F exp2Approx(typename V::F x)
+	{
+		typedef typename V::F F;
+		x = V::min(V::max(x, V::set1(-126.0f)), V::set1(127.0f));
+		F rounded = V::floor(V::add(x, V::set1(0.5f)));
+		F t = V::mul(V::sub(x, rounded), V::set1(0.69314718f));
+		F p = V::madd(t, V::set1(1.0f / 720.0f), V::set1(1.0f / 120.0f));
+		p = V::madd(t, p, V::set1(1.0f / 24.0f));
+		p = V::madd(t, p, V::set1(1.0f / 6.0f));
+		p = V::madd(t, p, V::set1(0.5f));
+		p = V::madd(t, p, V::set1(1.0f));
+		p = V::madd(t, p, V::set1(1.0f));
+		F scale = V::asFloat(V::slli(V::addi(V::toInt(rounded), V::set1i(127)), 23));
+		return V::mul(p, scale);
+	}
+
+	//pow(x, q) para x >= 0; 0 quando x e 0
+	template<class V>
+	inline typename V::F powApprox(typename V::F x, typename V::F q)
+	{
+		typename V::M positive = V::less(V::set1(0.0f), x);
+		typename V::F result = exp2Approx<V>(V::mul(q, log2Approx<V>(V::max(x, V::set1(1e-30f)))));
+		return V::select(positive, result, V::set1(0.0f));
+	}
+
+	template<class V>
+	inline void unpackTexel(typename V::I texel, typename V::F* rgb)
+	{
+		typename V::I mask = V::set1i(0xFF);
+		rgb[0] = V::toFloat(V::andi(texel, mask));
+		rgb[1] = V::toFloat(V::andi(V::srli(texel, 8), mask));
+		rgb[2] = V::toFloat(V::andi(V::srli(texel, 16), mask));
+	}
+
+	//GL_LINEAR com GL_REPEAT no nivel indicado (material * PHONG_MAX_LEVELS + nivel), em [0, 255].
+	//u e v em [0, 1]: os texels vizinhos so podem dar a volta em uma borda
+	template<class V>
+	inline void sampleBilinear(const PhongUniforms& uniforms, typename V::I level, typename V::F u, typename V::F v, typename V::F* rgb)
+	{
+		typedef typename V::F F;
+		typedef typename V::I I;
+		I width = V::gatheri(uniforms.levelWidth, level);
+		I height = V::gatheri(uniforms.levelHeight, level);
+		I offset = V::gatheri(uniforms.levelOffset, level);
+		F widthF = V::toFloat(width), heightF = V::toFloat(height);
+
+		F x = V::sub(V::mul(u, widthF), V::set1(0.5f));
+		F y = V::sub(V::mul(v, heightF), V::set1(0.5f));
+		F x0 = V::floor(x), y0 = V::floor(y);
+		F wx = V::sub(x, x0), wy = V::sub(y, y0);
+
+		I column0 = V::toInt(x0);
+		column0 = V::selecti(V::lessi(column0, V::set1i(0)), V::addi(column0, width), column0);
+		I row0 = V::toInt(y0);
+		row0 = V::selecti(V::lessi(row0, V::set1i(0)), V::addi(row0, height), row0);
+		I column1 = V::addi(column0, V::set1i(1));
+		column1 = V::selecti(V::lessi(column1, width), column1, V::set1i(0));
+		I row1 = V::addi(row0, V::set1i(1));
+		row1 = V::selecti(V::lessi(row1, height), row1, V::set1i(0));
+
+		const int32_t* texels = (const int32_t*)uniforms.texels;
+		I top = V::addi(offset, V::mullo(row0, width));
+		I bottom = V::addi(offset, V::mullo(row1, width));
+		F t00[3], t10[3], t01[3], t11[3];
+		unpackTexel<V>(V::gatheri(texels, V::addi(top, column0)), t00);
+		unpackTexel<V>(V::gatheri(texels, V::addi(top, column1)), t10);
+		unpackTexel<V>(V::gatheri(texels, V::addi(bottom, column0)), t01);
+		unpackTexel<V>(V::gatheri(texels, V::addi(bottom, column1)), t11);
+
+		for (int c = 0; c < 3; c++)
+		{
+			F upper = V::madd(V::sub(t10[c], t00[c]), wx, t00[c]);
+			F lower = V::madd(V::sub(t11[c], t01[c]), wx, t01[c]);
+			rgb[c] = V::madd(V::sub(lower, upper), wy, upper);
+		}
+	}
+
+	template<class V>
+	void shadePhong(const PhongUniforms& uniforms, PhongBatch& batch)
+	{
+		typedef typename V::F F;
+		typedef typename V::I I;
+
+		const F zero = V::set1(0.0f), one = V::set1(1.0f);
+		F lightPos[3], lightColor[3], cameraPos[3];
+		for (int c = 0; c < 3; c++)
+		{
+			lightPos[c] = V::set1(uniforms.lightPos[c]);
+			lightColor[c] = V::set1(uniforms.lightColor[c]);
+			cameraPos[c] = V::set1(uniforms.cameraPos[c]);
+		}
+
+		for (int i = 0; i < batch.nbLanes; i += V::LANES)
+		{
+			F px = V::load(batch.positionX + i), py = V::load(batch.positionY + i), pz = V::load(batch.positionZ + i);
+			F nx = V::load(batch.normalX + i), ny = V::load(batch.normalY + i), nz = V::load(batch.normalZ + i);
+			I material = V::loadi(batch.material + i);
+
+			//Diffuse
+			normalize3<V>(nx, ny, nz);
+			F lx = V::sub(lightPos[0], px), ly = V::sub(lightPos[1], py), lz = V::sub(lightPos[2], pz);
+			normalize3<V>(lx, ly, lz);
+			F nDotL = dot3<V>(nx, ny, nz, lx, ly, lz);
+			F diff = V::max(nDotL, zero);
+
+			//Specular: reflect(-L, N) = 2 * dot(N, L) * N - L
+			F twoNDotL = V::add(nDotL, nDotL);
+			F rx = V::madd(twoNDotL, nx, V::sub(zero, lx));
+			F ry = V::madd(twoNDotL, ny, V::sub(zero, ly));
+			F rz = V::madd(twoNDotL, nz, V::sub(zero, lz));
+			F vx = V::sub(cameraPos[0], px), vy = V::sub(cameraPos[1], py), vz = V::sub(cameraPos[2], pz);
+			normalize3<V>(vx, vy, vz);
+			F spec = powApprox<V>(V::max(dot3<V>(rx, ry, rz, vx, vy, vz), zero), V::gather(uniforms.q, material));
+
+			//Derivadas grossas do quad, como dFdx/dFdy: lane 1 - lane 0 e lane 2 - lane 0
+			F u = V::load(batch.u + i), v = V::load(batch.v + i);
+			F u0 = V::template quadLane<0>(u), v0 = V::template quadLane<0>(v);
+			I levels = V::slli(material, 4);
+			I nbLevels = V::gatheri(uniforms.nbLevels, material);
+			F width = V::toFloat(V::gatheri(uniforms.levelWidth, levels));
+			F height = V::toFloat(V::gatheri(uniforms.levelHeight, levels));
+			F dudx = V::mul(V::sub(V::template quadLane<1>(u), u0), width), dvdx = V::mul(V::sub(V::template quadLane<1>(v), v0), height);
+			F dudy = V::mul(V::sub(V::template quadLane<2>(u), u0), width), dvdy = V::mul(V::sub(V::template quadLane<2>(v), v0), height);
+			F rho2 = V::max(V::madd(dudx, dudx, V::mul(dvdx, dvdx)), V::madd(dudy, dudy, V::mul(dvdy, dvdy)));
+			F lod = V::mul(V::set1(0.5f), log2Approx<V>(V::max(rho2, V::set1(1e-12f))));
+			F maxLevel = V::toFloat(V::subi(nbLevels, V::set1i(1)));
+			lod = V::min(V::max(lod, zero), maxLevel);
+
+			//GL_REPEAT: depois das derivadas so a parte fracionaria importa. O limite tambem troca
+			//NaN e infinitos de lanes auxiliares (fora do triangulo) por valores validos
+			const F limit = V::set1(1e6f);
+			u = V::max(V::min(u, limit), V::sub(zero, limit));
+			v = V::max(V::min(v, limit), V::sub(zero, limit));
+			u = V::sub(u, V::floor(u));
+			v = V::sub(v, V::floor(v));
+
+			//GL_LINEAR_MIPMAP_LINEAR: dois niveis bilineares
+			F level = V::floor(lod);
+			F blend = V::sub(lod, level);
+			F nextLevel = V::min(V::add(level, one), maxLevel);
+			F fine[3], coarse[3];
+			sampleBilinear<V>(uniforms, V::addi(levels, V::toInt(level)), u, v, fine);
+			sampleBilinear<V>(uniforms, V::addi(levels, V::toInt(nextLevel)), u, v, coarse);
+
+			I packed = V::set1i((int32_t)0xFF000000);
+			for (int c = 0; c < 3; c++)
+			{
+				F texColor = V::mul(V::madd(V::sub(coarse[c], fine[c]), blend, fine[c]), V::set1(1.0f / 255.0f));
+				F ambient = V::mul(lightColor[c], V::gather(uniforms.ka[c], material));
+				F diffuse = V::mul(V::mul(diff, lightColor[c]), V::gather(uniforms.kd, material));
+				F specular = V::mul(V::mul(spec, V::gather(uniforms.ks[c], material)), lightColor[c]);
+				F result = V::madd(V::add(ambient, diffuse), texColor, specular);
+				result = V::min(V::max(result, zero), one);
+				I channel = V::toInt(V::madd(result, V::set1(255.0f), V::set1(0.5f)));
+				packed = V::ori(packed, V::slli(channel, 8 * c));
+			}
+			V::storei(batch.color + i, packed);
+		}
+	}
+}
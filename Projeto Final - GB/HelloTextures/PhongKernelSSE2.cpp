@@ -0,0 +1,82 @@
+//SSE2 faz parte de toda CPU x64: e a versao minima do kernel
+#include <emmintrin.h>
+
+#include "PhongKernelSIMD.h"
+
+namespace
+{
+	struct SSE2
+	{
+		enum { LANES = 4 };
+		typedef __m128 F;
+		typedef __m128i I;
+		typedef __m128 M;
+
+		static F set1(float a) { return _mm_set1_ps(a); }
+		static I set1i(int32_t a) { return _mm_set1_epi32(a); }
+		static F load(const float* p) { return _mm_load_ps(p); }
+		static I loadi(const int32_t* p) { return _mm_load_si128((const __m128i*)p); }
+		static void storei(uint32_t* p, I a) { _mm_store_si128((__m128i*)p, a); }
+
+		static F add(F a, F b) { return _mm_add_ps(a, b); }
+		static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+		static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+		static F div(F a, F b) { return _mm_div_ps(a, b); }
+		static F madd(F a, F b, F c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+		static F min(F a, F b) { return _mm_min_ps(a, b); }
+		static F max(F a, F b) { return _mm_max_ps(a, b); }
+		static F sqrt(F a) { return _mm_sqrt_ps(a); }
+		//Sem _mm_floor_ps (SSE4.1): trunca e corrige os negativos
+		static F floor(F a)
+		{
+			F truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+			return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1.0f)));
+		}
+
+		static I toInt(F a) { return _mm_cvttps_epi32(a); }
+		static F toFloat(I a) { return _mm_cvtepi32_ps(a); }
+		static I asInt(F a) { return _mm_castps_si128(a); }
+		static F asFloat(I a) { return _mm_castsi128_ps(a); }
+
+		static I addi(I a, I b) { return _mm_add_epi32(a, b); }
+		static I subi(I a, I b) { return _mm_sub_epi32(a, b); }
+		static I andi(I a, I b) { return _mm_and_si128(a, b); }
+		static I ori(I a, I b) { return _mm_or_si128(a, b); }
+		static I slli(I a, int n) { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+		static I srli(I a, int n) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+		//Sem _mm_mullo_epi32 (SSE4.1): produtos pares e impares de 64 bits
+		static I mullo(I a, I b)
+		{
+			__m128i even = _mm_mul_epu32(a, b);
+			__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+
+		static M less(F a, F b) { return _mm_cmplt_ps(a, b); }
+		static M lessi(I a, I b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+		static F select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+		static I selecti(M m, I a, I b) { return _mm_castps_si128(select(m, _mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+
+		//Sem gather: leitura lane a lane
+		static F gather(const float* base, I index)
+		{
+			alignas(16) int32_t i[4];
+			_mm_store_si128((__m128i*)i, index);
+			return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+		}
+		static I gatheri(const int32_t* base, I index)
+		{
+			alignas(16) int32_t i[4];
+			_mm_store_si128((__m128i*)i, index);
+			return _mm_setr_epi32(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+		}
+
+		template<int lane>
+		static F quadLane(F a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(lane, lane, lane, lane)); }
+	};
+}
+
+void shadePhongSSE2(const PhongUniforms& uniforms, PhongBatch& batch)
+{
+	shadePhong<SSE2>(uniforms, batch);
+}
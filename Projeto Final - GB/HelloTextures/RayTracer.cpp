@@ -0,0 +1,406 @@
+#include "RayTracer.h"
+#include "stb_image.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+
+//Deslocamento da origem dos raios de sombra e de reflexo na normal da face, para nao
+//atingirem o proprio triangulo
+static const float SURFACE_OFFSET = 1e-4f;
+//Reflectancia de um dieletrico na incidencia normal, no Fresnel de Schlick
+static const float FRESNEL_F0 = 0.04f;
+//Reflexos com peso menor que isso nao mudam a cor em 8 bits
+static const float MIN_THROUGHPUT = 1.0f / 512.0f;
+
+static int countLanes(int mask)
+{
+	return (mask & 1) + (mask >> 1 & 1) + (mask >> 2 & 1) + (mask >> 3 & 1);
+}
+
+void RayTracer::initialize(int width, int height, int nbThreads)
+{
+	this->width = width;
+	this->height = height;
+	nbTilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	nbTilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	color.assign((size_t)width * height * 4, 255);
+
+	if (nbThreads <= 0)
+	{
+		nbThreads = max(1, (int)thread::hardware_concurrency());
+	}
+	workers.stop();
+	nbWorkers = nbThreads - 1;
+	if (nbWorkers > 0)
+	{
+		workers.start(nbWorkers);
+	}
+}
+
+void RayTracer::loadMaterials(MaterialLibrary& library)
+{
+	vector<string> paths;
+	materials.clear();
+	textures.clear();
+	for (int i = 0; i < library.getNbMaterials(); i++)
+	{
+		Material material;
+		glm::vec4 ka = library.getAmbient(i), ks = library.getSpecular(i);
+		material.ka = glm::vec3(ka);
+		material.kd = ka.w;
+		material.ks = glm::vec3(ks);
+		material.q = ks.w;
+		material.texture = -1;
+
+		string path = library.getTexturePath(i);
+		if (!path.empty())
+		{
+			material.texture = find(paths.begin(), paths.end(), path) - paths.begin();
+			if (material.texture == paths.size())
+			{
+				paths.push_back(path);
+				//Sem texels se a imagem nao abre: a textura fica branca
+				textures.push_back(Texture());
+				int nrChannels;
+				Texture& texture = textures.back();
+				unsigned char* data = stbi_load(path.c_str(), &texture.width, &texture.height, &nrChannels, 4);
+				if (data)
+				{
+					const uint32_t* texels = (const uint32_t*)data;
+					texture.texels.assign(texels, texels + (size_t)texture.width * texture.height);
+					stbi_image_free(data);
+				}
+				else
+				{
+					cout << "Failed to load texture" << endl;
+				}
+			}
+		}
+		materials.push_back(material);
+	}
+}
+
+void RayTracer::setQuality(int samples, int bounces)
+{
+	this->samples = max(1, samples);
+	this->bounces = max(0, bounces);
+}
+
+void RayTracer::setCamera(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos)
+{
+	inverseViewProjection = glm::inverse(projection * view);
+	this->cameraPos = cameraPos;
+}
+
+void RayTracer::setLight(glm::vec3 lightPos, glm::vec3 lightColor)
+{
+	this->lightPos = lightPos;
+	this->lightColor = lightColor;
+}
+
+void RayTracer::begin(glm::vec3 clearColor)
+{
+	this->clearColor = clearColor;
+	positions.clear();
+	normals.clear();
+	textureCoords.clear();
+	triangleMaterials.clear();
+}
+
+void RayTracer::draw(Mesh& mesh, float pathTime)
+{
+	const MeshSource* source = mesh.getSource();
+	if (!source || source->positions.empty())
+	{
+		return;
+	}
+
+	//sprite.vs: a normal nao e transformada e o v da textura e invertido
+	glm::mat4 model = mesh.getModelMatrix();
+	int nbVertices = source->positions.size() / 3;
+	for (int instance = 0; instance < mesh.getNbInstances(); instance++)
+	{
+		glm::vec3 offset = mesh.getPathOffset(instance, pathTime);
+		for (int i = 0; i < nbVertices; i++)
+		{
+			const float* position = &source->positions[i * 3];
+			positions.push_back(glm::vec3(model * glm::vec4(position[0], position[1], position[2], 1.0f)) + offset);
+			normals.push_back(glm::vec3(source->normals[i * 3], source->normals[i * 3 + 1], source->normals[i * 3 + 2]));
+			textureCoords.push_back(glm::vec2(source->textureCoords[i * 2], 1.0f - source->textureCoords[i * 2 + 1]));
+		}
+		triangleMaterials.insert(triangleMaterials.end(), nbVertices / 3, mesh.getMaterialId());
+	}
+}
+
+void RayTracer::end()
+{
+	auto start = chrono::high_resolution_clock::now();
+	bvh.build(positions);
+	auto built = chrono::high_resolution_clock::now();
+	buildTime = chrono::duration<double, milli>(built - start).count();
+
+	primaryRays = 0;
+	shadowRays = 0;
+	reflectionRays = 0;
+	nextTile = 0;
+	int nbTiles = nbTilesX * nbTilesY;
+	auto run = [this, nbTiles] {
+		for (int i = nextTile++; i < nbTiles; i = nextTile++)
+		{
+			renderTile(i);
+		}
+	};
+	for (int i = 0; i < min(nbWorkers, nbTiles - 1); i++)
+	{
+		workers.submit(run);
+	}
+	run();
+	workers.wait();
+
+	traceTime = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - built).count();
+	nbPrimaryRays = primaryRays;
+	nbShadowRays = shadowRays;
+	nbReflectionRays = reflectionRays;
+}
+
+void RayTracer::renderTile(int tile)
+{
+	int startX = tile % nbTilesX * TILE_SIZE, endX = min(width, startX + TILE_SIZE);
+	int startY = tile / nbTilesX * TILE_SIZE, endY = min(height, startY + TILE_SIZE);
+	RayCounts counts;
+	float sampleWeight = 1.0f / (samples * samples);
+
+	for (int y = startY; y < endY; y += 2)
+	{
+		for (int x = startX; x < endX; x += 2)
+		{
+			int active = 0;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (x + (lane & 1) < width && y + (lane >> 1) < height)
+				{
+					active |= 1 << lane;
+				}
+			}
+
+			//Grade regular dentro do pixel: a mesma posicao nas 4 lanes mantem o pacote coerente
+			glm::vec3 sums[4] = {};
+			for (int sample = 0; sample < samples * samples; sample++)
+			{
+				glm::vec3 origins[4], directions[4];
+				float maxDistances[4];
+				for (int lane = 0; lane < 4; lane++)
+				{
+					float px = x + (lane & 1) + (sample % samples + 0.5f) / samples;
+					float py = y + (lane >> 1) + (sample / samples + 0.5f) / samples;
+					glm::vec2 ndc(px / width * 2.0f - 1.0f, py / height * 2.0f - 1.0f);
+					//Do plano near ao far, como o recorte da rasterizacao
+					glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+					glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+					origins[lane] = glm::vec3(nearPoint) / nearPoint.w;
+					glm::vec3 toFar = glm::vec3(farPoint) / farPoint.w - origins[lane];
+					maxDistances[lane] = glm::length(toFar);
+					directions[lane] = toFar / maxDistances[lane];
+				}
+
+				RayPacket packet;
+				packet.set(origins, directions, maxDistances);
+				glm::vec3 colors[4];
+				tracePacket(packet, active, colors, counts);
+				counts.primary += countLanes(active);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					sums[lane] += glm::clamp(colors[lane], 0.0f, 1.0f);
+				}
+			}
+
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (!(active & 1 << lane))
+				{
+					continue;
+				}
+				unsigned char* out = &color[((size_t)(y + (lane >> 1)) * width + x + (lane & 1)) * 4];
+				for (int c = 0; c < 3; c++)
+				{
+					out[c] = (unsigned char)(sums[lane][c] * sampleWeight * 255.0f + 0.5f);
+				}
+				out[3] = 255;
+			}
+		}
+	}
+
+	primaryRays += counts.primary;
+	shadowRays += counts.shadow;
+	reflectionRays += counts.reflection;
+}
+
+void RayTracer::tracePacket(RayPacket& packet, int active, glm::vec3* colors, RayCounts& counts)
+{
+	glm::vec3 throughput[4];
+	for (int lane = 0; lane < 4; lane++)
+	{
+		colors[lane] = glm::vec3(0.0f);
+		throughput[lane] = glm::vec3(1.0f);
+	}
+
+	for (int bounce = 0; active; bounce++)
+	{
+		bvh.intersect(packet, active);
+		float t[4], u[4], v[4], origin[3][4], direction[3][4];
+		int32_t hit[4];
+		_mm_storeu_ps(t, packet.tMax);
+		_mm_storeu_ps(u, packet.u);
+		_mm_storeu_ps(v, packet.v);
+		_mm_storeu_si128((__m128i*)hit, packet.triangle);
+		_mm_storeu_ps(origin[0], packet.originX);
+		_mm_storeu_ps(origin[1], packet.originY);
+		_mm_storeu_ps(origin[2], packet.originZ);
+		_mm_storeu_ps(direction[0], packet.directionX);
+		_mm_storeu_ps(direction[1], packet.directionY);
+		_mm_storeu_ps(direction[2], packet.directionZ);
+
+		//Ponto, normais e UV de cada acerto; o raio de sombra sai do lado de onde o raio veio
+		int triangles[4];
+		glm::vec3 points[4], shadingNormals[4], faceNormals[4], rayDirections[4];
+		glm::vec2 uvs[4];
+		glm::vec3 shadowOrigins[4], shadowDirections[4];
+		float shadowDistances[4];
+		int shaded = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			shadowOrigins[lane] = glm::vec3(0.0f);
+			shadowDirections[lane] = glm::vec3(0.0f, 0.0f, 1.0f);
+			shadowDistances[lane] = 0.0f;
+			if (!(active & 1 << lane))
+			{
+				continue;
+			}
+			rayDirections[lane] = glm::vec3(direction[0][lane], direction[1][lane], direction[2][lane]);
+			if (hit[lane] < 0)
+			{
+				colors[lane] += throughput[lane] * clearColor;
+				continue;
+			}
+
+			int triangle = bvh.getTriangleIndex(hit[lane]);
+			triangles[lane] = triangle;
+			float w = 1.0f - u[lane] - v[lane];
+			const glm::vec3* p = &positions[triangle * 3];
+			points[lane] = glm::vec3(origin[0][lane], origin[1][lane], origin[2][lane]) + rayDirections[lane] * t[lane];
+			glm::vec3 face = glm::cross(p[1] - p[0], p[2] - p[0]);
+			face = glm::normalize(glm::dot(face, rayDirections[lane]) > 0.0f ? -face : face);
+			faceNormals[lane] = face;
+			glm::vec3 normal = normals[triangle * 3] * w + normals[triangle * 3 + 1] * u[lane] + normals[triangle * 3 + 2] * v[lane];
+			shadingNormals[lane] = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : face;
+			uvs[lane] = textureCoords[triangle * 3] * w + textureCoords[triangle * 3 + 1] * u[lane] + textureCoords[triangle * 3 + 2] * v[lane];
+
+			shadowOrigins[lane] = points[lane] + face * SURFACE_OFFSET;
+			glm::vec3 toLight = lightPos - shadowOrigins[lane];
+			shadowDistances[lane] = glm::length(toLight);
+			shadowDirections[lane] = shadowDistances[lane] > 0.0f ? toLight / shadowDistances[lane] : face;
+			shaded |= 1 << lane;
+		}
+		if (!shaded)
+		{
+			break;
+		}
+
+		RayPacket shadow;
+		shadow.set(shadowOrigins, shadowDirections, shadowDistances);
+		int blocked = bvh.occluded(shadow, shaded);
+		counts.shadow += countLanes(shaded);
+
+		glm::vec3 reflectionOrigins[4], reflectionDirections[4];
+		float reflectionDistances[4];
+		int next = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			reflectionOrigins[lane] = shadowOrigins[lane];
+			reflectionDirections[lane] = shadowDirections[lane];
+			reflectionDistances[lane] = FLT_MAX;
+			if (!(shaded & 1 << lane))
+			{
+				continue;
+			}
+
+			//sprite.fs, sem difusa nem especular na sombra
+			const Material& material = materials[triangleMaterials[triangles[lane]]];
+			glm::vec3 N = shadingNormals[lane];
+			glm::vec3 L = shadowDirections[lane];
+			glm::vec3 V = -rayDirections[lane];
+			glm::vec3 ambient = lightColor * material.ka;
+			glm::vec3 diffuse(0.0f), specular(0.0f);
+			if (!(blocked & 1 << lane))
+			{
+				float diff = max(glm::dot(N, L), 0.0f);
+				diffuse = diff * lightColor * material.kd;
+				float spec = pow(max(glm::dot(glm::reflect(-L, N), V), 0.0f), material.q);
+				specular = spec * material.ks * lightColor;
+			}
+			glm::vec3 texColor = sampleTexture(material.texture, uvs[lane]);
+			colors[lane] += throughput[lane] * ((ambient + diffuse) * texColor + specular);
+
+			//Reflexo ponderado por ks e pelo Fresnel de Schlick: fraco de frente, forte rasante
+			if (bounce >= bounces)
+			{
+				continue;
+			}
+			float cosine = glm::clamp(glm::dot(N, V), 0.0f, 1.0f);
+			float fresnel = FRESNEL_F0 + (1.0f - FRESNEL_F0) * pow(1.0f - cosine, 5.0f);
+			throughput[lane] *= material.ks * fresnel;
+			glm::vec3 reflected = glm::reflect(rayDirections[lane], N);
+			if (max(throughput[lane].r, max(throughput[lane].g, throughput[lane].b)) > MIN_THROUGHPUT && glm::dot(reflected, faceNormals[lane]) > 0.0f)
+			{
+				reflectionDirections[lane] = reflected;
+				next |= 1 << lane;
+			}
+		}
+		if (!next)
+		{
+			break;
+		}
+
+		packet.set(reflectionOrigins, reflectionDirections, reflectionDistances);
+		counts.reflection += countLanes(next);
+		active = next;
+	}
+}
+
+static int wrap(int i, int size)
+{
+	i %= size;
+	return i < 0 ? i + size : i;
+}
+
+glm::vec3 RayTracer::sampleTexture(int texture, glm::vec2 uv)
+{
+	if (texture < 0 || textures[texture].texels.empty())
+	{
+		return glm::vec3(1.0f);
+	}
+
+	const Texture& t = textures[texture];
+	float x = uv.x * t.width - 0.5f, y = uv.y * t.height - 0.5f;
+	float fx = floor(x), fy = floor(y);
+	//Coordenadas enormes (UV fora do normal) perdem a parte fracionaria, mas continuam validas
+	int x0 = wrap((int)fmod(fx, (float)t.width), t.width), y0 = wrap((int)fmod(fy, (float)t.height), t.height);
+	int x1 = (x0 + 1) % t.width, y1 = (y0 + 1) % t.height;
+	float wx = x - fx, wy = y - fy;
+
+	uint32_t texels[4] = { t.texels[(size_t)y0 * t.width + x0], t.texels[(size_t)y0 * t.width + x1],
+		t.texels[(size_t)y1 * t.width + x0], t.texels[(size_t)y1 * t.width + x1] };
+	glm::vec3 result;
+	for (int c = 0; c < 3; c++)
+	{
+		float p00 = (float)(texels[0] >> (8 * c) & 0xFF), p10 = (float)(texels[1] >> (8 * c) & 0xFF);
+		float p01 = (float)(texels[2] >> (8 * c) & 0xFF), p11 = (float)(texels[3] >> (8 * c) & 0xFF);
+		float top = p00 + (p10 - p00) * wx;
+		float bottom = p01 + (p11 - p01) * wx;
+		result[c] = (top + (bottom - top) * wy) * (1.0f / 255.0f);
+	}
+	return result;
+}
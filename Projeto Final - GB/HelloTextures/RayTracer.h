@@ -0,0 +1,106 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "Mesh.h"
+#include "MaterialLibrary.h"
+#include "ThreadPool.h"
+#include "BVH.h"
+
+using namespace std;
+
+//Renderizacao offline da cena por tracado de raios em CPU: o modelo de Phong de sprite.fs
+//(ka, kd, ks, q e a textura difusa) mais sombras, com um raio de cada ponto ate lightPos,
+//e reflexos, ponderados por ks e pelo termo de Fresnel. A cada quadro os triangulos dos
+//objetos (com trajetorias e instancias, como no SoftwareRenderer) vao para uma BVH. A
+//imagem e dividida em tiles de TILE_SIZE pixels distribuidos entre as threads; cada quad
+//2x2 de pixels e tracado como um RayPacket, uma vez por amostra de uma grade samples x
+//samples, e as sombras e os reflexos do quad seguem no mesmo pacote
+class RayTracer
+{
+public:
+	RayTracer() {}
+	//nbThreads 0 usa todos os nucleos (a thread que chama end() tambem trabalha)
+	void initialize(int width, int height, int nbThreads = 0);
+	//Le as texturas difusas dos materiais (so o nivel 0; as amostras por pixel filtram)
+	void loadMaterials(MaterialLibrary& materials);
+	//samples x samples amostras por pixel e ate bounces reflexos por caminho
+	void setQuality(int samples, int bounces);
+	void setCamera(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos);
+	void setLight(glm::vec3 lightPos, glm::vec3 lightColor);
+	//Comeca um quadro; draw apenas registra os triangulos e end() monta a BVH e traca
+	void begin(glm::vec3 clearColor);
+	//O objeto precisa ter a geometria em CPU (initialize sem shader ou com keepGeometry)
+	void draw(Mesh& mesh, float pathTime);
+	void end();
+	//RGBA8 de baixo para cima, como o glReadPixels
+	const unsigned char* getColorBuffer() { return color.data(); }
+	int getNbThreads() { return workers.getNbThreads() + 1; }
+	int getNbTriangles() { return bvh.getNbTriangles(); }
+	int getNbNodes() { return bvh.getNbNodes(); }
+	//Ultimo quadro: raios de camera, de sombra e de reflexo, e tempos em ms
+	long long getNbPrimaryRays() { return nbPrimaryRays; }
+	long long getNbShadowRays() { return nbShadowRays; }
+	long long getNbReflectionRays() { return nbReflectionRays; }
+	double getBuildTime() { return buildTime; }
+	double getTraceTime() { return traceTime; }
+
+	enum { TILE_SIZE = 16 };
+
+protected:
+	struct Material
+	{
+		glm::vec3 ka, ks;
+		float kd, q;
+		int texture; //-1: textura branca
+	};
+
+	struct Texture
+	{
+		int width = 1, height = 1;
+		vector<uint32_t> texels;
+	};
+
+	//Raios tracados por uma thread em um tile
+	struct RayCounts
+	{
+		long long primary = 0, shadow = 0, reflection = 0;
+	};
+
+	void renderTile(int tile);
+	//Cor das lanes de active para o pacote que sai da camera, com sombras e reflexos
+	void tracePacket(RayPacket& packet, int active, glm::vec3* colors, RayCounts& counts);
+	//GL_LINEAR com GL_REPEAT
+	glm::vec3 sampleTexture(int texture, glm::vec2 uv);
+
+	int width = 0, height = 0;
+	int nbTilesX = 0, nbTilesY = 0;
+	int samples = 2, bounces = 2;
+
+	glm::mat4 inverseViewProjection;
+	glm::vec3 cameraPos, lightPos, lightColor;
+	glm::vec3 clearColor;
+
+	//Triangulos do quadro no mundo: 3 vertices, normais e UVs por triangulo
+	vector<glm::vec3> positions, normals;
+	vector<glm::vec2> textureCoords;
+	vector<int> triangleMaterials;
+	BVH bvh;
+
+	vector<Material> materials;
+	vector<Texture> textures;
+	vector<unsigned char> color;
+
+	long long nbPrimaryRays = 0, nbShadowRays = 0, nbReflectionRays = 0;
+	double buildTime = 0.0, traceTime = 0.0;
+
+	ThreadPool workers;
+	int nbWorkers = 0;
+	atomic<int> nextTile{ 0 };
+	atomic<long long> primaryRays{ 0 }, shadowRays{ 0 }, reflectionRays{ 0 };
+};
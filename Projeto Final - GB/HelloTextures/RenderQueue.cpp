@@ -0,0 +1,135 @@
+#include "RenderQueue.h"
+#include "Mesh.h"
+
+#include <cstring>
+#include <algorithm>
+
+void RenderQueue::begin(Arena& frameArena, int capacity)
+{
+	arena = &frameArena;
+	items = frameArena.push<Item>(capacity);
+	this->capacity = items ? capacity : 0;
+	nbItems = 0;
+}
+
+void RenderQueue::push(uint64_t key, Mesh* mesh)
+{
+	if (nbItems == capacity)
+	{
+		return;
+	}
+
+	items[nbItems].key = key;
+	items[nbItems].mesh = mesh;
+	nbItems++;
+}
+
+uint64_t RenderQueue::makeKey(GLuint program, uint32_t material, GLuint vertexArray, float depth)
+{
+	uint64_t quantizedDepth = (uint64_t)(std::min(std::max(depth, 0.0f), 1.0f) * 16777215.0f);
+
+	return ((uint64_t)(program & 0x3F) << 58) |
+		((uint64_t)(material & 0x3FFFF) << 40) |
+		((uint64_t)(vertexArray & 0xFFFF) << 24) |
+		quantizedDepth;
+}
+
+void RenderQueue::sort()
+{
+	if (nbItems < 2)
+	{
+		return;
+	}
+
+	size_t marker = arena->getMarker();
+	Item* buffer = arena->push<Item>(nbItems);
+	if (!buffer)
+	{
+		return;
+	}
+
+	Item* source = items;
+	Item* destination = buffer;
+	int count[256];
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		memset(count, 0, sizeof(count));
+		for (int i = 0; i < nbItems; i++)
+		{
+			count[(source[i].key >> shift) & 0xFF]++;
+		}
+
+		if (count[(source[0].key >> shift) & 0xFF] == nbItems)
+		{
+			continue;
+		}
+
+		int offset = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			int c = count[b];
+			count[b] = offset;
+			offset += c;
+		}
+
+		for (int i = 0; i < nbItems; i++)
+		{
+			destination[count[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+
+		std::swap(source, destination);
+	}
+
+	if (source != items)
+	{
+		memcpy(items, source, nbItems * sizeof(Item));
+	}
+
+	arena->rewind(marker);
+}
+
+void RenderQueue::submit(GLState& state, Shader* program)
+{
+	//O uniform do material e de cada programa: volta a ser enviado quando o programa muda
+	GLuint previousProgram = 0;
+	int previousMaterial = -1;
+
+	for (int i = 0; i < nbItems; i++)
+	{
+		Mesh* mesh = items[i].mesh;
+		GLuint programId = program ? program->ID : mesh->getProgram();
+
+		state.useProgram(programId);
+		mesh->update(program);
+		mesh->draw(state, i == 0 || programId != previousProgram || mesh->getMaterialId() != previousMaterial, program);
+		previousProgram = programId;
+		previousMaterial = mesh->getMaterialId();
+	}
+}
+
+void RenderQueue::submitDepth(GLState& state, Shader* program)
+{
+	for (int i = 0; i < nbItems; i++)
+	{
+		items[i].mesh->update(program);
+		items[i].mesh->drawDepth(state);
+	}
+}
+
+int RenderQueue::countStateChanges()
+{
+	int changes = 0;
+
+	for (int i = 0; i < nbItems; i++)
+	{
+		Mesh* mesh = items[i].mesh;
+		Mesh* previous = i > 0 ? items[i - 1].mesh : nullptr;
+
+		changes += !previous || previous->getProgram() != mesh->getProgram();
+		changes += !previous || previous->getVertexArray() != mesh->getVertexArray();
+		changes += !previous || previous->getMaterialId() != mesh->getMaterialId();
+	}
+
+	return changes;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+#include "Arena.h"
+#include "GLState.h"
+
+class Mesh;
+class Shader;
+
+//Fila de desenho de um quadro. Cada item tem uma chave de 64 bits:
+//  63..58 programa (6) | 57..40 material (18) | 39..24 VAO (16) | 23..0 profundidade (24)
+//As texturas nao entram na chave: todas ficam ligadas o quadro inteiro (MaterialLibrary).
+//Ordenando as chaves, os objetos que compartilham estado ficam juntos e, dentro do
+//mesmo estado, sao desenhados da frente para tras
+class RenderQueue
+{
+public:
+	RenderQueue() {}
+	//Os arrays da fila sao alocados no arena do quadro
+	void begin(Arena& frameArena, int capacity);
+	void push(uint64_t key, Mesh* mesh);
+	//Radix sort LSD de 8 bits; passadas em que todas as chaves tem o mesmo byte sao puladas
+	void sort();
+	//Com program, todos os objetos sao desenhados com ele no lugar dos seus shaders
+	void submit(GLState& state, Shader* program = nullptr);
+	//So a profundidade, com o VAO de posicoes de cada objeto e o programa informado, ja em uso
+	void submitDepth(GLState& state, Shader* program);
+	//Trocas de programa, VAO e material na ordem atual da fila
+	int countStateChanges();
+	int getNbItems() { return nbItems; }
+
+	//depth normalizado em [0, 1]
+	static uint64_t makeKey(GLuint program, uint32_t material, GLuint vertexArray, float depth);
+
+protected:
+	struct Item
+	{
+		uint64_t key;
+		Mesh* mesh;
+	};
+
+	Arena* arena = nullptr;
+	Item* items = nullptr;
+	int nbItems = 0, capacity = 0;
+};
@@ -0,0 +1,416 @@
+#include "SceneFile.h"
+#include "TextParser.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+
+static const char SCENE_MAGIC[4] = { 'S', 'C', 'N', 'B' };
+
+SceneFile::SceneFile()
+{
+	memset(internTable, 0, sizeof(internTable));
+
+	settings.cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
+	settings.cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+	settings.cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
+	settings.lightPos = glm::vec3(0.0f);
+	settings.lightColor = glm::vec3(1.0f);
+	settings.renderer = SCENE_FORWARD;
+}
+
+bool SceneFile::load(string path)
+{
+	if (!file.open(path))
+	{
+		return false;
+	}
+
+	if (file.getSize() >= sizeof(Header) && memcmp(file.getData(), SCENE_MAGIC, 4) == 0)
+	{
+		if (!loadBinary(file.getData(), file.getSize()))
+		{
+			cout << "Invalid binary scene: " << path << endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool ok = parseText(file.getData(), file.getSize());
+
+	//Os registros ja estao nos arenas; o texto nao e mais necessario
+	file.close();
+	return ok;
+}
+
+//Strings repetidas (nomes de arquivo, tipos de curva) sao guardadas uma vez so.
+//O deslocamento 0 e a string vazia, entao 0 marca uma entrada livre na tabela
+uint32_t SceneFile::intern(const char* s, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash = (hash ^ (unsigned char)s[i]) * 16777619u;
+	}
+
+	for (int probe = 0; probe < INTERN_TABLE_SIZE; probe++)
+	{
+		uint32_t& slot = internTable[(hash + probe) & (INTERN_TABLE_SIZE - 1)];
+
+		if (slot == 0)
+		{
+			char* copy = stringArena.push<char>(length + 1);
+			if (!copy)
+			{
+				return 0;
+			}
+			memcpy(copy, s, length);
+			copy[length] = '\0';
+			slot = (uint32_t)(copy - stringArena.getBase());
+			return slot;
+		}
+
+		const char* existing = stringArena.getBase() + slot;
+		if (strncmp(existing, s, length) == 0 && existing[length] == '\0')
+		{
+			return slot;
+		}
+	}
+
+	//Tabela cheia: guarda sem compartilhar
+	char* copy = stringArena.push<char>(length + 1);
+	if (!copy)
+	{
+		return 0;
+	}
+	memcpy(copy, s, length);
+	copy[length] = '\0';
+	return (uint32_t)(copy - stringArena.getBase());
+}
+
+bool SceneFile::parseText(const char* text, size_t size)
+{
+	const char* p = text;
+	const char* end = text + size;
+	int lineNumber = 1;
+	bool ok = true;
+
+	SceneObjectRecord* object = nullptr;
+	bool inCurve = false;
+
+	*stringArena.push<char>() = '\0';
+	uint32_t defaultCurveType = intern("bezier", 6);
+	uint32_t defaultParameterization = intern("centripetal", 11);
+
+	for (; p < end; lineNumber++)
+	{
+		const char* token;
+		size_t length = readToken(p, end, token);
+		const char* keyword = token;
+		size_t keywordLength = length;
+
+		if (length == 0)
+		{
+			//Linha vazia
+		}
+		else if (isKeyword(token, length, "cameraPos"))
+		{
+			ok = parseVec3(p, end, settings.cameraPos);
+		}
+		else if (isKeyword(token, length, "cameraFront"))
+		{
+			ok = parseVec3(p, end, settings.cameraFront);
+		}
+		else if (isKeyword(token, length, "cameraUp"))
+		{
+			ok = parseVec3(p, end, settings.cameraUp);
+		}
+		else if (isKeyword(token, length, "lightPos"))
+		{
+			ok = parseVec3(p, end, settings.lightPos);
+		}
+		else if (isKeyword(token, length, "lightColor"))
+		{
+			ok = parseVec3(p, end, settings.lightColor);
+		}
+		else if (isKeyword(token, length, "renderer"))
+		{
+			length = readToken(p, end, token);
+			ok = isKeyword(token, length, "forward") || isKeyword(token, length, "deferred");
+			settings.renderer = isKeyword(token, length, "deferred") ? SCENE_DEFERRED : SCENE_FORWARD;
+		}
+		else if (isKeyword(token, length, "pointLight"))
+		{
+			glm::vec3 position, color;
+			float radius = 0.0f;
+			ok = parseVec3(p, end, position) && parseVec3(p, end, color) && parseFloat(p, end, radius) && radius > 0.0f;
+			SceneLightRecord* light = ok ? lightArena.push<SceneLightRecord>() : nullptr;
+			if (light)
+			{
+				*light = { { position.x, position.y, position.z }, radius, { color.r, color.g, color.b }, 0.0f };
+				nbLights++;
+			}
+		}
+		else if (isKeyword(token, length, "lightField"))
+		{
+			int count = 0;
+			glm::vec3 boundsMin, boundsMax;
+			float radius = 0.0f;
+			ok = parseInt(p, end, count) && parseVec3(p, end, boundsMin) && parseVec3(p, end, boundsMax) && parseFloat(p, end, radius) &&
+				count > 0 && radius > 0.0f && addLightField(count, boundsMin, boundsMax, radius);
+		}
+		else if (isKeyword(token, length, "fileName"))
+		{
+			object = objectArena.push<SceneObjectRecord>();
+			if (!object)
+			{
+				return false;
+			}
+
+			length = readToken(p, end, token);
+			object->fileName = intern(token, length);
+			object->curveType = defaultCurveType;
+			object->parameterization = defaultParameterization;
+			object->firstControlPoint = nbControlPoints;
+			object->nbControlPoints = 0;
+			object->instances = 1;
+			object->position[0] = object->position[1] = object->position[2] = 0.0f;
+			object->scale = 1.0f;
+			object->angle = 0.0f;
+			object->phase = 0.0f;
+			object->axis = 'Z';
+			object->closedCurve = 0;
+			object->padding[0] = object->padding[1] = 0;
+			nbObjects++;
+			inCurve = false;
+			ok = length > 0;
+		}
+		else if (!object)
+		{
+			cout << "Scene line " << lineNumber << ": '" << string(token, length) << "' before any fileName" << endl;
+		}
+		else if (isKeyword(token, length, "position"))
+		{
+			glm::vec3 position;
+			ok = parseVec3(p, end, position);
+			object->position[0] = position.x;
+			object->position[1] = position.y;
+			object->position[2] = position.z;
+		}
+		else if (isKeyword(token, length, "scale"))
+		{
+			ok = parseFloat(p, end, object->scale);
+		}
+		else if (isKeyword(token, length, "angle"))
+		{
+			ok = parseFloat(p, end, object->angle);
+		}
+		else if (isKeyword(token, length, "axis"))
+		{
+			length = readToken(p, end, token);
+			ok = length == 1;
+			object->axis = token[0];
+		}
+		else if (isKeyword(token, length, "instances"))
+		{
+			ok = parseInt(p, end, object->instances) && object->instances >= 1;
+		}
+		else if (isKeyword(token, length, "curveType"))
+		{
+			length = readToken(p, end, token);
+			object->curveType = intern(token, length);
+		}
+		else if (isKeyword(token, length, "curveParameterization"))
+		{
+			length = readToken(p, end, token);
+			object->parameterization = intern(token, length);
+		}
+		else if (isKeyword(token, length, "closedCurve"))
+		{
+			object->closedCurve = 1;
+		}
+		else if (isKeyword(token, length, "phase"))
+		{
+			ok = parseFloat(p, end, object->phase);
+		}
+		else if (isKeyword(token, length, "startCurve"))
+		{
+			inCurve = true;
+			object->firstControlPoint = nbControlPoints;
+			object->nbControlPoints = 0;
+		}
+		else if (isKeyword(token, length, "curvePoint"))
+		{
+			glm::vec3 point;
+			ok = parseVec3(p, end, point);
+
+			//Os pontos de um objeto sao consecutivos no arena, entao basta contar
+			if (!inCurve)
+			{
+				cout << "Scene line " << lineNumber << ": curvePoint outside startCurve/endCurve" << endl;
+			}
+			else if (ok)
+			{
+				glm::vec3* controlPoint = controlPointArena.push<glm::vec3>();
+				if (!controlPoint)
+				{
+					return false;
+				}
+				*controlPoint = point;
+				object->nbControlPoints++;
+				nbControlPoints++;
+			}
+		}
+		else if (isKeyword(token, length, "endCurve") || isKeyword(token, length, "noCurve"))
+		{
+			inCurve = false;
+		}
+
+		if (!ok)
+		{
+			cout << "Scene line " << lineNumber << ": invalid value for '" << string(keyword, keywordLength) << "'" << endl;
+			ok = true;
+		}
+
+		skipLine(p, end);
+	}
+
+	objects = (const SceneObjectRecord*)objectArena.getBase();
+	controlPoints = (const glm::vec3*)controlPointArena.getBase();
+	strings = stringArena.getBase();
+	stringsSize = (uint32_t)stringArena.getUsed();
+	lights = (const SceneLightRecord*)lightArena.getBase();
+
+	return true;
+}
+
+//Hash inteiro (de Wellons) do indice da luz e do canal: o mesmo campo em qualquer maquina
+static float hashToUnit(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+bool SceneFile::addLightField(int count, glm::vec3 boundsMin, glm::vec3 boundsMax, float radius)
+{
+	SceneLightRecord* field = lightArena.push<SceneLightRecord>(count);
+	if (!field)
+	{
+		return false;
+	}
+
+	uint32_t seed = nbLights * 8;
+	for (int i = 0; i < count; i++, seed += 8)
+	{
+		SceneLightRecord& light = field[i];
+		for (int c = 0; c < 3; c++)
+		{
+			light.position[c] = boundsMin[c] + (boundsMax[c] - boundsMin[c]) * hashToUnit(seed + c);
+		}
+		light.radius = radius;
+
+		//Matiz aleatorio com saturacao e valor maximos
+		float hue = hashToUnit(seed + 3) * 6.0f;
+		light.color[0] = glm::clamp(fabs(hue - 3.0f) - 1.0f, 0.0f, 1.0f);
+		light.color[1] = glm::clamp(2.0f - fabs(hue - 2.0f), 0.0f, 1.0f);
+		light.color[2] = glm::clamp(2.0f - fabs(hue - 4.0f), 0.0f, 1.0f);
+		light.padding = 0.0f;
+	}
+	nbLights += count;
+	return true;
+}
+
+//Valida o arquivo mapeado e aponta os arrays diretamente para ele, sem copias
+bool SceneFile::loadBinary(const char* data, size_t size)
+{
+	const Header* header = (const Header*)data;
+
+	if (header->version != VERSION || header->settings.renderer > SCENE_DEFERRED)
+	{
+		return false;
+	}
+
+	if (header->objectsOffset + (uint64_t)header->nbObjects * sizeof(SceneObjectRecord) > size ||
+		header->controlPointsOffset + (uint64_t)header->nbControlPoints * sizeof(glm::vec3) > size ||
+		header->stringsOffset + header->stringsSize > size || header->stringsSize == 0 ||
+		header->lightsOffset + (uint64_t)header->nbLights * sizeof(SceneLightRecord) > size)
+	{
+		return false;
+	}
+
+	settings = header->settings;
+	nbObjects = header->nbObjects;
+	nbControlPoints = header->nbControlPoints;
+	stringsSize = header->stringsSize;
+	objects = (const SceneObjectRecord*)(data + header->objectsOffset);
+	controlPoints = (const glm::vec3*)(data + header->controlPointsOffset);
+	strings = data + header->stringsOffset;
+	nbLights = header->nbLights;
+	lights = (const SceneLightRecord*)(data + header->lightsOffset);
+
+	if (strings[stringsSize - 1] != '\0')
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < nbObjects; i++)
+	{
+		const SceneObjectRecord& object = objects[i];
+		if (object.fileName >= stringsSize || object.curveType >= stringsSize || object.parameterization >= stringsSize ||
+			(uint64_t)object.firstControlPoint + object.nbControlPoints > nbControlPoints || object.instances < 1)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool SceneFile::writeBinary(string path)
+{
+	ofstream out(path, ios::binary);
+	if (!out)
+	{
+		cerr << "Failed to open file: " << path << endl;
+		return false;
+	}
+
+	//Secoes alinhadas em 16 bytes
+	auto align = [](uint64_t offset) { return (offset + 15) & ~(uint64_t)15; };
+
+	Header header;
+	memset((void*)&header, 0, sizeof(header));
+	memcpy(header.magic, SCENE_MAGIC, 4);
+	header.version = VERSION;
+	header.settings = settings;
+	header.nbObjects = nbObjects;
+	header.nbControlPoints = nbControlPoints;
+	header.stringsSize = stringsSize;
+	header.objectsOffset = align(sizeof(Header));
+	header.controlPointsOffset = align(header.objectsOffset + (uint64_t)nbObjects * sizeof(SceneObjectRecord));
+	header.stringsOffset = align(header.controlPointsOffset + (uint64_t)nbControlPoints * sizeof(glm::vec3));
+	header.nbLights = nbLights;
+	header.lightsOffset = align(header.stringsOffset + stringsSize);
+
+	const char zeros[16] = {};
+	uint64_t written = 0;
+
+	auto writeSection = [&](uint64_t offset, const void* data, uint64_t size) {
+		out.write(zeros, offset - written);
+		out.write((const char*)data, size);
+		written = offset + size;
+	};
+
+	writeSection(0, &header, sizeof(header));
+	writeSection(header.objectsOffset, objects, (uint64_t)nbObjects * sizeof(SceneObjectRecord));
+	writeSection(header.controlPointsOffset, controlPoints, (uint64_t)nbControlPoints * sizeof(glm::vec3));
+	writeSection(header.stringsOffset, strings, stringsSize);
+	writeSection(header.lightsOffset, lights, (uint64_t)nbLights * sizeof(SceneLightRecord));
+
+	return (bool)out;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <string>
+#include <cstdint>
+
+#include "Arena.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+//Registro de um objeto da cena. O layout e fixo: e o mesmo na memoria e no arquivo binario
+struct SceneObjectRecord
+{
+	uint32_t fileName; //Deslocamentos na tabela de strings
+	uint32_t curveType;
+	uint32_t parameterization;
+	uint32_t firstControlPoint;
+	uint32_t nbControlPoints;
+	int32_t instances;
+	float position[3];
+	float scale, angle, phase;
+	char axis;
+	uint8_t closedCurve;
+	uint8_t padding[2];
+};
+
+static_assert(sizeof(SceneObjectRecord) == 52, "SceneObjectRecord layout is part of the binary scene format");
+
+//Luz pontual de alcance limitado, alem da luz principal (lightPos). Layout fixo, como o dos objetos
+struct SceneLightRecord
+{
+	float position[3];
+	float radius; //a luz nao chega alem desta distancia
+	float color[3];
+	float padding;
+};
+
+static_assert(sizeof(SceneLightRecord) == 32, "SceneLightRecord layout is part of the binary scene format");
+
+//Caminho de renderizacao escolhido pela cena (palavra-chave renderer)
+enum SceneRenderer { SCENE_FORWARD = 0, SCENE_DEFERRED = 1 };
+
+//Cena lida de cena-config.txt (parser de uma passada, sem alocacoes por linha) ou do
+//formato binario compilado, que e mapeado em memoria e usado diretamente
+class SceneFile
+{
+public:
+	SceneFile();
+	//Detecta o formato pelo cabecalho do arquivo
+	bool load(string path);
+	bool writeBinary(string path);
+
+	int getNbObjects() { return nbObjects; }
+	const SceneObjectRecord& getObject(int i) { return objects[i]; }
+	const glm::vec3* getControlPoints(const SceneObjectRecord& object) { return controlPoints + object.firstControlPoint; }
+	const char* getString(uint32_t offset) { return strings + offset; }
+	int getNbLights() { return nbLights; }
+	const SceneLightRecord& getLight(int i) { return lights[i]; }
+	glm::vec3 getCameraPos() { return settings.cameraPos; }
+	glm::vec3 getCameraFront() { return settings.cameraFront; }
+	glm::vec3 getCameraUp() { return settings.cameraUp; }
+	glm::vec3 getLightPos() { return settings.lightPos; }
+	glm::vec3 getLightColor() { return settings.lightColor; }
+	SceneRenderer getRenderer() { return (SceneRenderer)settings.renderer; }
+
+protected:
+	struct Settings
+	{
+		glm::vec3 cameraPos, cameraFront, cameraUp, lightPos, lightColor;
+		uint32_t renderer; //SceneRenderer
+	};
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		Settings settings;
+		uint32_t nbObjects, nbControlPoints, stringsSize, nbLights;
+		uint64_t objectsOffset, controlPointsOffset, stringsOffset, lightsOffset;
+	};
+
+	static const uint32_t VERSION = 3;
+	static const int INTERN_TABLE_SIZE = 4096;
+
+	bool parseText(const char* text, size_t size);
+	bool loadBinary(const char* data, size_t size);
+	uint32_t intern(const char* s, size_t length);
+	//lightField: count luzes espalhadas na caixa, com cores saturadas, sempre as mesmas
+	bool addLightField(int count, glm::vec3 boundsMin, glm::vec3 boundsMax, float radius);
+
+	MappedFile file;
+	Arena objectArena, controlPointArena, stringArena, lightArena;
+	uint32_t internTable[INTERN_TABLE_SIZE];
+
+	Settings settings;
+	const SceneObjectRecord* objects = nullptr;
+	const glm::vec3* controlPoints = nullptr;
+	const char* strings = nullptr;
+	const SceneLightRecord* lights = nullptr;
+	uint32_t nbObjects = 0, nbControlPoints = 0, stringsSize = 0, nbLights = 0;
+};
@@ -0,0 +1,283 @@
+#include "ShadowMap.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+//Peso da divisao logaritmica das cascatas; o resto e uniforme
+static const float SPLIT_BLEND = 0.75f;
+//Deslocamento do passo de profundidade (fator da inclinacao, unidades)
+static const float DEPTH_SLOPE_BIAS = 2.0f, DEPTH_CONSTANT_BIAS = 4.0f;
+//Quadros entre duas mudancas do intervalo, para a media do GPUTimer acompanhar
+static const int ADAPTATION_FRAMES = 30;
+
+bool ShadowMap::create(int size)
+{
+	destroy();
+	this->size = size;
+
+	depthShader.reset(new Shader("../shaders/shadow.vs", "../shaders/shadow.fs"));
+
+	//Comparacao no sampler: o filtro linear ja devolve a media de 4 testes de profundidade
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, NB_CASCADES, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	if (!complete)
+	{
+		destroy();
+		return false;
+	}
+
+	timer.create();
+	return true;
+}
+
+void ShadowMap::destroy()
+{
+	if (framebuffer)
+	{
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(1, &depthTexture);
+		framebuffer = depthTexture = 0;
+	}
+	timer.destroy();
+	depthShader.reset();
+	for (int i = 0; i < NB_CASCADES; i++)
+	{
+		cascades[i].valid = false;
+	}
+	updateInterval = 1;
+}
+
+void ShadowMap::setupShader(Shader* shader)
+{
+	shader->setInt("shadowMap", TEXTURE_UNIT);
+	shader->setBool("useShadows", isCreated());
+}
+
+void ShadowMap::setLight(glm::vec3 lightPos, vector<Mesh>& objects)
+{
+	this->lightPos = lightPos;
+
+	//Caixa da cena em volta das esferas de todo o percurso dos objetos: fixa, ao contrario da
+	//caixa do quadro, que acompanha os objetos em trajetoria e giraria a base da luz
+	glm::vec3 sceneMin(FLT_MAX), sceneMax(-FLT_MAX);
+	for (Mesh& object : objects)
+	{
+		glm::vec3 center;
+		float radius;
+		object.getPathBounds(center, radius);
+		sceneMin = glm::min(sceneMin, center - glm::vec3(radius));
+		sceneMax = glm::max(sceneMax, center + glm::vec3(radius));
+	}
+	if (objects.empty())
+	{
+		sceneMin = sceneMax = glm::vec3(0.0f);
+	}
+	sceneCenter = (sceneMin + sceneMax) * 0.5f;
+	sceneRadius = glm::length(sceneMax - sceneMin) * 0.5f;
+
+	glm::vec3 direction = sceneCenter - lightPos;
+	float lightDistance = glm::length(direction);
+	direction = lightDistance > 1e-4f ? direction / lightDistance : glm::vec3(0.0f, -1.0f, 0.0f);
+	glm::vec3 up = fabs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+	float sceneDepth = -(lightView * glm::vec4(sceneCenter, 1.0f)).z;
+	sceneNear = sceneDepth - sceneRadius;
+	sceneFar = sceneDepth + sceneRadius;
+}
+
+void ShadowMap::render(GLState& state, vector<Mesh>& objects, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane, float pathTime)
+{
+	nbDraws = nbCulled = 0;
+	if (!isCreated() || objects.empty())
+	{
+		return;
+	}
+	frame++;
+	adaptToBudget();
+
+	//Esferas dos objetos no quadro, para descartar os que nao tocam cada cascata
+	objectBounds.resize(objects.size());
+	for (int i = 0; i < objects.size(); i++)
+	{
+		objects[i].getBoundingSphere(pathTime, objectBounds[i].center, objectBounds[i].radius);
+	}
+
+	//As cascatas cobrem o frustum so ate onde ha cena
+	float cameraDepth = -(view * glm::vec4(sceneCenter, 1.0f)).z;
+	float shadowFar = glm::clamp(cameraDepth + sceneRadius, nearPlane * 2.0f, farPlane);
+	glm::mat4 inverseView = glm::inverse(view);
+
+	bool anyUpdate = false;
+	for (int i = 0; i < NB_CASCADES; i++)
+	{
+		anyUpdate = anyUpdate || needsUpdate(i);
+	}
+	if (!anyUpdate)
+	{
+		return;
+	}
+
+	GLint previousFramebuffer = 0;
+	GLint viewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	timer.begin();
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, size, size);
+	state.useProgram(depthShader->ID);
+	state.enable(GL_DEPTH_TEST);
+	state.depthFunc(GL_LESS);
+	state.depthMask(true);
+	state.enable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(DEPTH_SLOPE_BIAS, DEPTH_CONSTANT_BIAS);
+	depthShader->setFloat("pathTime", pathTime);
+
+	float splitNear = nearPlane;
+	for (int i = 0; i < NB_CASCADES; i++)
+	{
+		float p = (i + 1) / (float)NB_CASCADES;
+		float logSplit = nearPlane * pow(shadowFar / nearPlane, p);
+		float uniformSplit = nearPlane + (shadowFar - nearPlane) * p;
+		float splitFar = SPLIT_BLEND * logSplit + (1.0f - SPLIT_BLEND) * uniformSplit;
+		if (!needsUpdate(i))
+		{
+			splitNear = splitFar;
+			continue;
+		}
+
+		Cascade& cascade = cascades[i];
+		fitCascade(cascade, inverseView, projection, splitNear, splitFar);
+		splitNear = splitFar;
+
+		glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, i);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		depthShader->setMat4("lightSpace", glm::value_ptr(cascade.viewProjection));
+
+		//Sombras so caem dentro da caixa; na profundidade valem os objetos antes do fim dela
+		for (int j = 0; j < objects.size(); j++)
+		{
+			const Bounds& bounds = objectBounds[j];
+			glm::vec3 p = glm::vec3(lightView * glm::vec4(bounds.center, 1.0f));
+			float reach = cascade.radius + bounds.radius;
+			if (fabs(p.x - cascade.center.x) > reach || fabs(p.y - cascade.center.y) > reach || -p.z - bounds.radius > cascade.depthFar)
+			{
+				nbCulled++;
+				continue;
+			}
+			objects[j].update(depthShader.get());
+			objects[j].drawDepth(state);
+			nbDraws++;
+		}
+	}
+
+	state.disable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	timer.end();
+}
+
+void ShadowMap::fitCascade(Cascade& cascade, const glm::mat4& inverseView, const glm::mat4& projection, float nearDepth, float farDepth)
+{
+	//Esfera da fatia: centro no eixo da camera, equidistante dos cantos perto e longe.
+	//projection[0][0] e projection[1][1] sao 1 / tan da metade dos angulos de visao
+	float corner = sqrt(1.0f / (projection[0][0] * projection[0][0]) + 1.0f / (projection[1][1] * projection[1][1]));
+	float nearRing = nearDepth * corner, farRing = farDepth * corner;
+	float centerDepth = (farDepth * farDepth + farRing * farRing - nearDepth * nearDepth - nearRing * nearRing) / (2.0f * (farDepth - nearDepth));
+	centerDepth = min(centerDepth, farDepth);
+	float radius = sqrt((farDepth - centerDepth) * (farDepth - centerDepth) + farRing * farRing);
+
+	//O raio nao depende da rotacao da camera; arredondado para cima em degraus de 2^(1/4),
+	//pequenas mudancas das divisoes tambem nao mudam o tamanho do texel
+	radius = exp2(ceil(log2(radius) * 4.0f) / 4.0f);
+	float texelSize = 2.0f * radius / size;
+
+	//Centro movido em texels inteiros: a imagem da cena so desliza de texel em texel
+	glm::vec3 center = glm::vec3(lightView * inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+	center.x = floor(center.x / texelSize) * texelSize;
+	center.y = floor(center.y / texelSize) * texelSize;
+
+	//Todos os objetos da cena na frente da fatia projetam sombra nela
+	float depthFar = max(min(sceneFar, -center.z + radius), sceneNear + 1e-3f);
+	glm::mat4 lightProjection = glm::ortho(center.x - radius, center.x + radius, center.y - radius, center.y + radius, sceneNear, depthFar);
+
+	cascade.viewProjection = lightProjection * lightView;
+	cascade.center = center;
+	cascade.radius = radius;
+	cascade.depthFar = depthFar;
+	cascade.farDepth = farDepth;
+	cascade.texelSize = texelSize;
+	cascade.valid = true;
+}
+
+bool ShadowMap::needsUpdate(int cascade)
+{
+	//A primeira cascata, a mais visivel, e sempre atualizada; as demais se revezam
+	return cascade == 0 || !cascades[cascade].valid || (frame + cascade) % updateInterval == 0;
+}
+
+void ShadowMap::adaptToBudget()
+{
+	bool measured = timer.poll();
+	if (budget <= 0.0 || !measured || frame - lastAdaptation < ADAPTATION_FRAMES)
+	{
+		return;
+	}
+
+	double time = timer.getAverageTime();
+	if (time > budget && updateInterval < NB_CASCADES)
+	{
+		updateInterval *= 2;
+		lastAdaptation = frame;
+	}
+	else if (time * 2.0 < budget && updateInterval > 1)
+	{
+		updateInterval /= 2;
+		lastAdaptation = frame;
+	}
+}
+
+void ShadowMap::apply(GLState& state, Shader* shader)
+{
+	if (!isCreated())
+	{
+		return;
+	}
+
+	//Do clip [-1, 1] para coordenadas de textura e profundidade em [0, 1]
+	static const glm::mat4 bias(0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.5f, 0.5f, 0.5f, 1.0f);
+	static const char* names[NB_CASCADES] = { "lightSpace[0]", "lightSpace[1]", "lightSpace[2]", "lightSpace[3]" };
+
+	state.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, depthTexture);
+	for (int i = 0; i < NB_CASCADES; i++)
+	{
+		glm::mat4 lightSpace = bias * cascades[i].viewProjection;
+		shader->setMat4(names[i], glm::value_ptr(lightSpace));
+	}
+	shader->setVec4("cascadeFar", cascades[0].farDepth, cascades[1].farDepth, cascades[2].farDepth, cascades[3].farDepth);
+	shader->setVec4("cascadeTexel", cascades[0].texelSize, cascades[1].texelSize, cascades[2].texelSize, cascades[3].texelSize);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "GLState.h"
+#include "GPUTimer.h"
+
+using namespace std;
+
+//Sombras da luz da cena em mapas de profundidade em cascata. O trecho do frustum da camera
+//ate a ultima profundidade ocupada pela cena e dividido em NB_CASCADES fatias (mistura das
+//divisoes logaritmica e uniforme); cada fatia ganha uma camada de um GL_TEXTURE_2D_ARRAY
+//com uma projecao ortografica justa em volta dela. A luz e pontual, mas as cascatas usam
+//uma direcao so, de lightPos ao centro da caixa que contem a cena em qualquer instante (com
+//as trajetorias inteiras), como uma luz direcional: a base da luz nao muda entre os quadros,
+//e o encaixe das cascatas nos texels evita que as bordas das sombras tremam. Com a luz perto
+//da cena (cena-luzes.txt) as sombras nas bordas da cena diferem das de uma luz pontual.
+//Cada cascata desenha so os objetos cuja
+//esfera envolvente cruza a caixa dela, com shaders so de profundidade e um VAO so com as
+//posicoes (Mesh::drawDepth)
+class ShadowMap
+{
+public:
+	ShadowMap() {}
+	~ShadowMap() { destroy(); }
+	//size x size texels por cascata; retorna false se o driver nao aceitar o framebuffer
+	bool create(int size);
+	void destroy();
+	bool isCreated() { return framebuffer != 0; }
+	//Custo do passo de sombras por quadro, em ms de GPU; 0 desliga a adaptacao. Acima do
+	//orcamento as cascatas distantes passam a ser atualizadas em quadros alternados
+	void setBudget(double milliseconds) { budget = milliseconds; }
+	//Calcula a direcao e a faixa de profundidade da luz; chamado na carga, depois de
+	//inicializar os objetos, que precisam das trajetorias
+	void setLight(glm::vec3 lightPos, vector<Mesh>& objects);
+	//Atualiza as cascatas do quadro; precisa do CurveBuffer ligado, como o passo principal.
+	//Restaura o framebuffer de desenho e o viewport
+	void render(GLState& state, vector<Mesh>& objects, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane, float pathTime);
+	//Liga o mapa e envia as matrizes ao shader dos objetos (sprite.fs), que precisa estar em uso
+	void apply(GLState& state, Shader* shader);
+	//Unidade do sampler e useShadows; chamado mesmo sem create, para o sampler nao cair na
+	//unidade 0 das texturas difusas
+	void setupShader(Shader* shader);
+
+	double getGPUTime() { return timer.getAverageTime(); }
+	int getUpdateInterval() { return updateInterval; }
+	//Ultimo quadro: desenhos de objetos somados nas cascatas atualizadas e os descartados
+	int getNbDraws() { return nbDraws; }
+	int getNbCulled() { return nbCulled; }
+
+	enum { NB_CASCADES = 4, TEXTURE_UNIT = 8 };
+
+protected:
+	struct Cascade
+	{
+		glm::mat4 viewProjection; //mundo -> clip da cascata
+		glm::vec3 center; //centro da caixa no espaco da luz
+		float radius = 0.0f; //meia largura da caixa
+		float depthFar = 0.0f; //fim da caixa ao longo da luz
+		float farDepth = 0.0f; //profundidade da camera onde a fatia termina
+		float texelSize = 0.0f; //lado de um texel no mundo
+		bool valid = false;
+	};
+
+	struct Bounds
+	{
+		glm::vec3 center;
+		float radius;
+	};
+
+	//Caixa ortografica em volta da fatia [nearDepth, farDepth] do frustum da camera
+	void fitCascade(Cascade& cascade, const glm::mat4& inverseView, const glm::mat4& projection, float nearDepth, float farDepth);
+	bool needsUpdate(int cascade);
+	void adaptToBudget();
+
+	unique_ptr<Shader> depthShader;
+	GLuint framebuffer = 0, depthTexture = 0;
+	int size = 0;
+
+	glm::vec3 lightPos;
+	glm::mat4 lightView; //rotacao do mundo para o espaco da luz, olhando para -z
+	glm::vec3 sceneCenter; //esfera que contem a cena em qualquer instante
+	float sceneRadius = 0.0f;
+	float sceneNear = 0.0f, sceneFar = 0.0f; //profundidade da cena no espaco da luz
+	Cascade cascades[NB_CASCADES];
+	vector<Bounds> objectBounds; //reaproveitado entre os quadros
+
+	GPUTimer timer;
+	double budget = 0.0;
+	int updateInterval = 1; //1, 2 ou 4 quadros entre as atualizacoes das cascatas distantes
+	int frame = 0, lastAdaptation = 0;
+	int nbDraws = 0, nbCulled = 0;
+};
@@ -0,0 +1,706 @@
+#include "SoftwareRenderer.h"
+#include "MipChain.h"
+#include "stb_image.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+//Pixel sem triangulo no buffer de visibilidade
+static const uint32_t NO_TRIANGLE = 0xFFFFFFFFu;
+//O indice de um triangulo no quadro e bloco << 16 | posicao no bloco
+static const int MAX_BLOCKS = 0xFFFF, MAX_BLOCK_TRIANGLES = 0xFFFF;
+
+void SoftwareRenderer::initialize(int width, int height, int nbThreads)
+{
+	this->width = width;
+	this->height = height;
+	nbTilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	nbTilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	stride = nbTilesX * TILE_SIZE;
+
+	//Os tiles da borda sao completos nos buffers internos, so a cor tem o tamanho da tela
+	depth.assign((size_t)stride * nbTilesY * TILE_SIZE, 1.0f);
+	visible.assign((size_t)stride * nbTilesY * TILE_SIZE, NO_TRIANGLE);
+	color.assign((size_t)width * height * 4, 255);
+
+	if (nbThreads <= 0)
+	{
+		nbThreads = max(1, (int)thread::hardware_concurrency());
+	}
+	workers.stop();
+	nbWorkers = nbThreads - 1;
+	if (nbWorkers > 0)
+	{
+		workers.start(nbWorkers);
+	}
+	setShadingKernel(getBestPhongKernel());
+}
+
+void SoftwareRenderer::loadMaterials(MaterialLibrary& library)
+{
+	int nbMaterials = library.getNbMaterials();
+	for (int c = 0; c < 3; c++)
+	{
+		ka[c].assign(nbMaterials, 0.0f);
+		ks[c].assign(nbMaterials, 0.0f);
+	}
+	kd.assign(nbMaterials, 0.0f);
+	q.assign(nbMaterials, 0.0f);
+	nbLevels.assign(nbMaterials, 1);
+	levelOffset.assign((size_t)nbMaterials * PHONG_MAX_LEVELS, 0);
+	levelWidth.assign((size_t)nbMaterials * PHONG_MAX_LEVELS, 1);
+	levelHeight.assign((size_t)nbMaterials * PHONG_MAX_LEVELS, 1);
+	//Texel 0: branco, para materiais sem textura (texColor = 1)
+	texels.assign(1, 0xFFFFFFFFu);
+
+	//Cada textura entra uma vez no vetor de texels; firstMaterial guarda o material que a carregou
+	vector<string> paths;
+	vector<int> firstMaterial;
+	for (int i = 0; i < nbMaterials; i++)
+	{
+		glm::vec4 ambient = library.getAmbient(i), specular = library.getSpecular(i);
+		for (int c = 0; c < 3; c++)
+		{
+			ka[c][i] = ambient[c];
+			ks[c][i] = specular[c];
+		}
+		kd[i] = ambient.w;
+		q[i] = specular.w;
+
+		string path = library.getTexturePath(i);
+		if (path.empty())
+		{
+			continue;
+		}
+		int texture = find(paths.begin(), paths.end(), path) - paths.begin();
+		if (texture < paths.size())
+		{
+			int source = firstMaterial[texture];
+			nbLevels[i] = nbLevels[source];
+			copy(levelOffset.begin() + source * PHONG_MAX_LEVELS, levelOffset.begin() + (source + 1) * PHONG_MAX_LEVELS, levelOffset.begin() + i * PHONG_MAX_LEVELS);
+			copy(levelWidth.begin() + source * PHONG_MAX_LEVELS, levelWidth.begin() + (source + 1) * PHONG_MAX_LEVELS, levelWidth.begin() + i * PHONG_MAX_LEVELS);
+			copy(levelHeight.begin() + source * PHONG_MAX_LEVELS, levelHeight.begin() + (source + 1) * PHONG_MAX_LEVELS, levelHeight.begin() + i * PHONG_MAX_LEVELS);
+			continue;
+		}
+		paths.push_back(path);
+		firstMaterial.push_back(i);
+
+		int textureWidth, textureHeight, nrChannels;
+		unsigned char* data = stbi_load(path.c_str(), &textureWidth, &textureHeight, &nrChannels, 4);
+		if (!data)
+		{
+			cout << "Failed to load texture" << endl;
+			continue;
+		}
+
+		MipChain mips;
+		mips.build(data, textureWidth, textureHeight, min(MipChain::getNbLevels(textureWidth, textureHeight), PHONG_MAX_LEVELS));
+		nbLevels[i] = mips.getNbLevels();
+		for (int level = 0; level < mips.getNbLevels(); level++)
+		{
+			int slot = i * PHONG_MAX_LEVELS + level;
+			levelOffset[slot] = texels.size();
+			levelWidth[slot] = mips.getWidth(level);
+			levelHeight[slot] = mips.getHeight(level);
+			//RGBA8 na ordem da memoria: no little-endian R fica no byte baixo do uint32_t
+			const uint32_t* pixels = (const uint32_t*)mips.getPixels(level);
+			texels.insert(texels.end(), pixels, pixels + (size_t)levelWidth[slot] * levelHeight[slot]);
+		}
+		stbi_image_free(data);
+	}
+
+	for (int c = 0; c < 3; c++)
+	{
+		uniforms.ka[c] = ka[c].data();
+		uniforms.ks[c] = ks[c].data();
+	}
+	uniforms.kd = kd.data();
+	uniforms.q = q.data();
+	uniforms.nbLevels = nbLevels.data();
+	uniforms.levelOffset = levelOffset.data();
+	uniforms.levelWidth = levelWidth.data();
+	uniforms.levelHeight = levelHeight.data();
+	uniforms.texels = texels.data();
+}
+
+void SoftwareRenderer::setShadingKernel(PhongKernelType type)
+{
+	kernelType = isPhongKernelSupported(type) ? type : getBestPhongKernel();
+	kernel = getPhongKernel(kernelType);
+}
+
+void SoftwareRenderer::setCamera(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos)
+{
+	this->view = view;
+	this->projection = projection;
+	this->cameraPos = cameraPos;
+	for (int c = 0; c < 3; c++)
+	{
+		uniforms.cameraPos[c] = cameraPos[c];
+	}
+}
+
+void SoftwareRenderer::setLight(glm::vec3 lightPos, glm::vec3 lightColor)
+{
+	this->lightPos = lightPos;
+	this->lightColor = lightColor;
+	for (int c = 0; c < 3; c++)
+	{
+		uniforms.lightPos[c] = lightPos[c];
+		uniforms.lightColor[c] = lightColor[c];
+	}
+}
+
+void SoftwareRenderer::begin(glm::vec3 clearColor)
+{
+	this->clearColor = clearColor;
+	items.clear();
+	nbFrameTriangles = 0;
+}
+
+void SoftwareRenderer::draw(Mesh& mesh, float pathTime)
+{
+	const MeshSource* source = mesh.getSource();
+	if (!source || source->positions.empty())
+	{
+		return;
+	}
+
+	DrawItem item;
+	item.model = mesh.getModelMatrix();
+	item.positions = source->positions.data();
+	item.textureCoords = source->textureCoords.data();
+	item.normals = source->normals.data();
+	item.materialId = mesh.getMaterialId();
+	item.nbTriangles = source->positions.size() / 9;
+
+	//Como o glDrawArraysInstanced: uma copia por instancia, deslocada na trajetoria
+	for (int i = 0; i < mesh.getNbInstances(); i++)
+	{
+		item.offset = mesh.getPathOffset(i, pathTime);
+		item.firstTriangle = nbFrameTriangles;
+		nbFrameTriangles += item.nbTriangles;
+		items.push_back(item);
+	}
+}
+
+void SoftwareRenderer::end()
+{
+	//Acima de MAX_BLOCKS blocos o quadro e dividido em blocos maiores
+	blockSize = max((int)TRIANGLES_PER_BLOCK, (nbFrameTriangles + MAX_BLOCKS - 1) / MAX_BLOCKS);
+	nbBlocks = (nbFrameTriangles + blockSize - 1) / blockSize;
+	int nbTiles = nbTilesX * nbTilesY;
+	if (blockTriangles.size() < nbBlocks)
+	{
+		blockTriangles.resize(nbBlocks);
+		bins.resize((size_t)nbBlocks * nbTiles);
+	}
+
+	parallelFor(nbBlocks, &SoftwareRenderer::processBlock);
+	parallelFor(nbTiles, &SoftwareRenderer::renderTile);
+}
+
+int SoftwareRenderer::getNbTriangles()
+{
+	int nbTriangles = 0;
+	for (int i = 0; i < nbBlocks; i++)
+	{
+		nbTriangles += blockTriangles[i].size();
+	}
+	return nbTriangles;
+}
+
+void SoftwareRenderer::parallelFor(int count, void (SoftwareRenderer::*job)(int))
+{
+	nextJob = 0;
+	auto run = [this, count, job] {
+		for (int i = nextJob++; i < count; i = nextJob++)
+		{
+			(this->*job)(i);
+		}
+	};
+
+	for (int i = 0; i < min(nbWorkers, count - 1); i++)
+	{
+		workers.submit(run);
+	}
+	run();
+	workers.wait();
+}
+
+void SoftwareRenderer::processBlock(int block)
+{
+	vector<Triangle>& triangles = blockTriangles[block];
+	triangles.clear();
+	int nbTiles = nbTilesX * nbTilesY;
+	for (int i = 0; i < nbTiles; i++)
+	{
+		bins[(size_t)block * nbTiles + i].clear();
+	}
+
+	glm::mat4 viewProjection = projection * view;
+	int first = block * blockSize;
+	int last = min(first + blockSize, nbFrameTriangles);
+
+	//Primeiro objeto do bloco; os seguintes vem em ordem
+	int item = upper_bound(items.begin(), items.end(), first, [](int triangle, const DrawItem& item) { return triangle < item.firstTriangle; }) - items.begin() - 1;
+	ClipVertex vertices[3];
+	for (int triangle = first; triangle < last; triangle++)
+	{
+		while (triangle >= items[item].firstTriangle + items[item].nbTriangles)
+		{
+			item++;
+		}
+
+		const DrawItem& drawItem = items[item];
+		int vertex = (triangle - drawItem.firstTriangle) * 3;
+		for (int i = 0; i < 3; i++)
+		{
+			transformVertex(drawItem, vertex + i, viewProjection, vertices[i]);
+		}
+		clipTriangle(vertices, drawItem.materialId, block);
+	}
+}
+
+void SoftwareRenderer::transformVertex(const DrawItem& item, int vertex, const glm::mat4& viewProjection, ClipVertex& out)
+{
+	//sprite.vs: a normal nao e transformada e o v da textura e invertido
+	const float* position = item.positions + vertex * 3;
+	glm::vec4 world = item.model * glm::vec4(position[0], position[1], position[2], 1.0f);
+	world += glm::vec4(item.offset, 0.0f);
+	out.position = viewProjection * world;
+
+	float* attributes = out.attributes;
+	attributes[0] = world.x;
+	attributes[1] = world.y;
+	attributes[2] = world.z;
+	attributes[3] = item.normals[vertex * 3];
+	attributes[4] = item.normals[vertex * 3 + 1];
+	attributes[5] = item.normals[vertex * 3 + 2];
+	attributes[6] = item.textureCoords[vertex * 2];
+	attributes[7] = 1.0f - item.textureCoords[vertex * 2 + 1];
+}
+
+void SoftwareRenderer::clipTriangle(const ClipVertex* vertices, int materialId, int block)
+{
+	//Fora do frustum por um mesmo plano: descartado sem recorte
+	int outside = 0x3F;
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& p = vertices[i].position;
+		outside &= (p.x < -p.w) | (p.x > p.w) << 1 | (p.y < -p.w) << 2 | (p.y > p.w) << 3 | (p.z < -p.w) << 4 | (p.z > p.w) << 5;
+	}
+	if (outside)
+	{
+		return;
+	}
+
+	//Planos de recorte: near, far e as laterais da banda de guarda, como distancias >= 0
+	float guardX = 1.0f + 2.0f * GUARD_BAND / width;
+	float guardY = 1.0f + 2.0f * GUARD_BAND / height;
+	auto distance = [guardX, guardY](const glm::vec4& p, int plane) {
+		switch (plane)
+		{
+		case 0: return p.z + p.w;
+		case 1: return p.w - p.z;
+		case 2: return guardX * p.w - p.x;
+		case 3: return guardX * p.w + p.x;
+		case 4: return guardY * p.w - p.y;
+		default: return guardY * p.w + p.y;
+		}
+	};
+
+	int crossed = 0;
+	for (int plane = 0; plane < 6; plane++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			if (distance(vertices[i].position, plane) < 0.0f)
+			{
+				crossed |= 1 << plane;
+			}
+		}
+	}
+	if (!crossed)
+	{
+		setupTriangle(vertices[0], vertices[1], vertices[2], materialId, block);
+		return;
+	}
+
+	//Sutherland-Hodgman; cada plano acrescenta no maximo um vertice
+	ClipVertex polygons[2][9];
+	int nbVertices = 3;
+	copy(vertices, vertices + 3, polygons[0]);
+	int current = 0;
+	for (int plane = 0; plane < 6 && nbVertices >= 3; plane++)
+	{
+		if (!(crossed & 1 << plane))
+		{
+			continue;
+		}
+
+		const ClipVertex* in = polygons[current];
+		ClipVertex* out = polygons[1 - current];
+		int nbOut = 0;
+		for (int i = 0; i < nbVertices; i++)
+		{
+			const ClipVertex& a = in[i];
+			const ClipVertex& b = in[(i + 1) % nbVertices];
+			float da = distance(a.position, plane), db = distance(b.position, plane);
+			if (da >= 0.0f)
+			{
+				out[nbOut++] = a;
+			}
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				float t = da / (da - db);
+				ClipVertex& v = out[nbOut++];
+				v.position = a.position + (b.position - a.position) * t;
+				for (int j = 0; j < NB_ATTRIBUTES; j++)
+				{
+					v.attributes[j] = a.attributes[j] + (b.attributes[j] - a.attributes[j]) * t;
+				}
+			}
+		}
+		nbVertices = nbOut;
+		current = 1 - current;
+	}
+
+	const ClipVertex* polygon = polygons[current];
+	for (int i = 1; i + 1 < nbVertices; i++)
+	{
+		setupTriangle(polygon[0], polygon[i], polygon[i + 1], materialId, block);
+	}
+}
+
+//Derivadas em x e y do atributo f que vale f0, f1, f2 nos vertices (posicoes relativas ao vertice 0)
+static void setPlane(float f0, float f1, float f2, float x1, float y1, float x2, float y2, float invArea, float& dx, float& dy)
+{
+	dx = ((f1 - f0) * y2 - (f2 - f0) * y1) * invArea;
+	dy = ((f2 - f0) * x1 - (f1 - f0) * x2) * invArea;
+}
+
+void SoftwareRenderer::setupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, int materialId, int block)
+{
+	vector<Triangle>& triangles = blockTriangles[block];
+	if (triangles.size() >= MAX_BLOCK_TRIANGLES)
+	{
+		return;
+	}
+
+	//Viewport e ajuste para a grade de subpixels, como o rasterizador da GPU
+	const ClipVertex* v[3] = { &v0, &v1, &v2 };
+	const float subpixels = (float)(1 << SUBPIXEL_BITS);
+	int64_t X[3], Y[3];
+	float z[3], invW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& p = v[i]->position;
+		invW[i] = 1.0f / p.w;
+		X[i] = (int64_t)floor(((p.x * invW[i]) * 0.5f + 0.5f) * width * subpixels + 0.5f);
+		Y[i] = (int64_t)floor(((p.y * invW[i]) * 0.5f + 0.5f) * height * subpixels + 0.5f);
+		z[i] = (p.z * invW[i]) * 0.5f + 0.5f;
+	}
+
+	//Sem GL_CULL_FACE: triangulos no sentido horario sao virados
+	int64_t area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+	if (area == 0)
+	{
+		return;
+	}
+	if (area < 0)
+	{
+		swap(v[1], v[2]);
+		swap(X[1], X[2]);
+		swap(Y[1], Y[2]);
+		swap(z[1], z[2]);
+		swap(invW[1], invW[2]);
+		area = -area;
+	}
+
+	//Amostra no centro do pixel: (x * 2^SUBPIXEL_BITS + meio pixel) em subpixels
+	int64_t half = 1 << (SUBPIXEL_BITS - 1);
+	int64_t minX = min(X[0], min(X[1], X[2])), maxX = max(X[0], max(X[1], X[2]));
+	int64_t minY = min(Y[0], min(Y[1], Y[2])), maxY = max(Y[0], max(Y[1], Y[2]));
+	Triangle triangle;
+	triangle.minX = max(0, (int)ceil((minX - half) / (double)subpixels));
+	triangle.maxX = min(width - 1, (int)floor((maxX - half) / (double)subpixels));
+	triangle.minY = max(0, (int)ceil((minY - half) / (double)subpixels));
+	triangle.maxY = min(height - 1, (int)floor((maxY - half) / (double)subpixels));
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+	{
+		return;
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		int j = (i + 1) % 3;
+		int64_t a = Y[i] - Y[j], b = X[j] - X[i];
+		int64_t c = -(a * X[i] + b * Y[i]);
+		//Regra topo-esquerda: amostras sobre arestas que nao sao de cima nem da esquerda ficam de fora
+		bool topLeft = a > 0 || (a == 0 && b < 0);
+		//Um pixel inteiro de passo, com a amostra no centro
+		triangle.a[i] = a << SUBPIXEL_BITS;
+		triangle.b[i] = b << SUBPIXEL_BITS;
+		triangle.c[i] = c + (a + b) * half - (topLeft ? 0 : 1);
+	}
+
+	float x0 = X[0] / subpixels, y0 = Y[0] / subpixels;
+	float x1 = X[1] / subpixels - x0, y1 = Y[1] / subpixels - y0;
+	float x2 = X[2] / subpixels - x0, y2 = Y[2] / subpixels - y0;
+	float invArea = subpixels * subpixels / (float)area;
+	triangle.x0 = x0;
+	triangle.y0 = y0;
+
+	triangle.z.origin = z[0];
+	setPlane(z[0], z[1], z[2], x1, y1, x2, y2, invArea, triangle.z.dx, triangle.z.dy);
+	triangle.invW.origin = invW[0];
+	setPlane(invW[0], invW[1], invW[2], x1, y1, x2, y2, invArea, triangle.invW.dx, triangle.invW.dy);
+	for (int i = 0; i < NB_ATTRIBUTES; i++)
+	{
+		float f0 = v[0]->attributes[i] * invW[0], f1 = v[1]->attributes[i] * invW[1], f2 = v[2]->attributes[i] * invW[2];
+		Plane& plane = triangle.attributes[i];
+		plane.origin = f0;
+		setPlane(f0, f1, f2, x1, y1, x2, y2, invArea, plane.dx, plane.dy);
+	}
+	triangle.materialId = materialId;
+
+	uint32_t id = (uint32_t)block << 16 | (uint32_t)triangles.size();
+	triangles.push_back(triangle);
+
+	int nbTiles = nbTilesX * nbTilesY;
+	for (int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+	{
+		for (int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+		{
+			bins[(size_t)block * nbTiles + ty * nbTilesX + tx].push_back(id);
+		}
+	}
+}
+
+void SoftwareRenderer::renderTile(int tile)
+{
+	int tileX = tile % nbTilesX, tileY = tile / nbTilesX;
+	for (int y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; y++)
+	{
+		size_t row = (size_t)y * stride + tileX * TILE_SIZE;
+		fill(depth.begin() + row, depth.begin() + row + TILE_SIZE, 1.0f);
+		fill(visible.begin() + row, visible.begin() + row + TILE_SIZE, NO_TRIANGLE);
+	}
+
+	//Ordem de envio: bloco a bloco e, em cada bloco, na ordem dos triangulos
+	int nbTiles = nbTilesX * nbTilesY;
+	for (int block = 0; block < nbBlocks; block++)
+	{
+		const vector<uint32_t>& bin = bins[(size_t)block * nbTiles + tile];
+		const vector<Triangle>& triangles = blockTriangles[block];
+		for (int i = 0; i < bin.size(); i++)
+		{
+			rasterize(triangles[bin[i] & 0xFFFF], bin[i], tileX, tileY);
+		}
+	}
+
+	shadeTile(tileX, tileY);
+}
+
+void SoftwareRenderer::rasterize(const Triangle& triangle, uint32_t id, int tileX, int tileY)
+{
+	//Retangulo do triangulo no tile, com x alinhado a grupos de 4 pixels
+	int startX = max(triangle.minX, tileX * TILE_SIZE) & ~3;
+	int endX = min(triangle.maxX, (tileX + 1) * TILE_SIZE - 1);
+	int startY = max(triangle.minY, tileY * TILE_SIZE);
+	int endY = min(triangle.maxY, (tileY + 1) * TILE_SIZE - 1);
+	if (startX > endX || startY > endY)
+	{
+		return;
+	}
+	int nbGroups = (endX - startX) / 4 + 1;
+	int lastX = startX + nbGroups * 4 - 1;
+
+	//Arestas que deixam os quatro cantos dentro sao ignoradas; se algum lado deixa todos
+	//fora o triangulo nao toca o retangulo. Nas restantes a aresta cruza o retangulo e os
+	//valores cabem em 32 bits
+	__m128i edge[3], stepX[3], stepY[3];
+	for (int i = 0; i < 3; i++)
+	{
+		int64_t a = triangle.a[i], b = triangle.b[i];
+		int64_t e = a * startX + b * startY + triangle.c[i];
+		int64_t corners[4] = { e, e + a * (lastX - startX), e + b * (endY - startY), e + a * (lastX - startX) + b * (endY - startY) };
+		int nbInside = 0;
+		for (int j = 0; j < 4; j++)
+		{
+			nbInside += corners[j] >= 0;
+		}
+		if (nbInside == 0)
+		{
+			return;
+		}
+
+		if (nbInside == 4)
+		{
+			edge[i] = stepX[i] = stepY[i] = _mm_setzero_si128();
+		}
+		else
+		{
+			edge[i] = _mm_setr_epi32((int)e, (int)(e + a), (int)(e + 2 * a), (int)(e + 3 * a));
+			stepX[i] = _mm_set1_epi32((int)(a * 4));
+			stepY[i] = _mm_set1_epi32((int)b);
+		}
+	}
+
+	float offsetX = startX + 0.5f - triangle.x0, offsetY = startY + 0.5f - triangle.y0;
+	__m128 z = _mm_add_ps(_mm_set1_ps(triangle.z.origin + triangle.z.dx * offsetX + triangle.z.dy * offsetY),
+		_mm_mul_ps(_mm_set1_ps(triangle.z.dx), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)));
+	__m128 zStepX = _mm_set1_ps(triangle.z.dx * 4.0f), zStepY = _mm_set1_ps(triangle.z.dy);
+	__m128i ids = _mm_set1_epi32((int)id);
+
+	for (int y = startY; y <= endY; y++)
+	{
+		__m128i e0 = edge[0], e1 = edge[1], e2 = edge[2];
+		__m128 rowZ = z;
+		float* depthRow = &depth[(size_t)y * stride + startX];
+		uint32_t* visibleRow = &visible[(size_t)y * stride + startX];
+		for (int group = 0; group < nbGroups; group++)
+		{
+			//Bit de sinal de qualquer aresta: pixel fora do triangulo
+			__m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), 31);
+			if (_mm_movemask_epi8(outside) != 0xFFFF)
+			{
+				__m128 stored = _mm_loadu_ps(depthRow + group * 4);
+				__m128i write = _mm_andnot_si128(outside, _mm_castps_si128(_mm_cmplt_ps(rowZ, stored)));
+				__m128 newDepth = _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(write), rowZ), _mm_andnot_ps(_mm_castsi128_ps(write), stored));
+				_mm_storeu_ps(depthRow + group * 4, newDepth);
+				__m128i storedIds = _mm_loadu_si128((const __m128i*)(visibleRow + group * 4));
+				_mm_storeu_si128((__m128i*)(visibleRow + group * 4), _mm_or_si128(_mm_and_si128(write, ids), _mm_andnot_si128(write, storedIds)));
+			}
+			e0 = _mm_add_epi32(e0, stepX[0]);
+			e1 = _mm_add_epi32(e1, stepX[1]);
+			e2 = _mm_add_epi32(e2, stepX[2]);
+			rowZ = _mm_add_ps(rowZ, zStepX);
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			edge[i] = _mm_add_epi32(edge[i], stepY[i]);
+		}
+		z = _mm_add_ps(z, zStepY);
+	}
+}
+
+void SoftwareRenderer::shadeTile(int tileX, int tileY)
+{
+	int startX = tileX * TILE_SIZE, endX = min(width, startX + TILE_SIZE);
+	int startY = tileY * TILE_SIZE, endY = min(height, startY + TILE_SIZE);
+	uint32_t background = 0xFF000000u;
+	for (int c = 0; c < 3; c++)
+	{
+		background |= (uint32_t)(glm::clamp(clearColor[c], 0.0f, 1.0f) * 255.0f + 0.5f) << (8 * c);
+	}
+	uint32_t* output = (uint32_t*)color.data();
+
+	//Lote na pilha da thread; o alignas de PhongBatch garante as cargas alinhadas do kernel
+	PhongBatch batch;
+	batch.nbLanes = 0;
+	//Quads alinhados a 2 pixels: o tile tem tamanho par e os buffers internos cobrem a
+	//linha e a coluna que passam da tela
+	for (int y = startY; y < endY; y += 2)
+	{
+		for (int x = startX; x < endX; x += 2)
+		{
+			uint32_t ids[4];
+			int pixels[4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int px = x + (lane & 1), py = y + (lane >> 1);
+				bool inside = px < width && py < height;
+				ids[lane] = inside ? visible[(size_t)py * stride + px] : NO_TRIANGLE;
+				pixels[lane] = inside ? py * width + px : -1;
+				if (inside && ids[lane] == NO_TRIANGLE)
+				{
+					output[pixels[lane]] = background;
+				}
+			}
+
+			//Um quad por triangulo presente, como na GPU
+			for (int lane = 0; lane < 4; lane++)
+			{
+				uint32_t id = ids[lane];
+				if (id == NO_TRIANGLE || (lane > 0 && id == ids[0]) || (lane > 1 && id == ids[1]) || (lane > 2 && id == ids[2]))
+				{
+					continue;
+				}
+
+				int lanePixels[4];
+				for (int i = 0; i < 4; i++)
+				{
+					lanePixels[i] = ids[i] == id ? pixels[i] : -1;
+				}
+				addQuad(batch, blockTriangles[id >> 16][id & 0xFFFF], x, y, lanePixels);
+				if (batch.nbLanes == PhongBatch::MAX_LANES)
+				{
+					flushBatch(batch);
+				}
+			}
+		}
+	}
+	flushBatch(batch);
+}
+
+void SoftwareRenderer::addQuad(PhongBatch& batch, const Triangle& triangle, int x, int y, const int* pixels)
+{
+	//Atributos com correcao de perspectiva: (f / w) / (1 / w), nos centros dos 4 pixels
+	__m128 dx = _mm_sub_ps(_mm_setr_ps(x + 0.5f, x + 1.5f, x + 0.5f, x + 1.5f), _mm_set1_ps(triangle.x0));
+	__m128 dy = _mm_sub_ps(_mm_setr_ps(y + 0.5f, y + 0.5f, y + 1.5f, y + 1.5f), _mm_set1_ps(triangle.y0));
+	auto evaluate = [dx, dy](const Plane& plane) {
+		return _mm_add_ps(_mm_add_ps(_mm_set1_ps(plane.origin), _mm_mul_ps(_mm_set1_ps(plane.dx), dx)), _mm_mul_ps(_mm_set1_ps(plane.dy), dy));
+	};
+	__m128 w = _mm_div_ps(_mm_set1_ps(1.0f), evaluate(triangle.invW));
+
+	int n = batch.nbLanes;
+	float* attributes[NB_ATTRIBUTES] = { batch.positionX, batch.positionY, batch.positionZ, batch.normalX, batch.normalY, batch.normalZ, batch.u, batch.v };
+	for (int i = 0; i < NB_ATTRIBUTES; i++)
+	{
+		_mm_store_ps(attributes[i] + n, _mm_mul_ps(evaluate(triangle.attributes[i]), w));
+	}
+	_mm_store_si128((__m128i*)(batch.material + n), _mm_set1_epi32(triangle.materialId));
+	_mm_store_si128((__m128i*)(batch.pixel + n), _mm_loadu_si128((const __m128i*)pixels));
+	batch.nbLanes = n + 4;
+}
+
+void SoftwareRenderer::flushBatch(PhongBatch& batch)
+{
+	if (batch.nbLanes == 0)
+	{
+		return;
+	}
+
+	//Completa com copias do ultimo quad, sem destino
+	int nbLanes = batch.nbLanes;
+	int last = nbLanes - 4;
+	float* attributes[NB_ATTRIBUTES] = { batch.positionX, batch.positionY, batch.positionZ, batch.normalX, batch.normalY, batch.normalZ, batch.u, batch.v };
+	while (batch.nbLanes % PHONG_BATCH_ALIGN)
+	{
+		int n = batch.nbLanes;
+		for (int i = 0; i < NB_ATTRIBUTES; i++)
+		{
+			copy(attributes[i] + last, attributes[i] + last + 4, attributes[i] + n);
+		}
+		copy(batch.material + last, batch.material + last + 4, batch.material + n);
+		fill(batch.pixel + n, batch.pixel + n + 4, -1);
+		batch.nbLanes = n + 4;
+	}
+
+	kernel(uniforms, batch);
+
+	uint32_t* output = (uint32_t*)color.data();
+	for (int i = 0; i < nbLanes; i++)
+	{
+		if (batch.pixel[i] >= 0)
+		{
+			output[batch.pixel[i]] = batch.color[i];
+		}
+	}
+	batch.nbLanes = 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "Mesh.h"
+#include "MaterialLibrary.h"
+#include "ThreadPool.h"
+#include "PhongKernel.h"
+
+using namespace std;
+
+//Renderizacao da cena em CPU, sem OpenGL, com o mesmo resultado de sprite.vs/sprite.fs:
+//trajetorias, profundidade GL_LESS, UVs com correcao de perspectiva e o modelo de Phong.
+//O quadro e dividido em tiles de TILE_SIZE pixels. Os triangulos sao transformados,
+//recortados e preparados em paralelo, em blocos, e cada bloco distribui os seus nos tiles
+//que a caixa envolvente toca. Cada tile e entao resolvido por uma thread: primeiro a
+//visibilidade (funcoes de aresta em ponto fixo e profundidade, 4 pixels por vez com SSE2),
+//guardando so o triangulo mais proximo de cada pixel; depois o sombreamento, em quads 2x2
+//agrupados em lotes para o PhongKernel (SSE2, AVX2 ou AVX-512, conforme a CPU). Como os triangulos sao percorridos na ordem de envio em cada tile, a imagem
+//nao depende do numero de threads
+class SoftwareRenderer
+{
+public:
+	SoftwareRenderer() {}
+	//nbThreads 0 usa todos os nucleos (a thread que chama end() tambem trabalha)
+	void initialize(int width, int height, int nbThreads = 0);
+	//Le as texturas difusas dos materiais e gera os mipmaps em CPU
+	void loadMaterials(MaterialLibrary& materials);
+	//Por padrao o melhor suportado pela CPU
+	void setShadingKernel(PhongKernelType type);
+	PhongKernelType getShadingKernel() { return kernelType; }
+	void setCamera(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos);
+	void setLight(glm::vec3 lightPos, glm::vec3 lightColor);
+	//Comeca um quadro; draw apenas registra os objetos e end() renderiza todos
+	void begin(glm::vec3 clearColor);
+	//O objeto precisa ter a geometria em CPU (initialize sem shader ou com keepGeometry)
+	void draw(Mesh& mesh, float pathTime);
+	void end();
+	//RGBA8 de baixo para cima, como o glReadPixels
+	const unsigned char* getColorBuffer() { return color.data(); }
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+	int getNbThreads() { return workers.getNbThreads() + 1; }
+	//Triangulos que chegaram a rasterizacao no ultimo quadro, depois do recorte
+	int getNbTriangles();
+
+	enum { TILE_SIZE = 64, SUBPIXEL_BITS = 4, TRIANGLES_PER_BLOCK = 1024 };
+	//Folga em pixels alem da tela antes de recortar nas laterais; dentro dela as funcoes
+	//de aresta cabem em 32 bits em cada tile
+	enum { GUARD_BAND = 4096 };
+
+protected:
+	//Atributo interpolado linearmente na tela: valor no vertice 0 e derivadas em x e y
+	struct Plane
+	{
+		float dx, dy, origin;
+	};
+
+	//Atributos de vertice depois da transformacao: posicao no mundo, normal e UV
+	enum { NB_ATTRIBUTES = 8 };
+
+	struct ClipVertex
+	{
+		glm::vec4 position;
+		float attributes[NB_ATTRIBUTES];
+	};
+
+	struct Triangle
+	{
+		//Funcoes de aresta em subpixels: E = a * x + b * y + c, dentro quando E >= 0 (com a
+		//regra topo-esquerda ja incluida em c)
+		int64_t a[3], b[3], c[3];
+		int minX, minY, maxX, maxY; //caixa em pixels, ja limitada a tela
+		float x0, y0; //vertice 0 em pixels, origem dos planos
+		Plane z, invW;
+		Plane attributes[NB_ATTRIBUTES]; //atributo / w
+		int materialId;
+	};
+
+	//Um objeto (ou uma instancia) do quadro
+	struct DrawItem
+	{
+		glm::mat4 model;
+		glm::vec3 offset;
+		const float* positions;
+		const float* textureCoords;
+		const float* normals;
+		int materialId;
+		int firstTriangle; //posicao no quadro, para dividir os blocos
+		int nbTriangles;
+	};
+
+	//Executa job(0..count-1) no pool e na thread que chama
+	void parallelFor(int count, void (SoftwareRenderer::*job)(int));
+	void processBlock(int block);
+	void renderTile(int tile);
+	void transformVertex(const DrawItem& item, int vertex, const glm::mat4& viewProjection, ClipVertex& out);
+	//Recorta contra near, far e a banda de guarda e monta os triangulos resultantes
+	void clipTriangle(const ClipVertex* vertices, int materialId, int block);
+	void setupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, int materialId, int block);
+	void rasterize(const Triangle& triangle, uint32_t id, int tileX, int tileY);
+	void shadeTile(int tileX, int tileY);
+	//Interpola os atributos do triangulo nas 4 lanes do quad em (x, y); as lanes de outros
+	//triangulos entram como auxiliares, so para as derivadas
+	void addQuad(PhongBatch& batch, const Triangle& triangle, int x, int y, const int* pixels);
+	void flushBatch(PhongBatch& batch);
+
+	int width = 0, height = 0;
+	int nbTilesX = 0, nbTilesY = 0;
+	int stride = 0; //largura dos buffers internos, multipla de TILE_SIZE
+
+	glm::mat4 view, projection;
+	glm::vec3 cameraPos, lightPos, lightColor;
+	glm::vec3 clearColor;
+
+	vector<DrawItem> items;
+	int nbFrameTriangles = 0;
+	int blockSize = TRIANGLES_PER_BLOCK;
+	int nbBlocks = 0;
+	//Triangulos preparados e, para cada tile, os indices dos que o tocam, por bloco
+	vector<vector<Triangle>> blockTriangles;
+	vector<vector<uint32_t>> bins; //bins[bloco * nbTiles + tile]
+
+	vector<float> depth;
+	vector<uint32_t> visible; //bloco << 16 | indice no bloco, ou NO_TRIANGLE
+	vector<unsigned char> color;
+
+	//Materiais em SoA e mipmaps de todas as texturas, apontados por uniforms
+	vector<float> ka[3], kd, ks[3], q;
+	vector<int32_t> nbLevels, levelOffset, levelWidth, levelHeight;
+	vector<uint32_t> texels;
+	PhongUniforms uniforms = {};
+	PhongKernelType kernelType = PHONG_SCALAR;
+	PhongKernel kernel = nullptr;
+
+	ThreadPool workers;
+	int nbWorkers = 0;
+	atomic<int> nextJob{ 0 };
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <type_traits>
+#include <algorithm>
+
+using namespace std;
+
+//Motor de splines cubicas com a matriz de base como parametro de template.
+//Uma base define:
+//  m(k, j)     -> elemento constexpr da matriz de base, na mesma ordem do construtor glm::mat4
+//                 (k = coluna/potencia de t, j = linha/ponto da janela)
+//  stride      -> quantos pontos de controle avancar entre segmentos
+//  geometry(p) -> matriz G montada a partir da janela p[0..3]
+//Para uma base nova basta escrever uma struct com esses tres membros.
+
+struct BezierBasis
+{
+	static constexpr float m(int k, int j)
+	{
+		const float M[16] = { -1, 3, -3, 1,
+			3, -6, 3, 0,
+			-3, 3, 0, 0,
+			1, 0, 0, 0 };
+		return M[k * 4 + j];
+	}
+	static const int stride = 3;
+	static glm::mat4x3 geometry(const glm::vec3* p) { return glm::mat4x3(p[0], p[1], p[2], p[3]); }
+};
+
+struct HermiteBasis
+{
+	static constexpr float m(int k, int j)
+	{
+		const float M[16] = { 2, -2, 1, 1,
+			-3, 3, -2, -1,
+			0, 0, 1, 0,
+			1, 0, 0, 0 };
+		return M[k * 4 + j];
+	}
+	static const int stride = 3;
+	//Pontos extremos p[0] e p[3], tangentes dadas por p[1] e p[2]
+	static glm::mat4x3 geometry(const glm::vec3* p) { return glm::mat4x3(p[0], p[3], p[1] - p[0], p[2] - p[3]); }
+};
+
+//Catmull-Rom uniforme: janela deslizante, nControlPoints - 3 segmentos entre os pontos
+//internos (a classe CatmullRom tambem cobre os extremos e as outras parametrizacoes)
+struct CatmullRomBasis
+{
+	static constexpr float m(int k, int j)
+	{
+		const float M[16] = { -0.5f, 1.5f, -1.5f, 0.5f,
+			1.0f, -2.5f, 2.0f, -0.5f,
+			-0.5f, 0.0f, 0.5f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f };
+		return M[k * 4 + j];
+	}
+	static const int stride = 1;
+	static glm::mat4x3 geometry(const glm::vec3* p) { return glm::mat4x3(p[0], p[1], p[2], p[3]); }
+};
+
+//B-spline cubica uniforme (C2, nao interpola os pontos de controle)
+struct BSplineBasis
+{
+	static constexpr float m(int k, int j)
+	{
+		const float M[16] = { -1.0f / 6, 3.0f / 6, -3.0f / 6, 1.0f / 6,
+			3.0f / 6, -6.0f / 6, 3.0f / 6, 0.0f,
+			-3.0f / 6, 0.0f, 3.0f / 6, 0.0f,
+			1.0f / 6, 4.0f / 6, 1.0f / 6, 0.0f };
+		return M[k * 4 + j];
+	}
+	static const int stride = 1;
+	static glm::mat4x3 geometry(const glm::vec3* p) { return glm::mat4x3(p[0], p[1], p[2], p[3]); }
+};
+
+//Coeficientes de um segmento: p(t) = ((a*t + b)*t + c)*t + d
+struct SplineSegment
+{
+	glm::vec3 a, b, c, d;
+
+	glm::vec3 evaluate(float t) const { return ((a * t + b) * t + c) * t + d; }
+	glm::vec3 tangent(float t) const { return (a * (3.0f * t) + b * 2.0f) * t + c; }
+};
+
+namespace SplineDetail
+{
+	enum { ZERO, ONE, MINUS_ONE, GENERAL };
+
+	constexpr int weightKind(float w)
+	{
+		return w == 0.0f ? ZERO : (w == 1.0f ? ONE : (w == -1.0f ? MINUS_ONE : GENERAL));
+	}
+
+	inline glm::vec3 addTerm(const glm::vec3& acc, const glm::vec3&, float, integral_constant<int, ZERO>) { return acc; }
+	inline glm::vec3 addTerm(const glm::vec3& acc, const glm::vec3& g, float, integral_constant<int, ONE>) { return acc + g; }
+	inline glm::vec3 addTerm(const glm::vec3& acc, const glm::vec3& g, float, integral_constant<int, MINUS_ONE>) { return acc - g; }
+	inline glm::vec3 addTerm(const glm::vec3& acc, const glm::vec3& g, float w, integral_constant<int, GENERAL>) { return acc + g * w; }
+
+	//Coluna k de G * M, expandida em tempo de compilacao: pesos 0 somem e pesos +-1 nao multiplicam
+	template <class Basis, int k, int j>
+	struct Column
+	{
+		static glm::vec3 sum(const glm::mat4x3& G, const glm::vec3& acc)
+		{
+			return Column<Basis, k, j + 1>::sum(G, addTerm(acc, G[j], Basis::m(k, j), integral_constant<int, weightKind(Basis::m(k, j))>()));
+		}
+	};
+
+	template <class Basis, int k>
+	struct Column<Basis, k, 4>
+	{
+		static glm::vec3 sum(const glm::mat4x3&, const glm::vec3& acc) { return acc; }
+	};
+
+	//-0 e o elemento neutro exato da soma em ponto flutuante, entao o compilador elimina o acumulador inicial
+	template <class Basis, int k>
+	inline glm::vec3 coefficient(const glm::mat4x3& G)
+	{
+		return Column<Basis, k, 0>::sum(G, glm::vec3(-0.0f));
+	}
+}
+
+template <class Basis>
+class Spline
+{
+public:
+	static int getNbSegments(int nControlPoints)
+	{
+		if (nControlPoints < 4)
+		{
+			return 0;
+		}
+		return (nControlPoints - 4) / Basis::stride + 1;
+	}
+
+	static glm::mat4 getBasisMatrix()
+	{
+		glm::mat4 M;
+		for (int k = 0; k < 4; k++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				M[k][j] = Basis::m(k, j);
+			}
+		}
+		return M;
+	}
+
+	//Segmentos cuja janela de pontos contem o ponto de controle
+	static void getAffectedSegments(int controlPoint, int nControlPoints, vector<int>& segments)
+	{
+		int nSegments = getNbSegments(nControlPoints);
+
+		segments.clear();
+		for (int s = max(0, (controlPoint - 3 + Basis::stride - 1) / Basis::stride); s < nSegments && s * Basis::stride <= controlPoint; s++)
+		{
+			segments.push_back(s);
+		}
+	}
+
+	static glm::mat4x3 getGeometryMatrix(const vector<glm::vec3>& controlPoints, int segment)
+	{
+		return Basis::geometry(&controlPoints[segment * Basis::stride]);
+	}
+
+	static SplineSegment getSegment(const vector<glm::vec3>& controlPoints, int segment)
+	{
+		glm::mat4x3 G = getGeometryMatrix(controlPoints, segment);
+
+		SplineSegment s;
+		s.a = SplineDetail::coefficient<Basis, 0>(G);
+		s.b = SplineDetail::coefficient<Basis, 1>(G);
+		s.c = SplineDetail::coefficient<Basis, 2>(G);
+		s.d = SplineDetail::coefficient<Basis, 3>(G);
+		return s;
+	}
+
+	//Coeficientes calculados uma vez por segmento; cada ponto custa so o Horner
+	static void tessellate(const vector<glm::vec3>& controlPoints, int pointsPerSegment, vector<glm::vec3>& curvePoints)
+	{
+		int nSegments = getNbSegments(controlPoints.size());
+		float step = 1.0f / (float)pointsPerSegment;
+
+		curvePoints.clear();
+
+		if (nSegments == 0)
+		{
+			return;
+		}
+
+		curvePoints.reserve(nSegments * pointsPerSegment + 1);
+
+		SplineSegment s;
+		for (int i = 0; i < nSegments; i++)
+		{
+			s = getSegment(controlPoints, i);
+
+			for (int k = 0; k < pointsPerSegment; k++)
+			{
+				curvePoints.push_back(s.evaluate(k * step));
+			}
+		}
+
+		curvePoints.push_back(s.evaluate(1.0f));
+	}
+};
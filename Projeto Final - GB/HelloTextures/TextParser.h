@@ -0,0 +1,160 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+//Funcoes de leitura de texto sem alocacao, usadas pelos parsers de cena, OBJ e MTL.
+//Todas avancam o ponteiro p e nunca leem alem de end
+
+inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline void skipSpaces(const char*& p, const char* end)
+{
+	while (p < end && isSpace(*p))
+	{
+		p++;
+	}
+}
+
+template <size_t N>
+inline bool isKeyword(const char* token, size_t length, const char (&keyword)[N])
+{
+	return length == N - 1 && memcmp(token, keyword, N - 1) == 0;
+}
+
+//Le o proximo token ate o espaco ou fim de linha
+inline size_t readToken(const char*& p, const char* end, const char*& token)
+{
+	skipSpaces(p, end);
+	token = p;
+	while (p < end && !isSpace(*p) && *p != '\n')
+	{
+		p++;
+	}
+	return p - token;
+}
+
+inline bool parseInt(const char*& p, const char* end, int& value)
+{
+	skipSpaces(p, end);
+
+	bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		p++;
+	}
+
+	if (p == end || *p < '0' || *p > '9')
+	{
+		return false;
+	}
+
+	int result = 0;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		result = result * 10 + (*p++ - '0');
+	}
+
+	value = negative ? -result : result;
+	return true;
+}
+
+//Decimal com expoente opcional; a mantissa e acumulada como inteiro e escalada uma vez
+inline bool parseFloat(const char*& p, const char* end, float& value)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	skipSpaces(p, end);
+
+	bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0, digits = 0;
+
+	for (; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+	{
+		if (mantissa < 100000000000000000ULL)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+		{
+			if (mantissa < 100000000000000000ULL)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				exponent--;
+			}
+		}
+	}
+
+	if (digits == 0)
+	{
+		return false;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		int e;
+		if (!parseInt(p, end, e))
+		{
+			return false;
+		}
+		exponent += e;
+	}
+
+	//Potencias exatas ate 1e22; alem disso pow, que so perde precisao muito alem da do float
+	double result = (double)mantissa;
+	if (exponent < -22 || exponent > 22)
+	{
+		result *= pow(10.0, exponent);
+	}
+	else if (exponent < 0)
+	{
+		result /= powers[-exponent];
+	}
+	else if (exponent > 0)
+	{
+		result *= powers[exponent];
+	}
+
+	value = (float)(negative ? -result : result);
+	return true;
+}
+
+inline bool parseVec3(const char*& p, const char* end, glm::vec3& v)
+{
+	return parseFloat(p, end, v.x) && parseFloat(p, end, v.y) && parseFloat(p, end, v.z);
+}
+
+inline bool parseVec2(const char*& p, const char* end, glm::vec2& v)
+{
+	return parseFloat(p, end, v.x) && parseFloat(p, end, v.y);
+}
+
+//Avanca ate o inicio da proxima linha
+inline void skipLine(const char*& p, const char* end)
+{
+	const char* newline = (const char*)memchr(p, '\n', end - p);
+	p = newline ? newline + 1 : end;
+}
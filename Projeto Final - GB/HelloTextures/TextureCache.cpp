@@ -0,0 +1,126 @@
+#include "TextureCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+//Cabecalho do arquivo de cache; a versao muda junto com o formato ou o compressor
+struct TextureCacheHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned long long key;
+	int format, width, height, nbLayers, nbLevels;
+};
+
+static const char TEXTURE_CACHE_MAGIC[4] = { 'T', 'X', 'C', 'B' };
+static const unsigned int TEXTURE_CACHE_VERSION = 2;
+
+size_t CompressedTexture::getLevelOffset(int level) const
+{
+	size_t offset = 0;
+	for (int i = 0; i < level; i++)
+	{
+		offset += getLevelSize(i);
+	}
+	return offset;
+}
+
+void CompressedTexture::allocate()
+{
+	data.resize(getLevelOffset(nbLevels));
+}
+
+string TextureCache::getPath(unsigned long long key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.btc", key);
+	return directory + name;
+}
+
+bool TextureCache::load(unsigned long long key, CompressedTexture& texture)
+{
+	ifstream file(getPath(key), ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	TextureCacheHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, TEXTURE_CACHE_MAGIC, 4) != 0 ||
+		header.version != TEXTURE_CACHE_VERSION || header.key != key ||
+		(header.format != BLOCK_BC1 && header.format != BLOCK_BC3))
+	{
+		return false;
+	}
+
+	texture.format = (BlockFormat)header.format;
+	texture.width = header.width;
+	texture.height = header.height;
+	texture.nbLayers = header.nbLayers;
+	texture.nbLevels = header.nbLevels;
+	texture.allocate();
+
+	//Arquivo truncado conta como falta no cache
+	return (bool)file.read((char*)texture.data.data(), texture.data.size());
+}
+
+bool TextureCache::save(unsigned long long key, const CompressedTexture& texture)
+{
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+
+	ofstream file(getPath(key), ios::binary);
+	if (!file)
+	{
+		cout << "Failed to write texture cache " << getPath(key) << endl;
+		return false;
+	}
+
+	TextureCacheHeader header;
+	memcpy(header.magic, TEXTURE_CACHE_MAGIC, 4);
+	header.version = TEXTURE_CACHE_VERSION;
+	header.key = key;
+	header.format = texture.format;
+	header.width = texture.width;
+	header.height = texture.height;
+	header.nbLayers = texture.nbLayers;
+	header.nbLevels = texture.nbLevels;
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)texture.data.data(), texture.data.size());
+	return (bool)file;
+}
+
+unsigned long long TextureCache::hash(const void* data, size_t size, unsigned long long key)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		key = (key ^ bytes[i]) * 1099511628211ULL;
+	}
+	return key;
+}
+
+unsigned long long TextureCache::hashFileStamp(string path, unsigned long long key)
+{
+	struct stat info;
+	long long stamp[2] = { -1, -1 };
+
+	if (stat(path.c_str(), &info) == 0)
+	{
+		stamp[0] = (long long)info.st_size;
+		stamp[1] = (long long)info.st_mtime;
+	}
+
+	key = hash(path.data(), path.size(), key);
+	return hash(stamp, sizeof(stamp), key);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "BlockCompression.h"
+
+using namespace std;
+
+//Array de textura com todos os mipmaps, normalmente comprimido. Os dados ficam por nivel
+//e, dentro de cada nivel, por camada, na ordem que o glCompressedTexImage3D espera
+struct CompressedTexture
+{
+	BlockFormat format;
+	int width, height, nbLayers, nbLevels;
+	vector<unsigned char> data;
+
+	int getLevelWidth(int level) const { return width >> level > 0 ? width >> level : 1; }
+	int getLevelHeight(int level) const { return height >> level > 0 ? height >> level : 1; }
+	size_t getLevelSize(int level) const { return getCompressedSize(format, getLevelWidth(level), getLevelHeight(level)) * nbLayers; }
+	size_t getLevelOffset(int level) const;
+	//Reserva data para todos os niveis
+	void allocate();
+};
+
+//Cache em disco das texturas ja comprimidas, um arquivo por chave. A chave deve mudar
+//sempre que o conteudo mudaria (arquivos de origem, tamanhos, arranjo no atlas)
+class TextureCache
+{
+public:
+	TextureCache(string directory = "../textures/cache/") { this->directory = directory; }
+	bool load(unsigned long long key, CompressedTexture& texture);
+	bool save(unsigned long long key, const CompressedTexture& texture);
+
+	//FNV-1a de 64 bits, encadeavel
+	static unsigned long long hash(const void* data, size_t size, unsigned long long key = 14695981039346656037ULL);
+	//Tamanho e data de modificacao do arquivo, para detectar texturas alteradas
+	static unsigned long long hashFileStamp(string path, unsigned long long key);
+
+protected:
+	string getPath(unsigned long long key);
+
+	string directory;
+};
@@ -0,0 +1,77 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+void ThreadPool::start(int nbThreads)
+{
+	stop();
+
+	if (nbThreads <= 0)
+	{
+		nbThreads = max(1, (int)thread::hardware_concurrency() - 1);
+	}
+
+	stopping = false;
+	for (int i = 0; i < nbThreads; i++)
+	{
+		threads.push_back(thread(&ThreadPool::run, this));
+	}
+}
+
+void ThreadPool::submit(function<void()> job)
+{
+	{
+		lock_guard<mutex> guard(lock);
+		jobs.push_back(move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	unique_lock<mutex> guard(lock);
+	idle.wait(guard, [this] { return jobs.empty() && nbRunning == 0; });
+}
+
+void ThreadPool::stop()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+
+	for (int i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+	threads.clear();
+}
+
+void ThreadPool::run()
+{
+	unique_lock<mutex> guard(lock);
+	while (true)
+	{
+		jobAvailable.wait(guard, [this] { return stopping || !jobs.empty(); });
+		if (jobs.empty())
+		{
+			//So sai com a fila vazia, entao stop() nao descarta tarefas
+			return;
+		}
+
+		function<void()> job = move(jobs.front());
+		jobs.pop_front();
+		nbRunning++;
+
+		guard.unlock();
+		job();
+		guard.lock();
+
+		nbRunning--;
+		if (jobs.empty() && nbRunning == 0)
+		{
+			idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+//Threads de trabalho fixas com uma fila FIFO de tarefas. As tarefas comecam na ordem em
+//que foram enviadas, mas podem terminar em qualquer ordem
+class ThreadPool
+{
+public:
+	ThreadPool() {}
+	~ThreadPool() { stop(); }
+	//nbThreads 0 usa uma thread por nucleo, menos a que chama (no minimo uma)
+	void start(int nbThreads = 0);
+	void submit(function<void()> job);
+	//Bloqueia ate a fila esvaziar e nenhuma tarefa estar rodando
+	void wait();
+	//Termina as tarefas pendentes e encerra as threads
+	void stop();
+	int getNbThreads() { return threads.size(); }
+
+protected:
+	void run();
+
+	vector<thread> threads;
+	deque<function<void()>> jobs;
+	mutex lock;
+	condition_variable jobAvailable, idle;
+	int nbRunning = 0;
+	bool stopping = false;
+};
@@ -0,0 +1,73 @@
+#version 450
+
+//Distribui as luzes pontuais nos clusters do frustum (ver LightClusters). Uma invocacao por
+//cluster; o grupo le as luzes em blocos de 128, ja no espaco da camera, na memoria
+//compartilhada, e cada invocacao testa o bloco inteiro contra a caixa do seu cluster
+layout (local_size_x = 128) in;
+
+struct PointLight
+{
+	vec4 positionRadius;
+	vec4 color;
+};
+
+layout (std430, binding = 4) readonly buffer PointLights { PointLight pointLights[]; };
+layout (std430, binding = 5) writeonly buffer ClusterCounts { uint clusterCounts[]; };
+layout (std430, binding = 6) writeonly buffer ClusterLights { uint clusterLights[]; };
+
+uniform mat4 view;
+uniform vec2 tanHalfFov; //tangentes das metades dos angulos de visao horizontal e vertical
+uniform float nearPlane;
+uniform float farPlane;
+uniform ivec3 clusterGrid;
+uniform int clusterCapacity;
+uniform int nbLights;
+
+shared vec4 sharedLights[128];
+
+void main()
+{
+	int cluster = int(gl_GlobalInvocationID.x);
+	bool inGrid = cluster < clusterGrid.x * clusterGrid.y * clusterGrid.z;
+	ivec3 cell = ivec3(cluster % clusterGrid.x, (cluster / clusterGrid.x) % clusterGrid.y, cluster / (clusterGrid.x * clusterGrid.y));
+
+	//Caixa do cluster no espaco da camera: o tile de tela entre as profundidades da fatia
+	float depthNear = nearPlane * pow(farPlane / nearPlane, float(cell.z) / float(clusterGrid.z));
+	float depthFar = nearPlane * pow(farPlane / nearPlane, float(cell.z + 1) / float(clusterGrid.z));
+	vec2 extentMin = (vec2(cell.xy) / vec2(clusterGrid.xy) * 2.0 - 1.0) * tanHalfFov;
+	vec2 extentMax = (vec2(cell.xy + 1) / vec2(clusterGrid.xy) * 2.0 - 1.0) * tanHalfFov;
+	vec3 boxMin = vec3(min(extentMin * depthNear, extentMin * depthFar), -depthFar);
+	vec3 boxMax = vec3(max(extentMax * depthNear, extentMax * depthFar), -depthNear);
+
+	int count = 0;
+	int base = cluster * clusterCapacity;
+	for (int first = 0; first < nbLights; first += 128)
+	{
+		int i = first + int(gl_LocalInvocationID.x);
+		if (i < nbLights)
+		{
+			vec4 light = pointLights[i].positionRadius;
+			sharedLights[gl_LocalInvocationID.x] = vec4((view * vec4(light.xyz, 1.0)).xyz, light.w);
+		}
+		barrier();
+
+		//Esfera contra caixa: distancia do centro ao ponto mais proximo da caixa
+		int batch = inGrid ? min(nbLights - first, 128) : 0;
+		for (int j = 0; j < batch && count < clusterCapacity; j++)
+		{
+			vec4 light = sharedLights[j];
+			vec3 offset = clamp(light.xyz, boxMin, boxMax) - light.xyz;
+			if (dot(offset, offset) <= light.w * light.w)
+			{
+				clusterLights[base + count] = uint(first + j);
+				count++;
+			}
+		}
+		barrier();
+	}
+
+	if (inGrid)
+	{
+		clusterCounts[cluster] = uint(count);
+	}
+}
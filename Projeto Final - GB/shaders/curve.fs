@@ -0,0 +1,10 @@
+#version 450
+
+uniform vec4 finalColor;
+
+out vec4 color;
+
+void main()
+{
+	color = finalColor;
+}
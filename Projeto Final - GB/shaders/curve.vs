@@ -0,0 +1,26 @@
+#version 450
+
+//Curvas avaliadas na GPU: cada instancia e uma curva e cada vertice um ponto dela
+layout (std430, binding = 0) readonly buffer BasisMatrices { mat4 basis[]; };
+layout (std430, binding = 1) readonly buffer SegmentGeometry { mat4 geometry[]; };
+layout (std430, binding = 2) readonly buffer Curves { ivec4 curves[]; };
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform int pointsPerCurve;
+
+vec3 pointOnCurve(int curve, float t)
+{
+	ivec4 c = curves[curve];
+	float ft = clamp(t, 0.0, 1.0) * float(c.y);
+	float segment = min(floor(ft), float(c.y - 1));
+	float u = ft - segment;
+	vec4 T = vec4(u * u * u, u * u, u, 1.0);
+	return (geometry[c.x + int(segment)] * basis[c.z] * T).xyz;
+}
+
+void main()
+{
+	float t = float(gl_VertexID) / float(pointsPerCurve - 1);
+	gl_Position = projection * view * vec4(pointOnCurve(gl_InstanceID, t), 1.0);
+}
@@ -0,0 +1,188 @@
+#version 450
+
+//Passo de iluminacao do DeferredRenderer: um fragmento por pixel, com a mesma iluminacao de
+//sprite.fs (luz principal com sombra e luzes pontuais dos clusters) sobre o G-buffer
+uniform sampler2D gAlbedo; //rgb = textura difusa, a = kd
+uniform sampler2D gNormal; //normal octaedrica em [0, 1]
+uniform sampler2D gSpecular; //rgb = ks, a = sqrt(q / 1024)
+uniform sampler2D gAmbient; //rgb = ka
+uniform sampler2D gDepth;
+
+//A posicao no mundo sai da profundidade
+uniform mat4 inverseViewProj;
+uniform mat4 view;
+
+//Propriedades da fonte de luz
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+
+uniform vec3 cameraPos;
+
+out vec4 color;
+
+//Posicao do pixel reconstruida em main, usada como o fragPos e o viewDepth de sprite.fs
+vec3 fragPos;
+float viewDepth;
+
+//Luzes pontuais em clusters (ver LightClusters)
+struct PointLight
+{
+	vec4 positionRadius;
+	vec4 color;
+};
+
+layout (std430, binding = 4) readonly buffer PointLights { PointLight pointLights[]; };
+layout (std430, binding = 5) readonly buffer ClusterCounts { uint clusterCounts[]; };
+layout (std430, binding = 6) readonly buffer ClusterLights { uint clusterLights[]; };
+
+uniform bool useClusters;
+uniform bool showClusters; //mapa de calor das luzes por cluster
+uniform ivec3 clusterGrid;
+uniform int clusterCapacity;
+uniform vec4 clusterScale; //xy = clusters por pixel; fatia = log(viewDepth) * z + w
+
+int findCluster()
+{
+	ivec2 tile = min(ivec2(gl_FragCoord.xy * clusterScale.xy), clusterGrid.xy - 1);
+	int slice = clamp(int(log(viewDepth) * clusterScale.z + clusterScale.w), 0, clusterGrid.z - 1);
+	return tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice);
+}
+
+//De azul (nenhuma luz) a ciano, verde, amarelo e vermelho (32 ou mais)
+vec3 heatColor(uint count)
+{
+	float t = clamp(float(count) / 32.0, 0.0, 1.0);
+	return clamp(vec3(4.0 * t - 2.0, 2.0 - abs(4.0 * t - 2.0), 2.0 - 4.0 * t), 0.0, 1.0);
+}
+
+//Sombras da ShadowMap, como em sprite.fs
+uniform bool useShadows;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 lightSpace[4];
+uniform vec4 cascadeFar;
+uniform vec4 cascadeTexel;
+
+float shadowFactor(vec3 N, vec3 L)
+{
+	if (!useShadows)
+	{
+		return 1.0;
+	}
+
+	vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+	float slope = 1.0 - abs(dot(N, L));
+	for (int i = 0; i < 4; i++)
+	{
+		if (viewDepth > cascadeFar[i])
+		{
+			continue;
+		}
+
+		vec3 offsetPos = fragPos + N * cascadeTexel[i] * (1.0 + 2.0 * slope);
+		vec3 coord = (lightSpace[i] * vec4(offsetPos, 1.0)).xyz;
+		if (any(lessThan(coord.xy, texel)) || any(greaterThan(coord.xy, 1.0 - texel)))
+		{
+			continue;
+		}
+
+		float lit = 0.0;
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int x = -1; x <= 1; x++)
+			{
+				lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(i), min(coord.z, 1.0)));
+			}
+		}
+		return lit / 9.0;
+	}
+	return 1.0;
+}
+
+vec3 decodeNormal(vec2 e)
+{
+	e = e * 2.0 - 1.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return normalize(n);
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+	//Sem geometria: fica a cor de fundo
+	if (depth == 1.0)
+	{
+		discard;
+	}
+	gl_FragDepth = depth;
+
+	vec2 ndc = gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0;
+	vec4 worldPos = inverseViewProj * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+	fragPos = worldPos.xyz / worldPos.w;
+	viewDepth = -(view * vec4(fragPos, 1.0)).z;
+
+	vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+	vec4 specularData = texelFetch(gSpecular, pixel, 0);
+	vec3 texColor = albedo.rgb;
+	vec3 ka = texelFetch(gAmbient, pixel, 0).rgb;
+	float kd = albedo.a;
+	vec3 ks = specularData.rgb;
+	float q = specularData.a * specularData.a * 1024.0;
+
+	// Ambient
+	vec3 ambient = lightColor * ka;
+
+	// Diffuse
+	vec3 N = decodeNormal(texelFetch(gNormal, pixel, 0).xy);
+	vec3 L = normalize(lightPos - fragPos);
+	float diff = max(dot(N, L), 0.0);
+	vec3 diffuse = diff * lightColor * kd;
+
+	// Specular
+	vec3 R = reflect(-L, N);
+	vec3 V = normalize(cameraPos - fragPos);
+	float spec = pow(max(dot(R, V), 0.0), q);
+	vec3 specular = spec * ks * lightColor;
+
+	// Shadow: so a luz direta
+	float shadow = shadowFactor(N, L);
+
+	// Point lights: so as do cluster do pixel
+	vec3 pointDiffuse = vec3(0.0);
+	vec3 pointSpecular = vec3(0.0);
+	uint nbPointLights = 0;
+	if (useClusters)
+	{
+		int cluster = findCluster();
+		nbPointLights = clusterCounts[cluster];
+		for (uint i = 0; i < nbPointLights; i++)
+		{
+			PointLight light = pointLights[clusterLights[cluster * clusterCapacity + i]];
+			vec3 toLight = light.positionRadius.xyz - fragPos;
+			float distance2 = dot(toLight, toLight);
+			float radius2 = light.positionRadius.w * light.positionRadius.w;
+			if (distance2 >= radius2 || distance2 < 1e-8)
+			{
+				continue;
+			}
+			float falloff = 1.0 - distance2 / radius2;
+			falloff *= falloff;
+			vec3 Lp = toLight * inversesqrt(distance2);
+			pointDiffuse += max(dot(N, Lp), 0.0) * falloff * light.color.rgb;
+			pointSpecular += pow(max(dot(reflect(-Lp, N), V), 0.0), q) * falloff * light.color.rgb;
+		}
+	}
+
+	vec3 result = (ambient + shadow * diffuse + pointDiffuse * kd) * texColor + shadow * specular + pointSpecular * ks;
+	if (showClusters)
+	{
+		result = mix(result, heatColor(nbPointLights), 0.7);
+	}
+
+	color = vec4(result, 1.0);
+}
@@ -0,0 +1,75 @@
+#version 450
+#extension GL_ARB_bindless_texture : enable
+
+//Passo de geometria do DeferredRenderer, com sprite.vs: grava as propriedades da superficie
+//no G-buffer; a iluminacao e feita depois, em deferred.fs
+in vec3 scaledNormal;
+in vec2 texCoord;
+
+//Propriedades dos materiais da cena (ver MaterialLibrary)
+struct Material
+{
+	vec4 ka; //w = kd
+	vec4 ks; //w = q
+	ivec4 texture; //array, camada, 1 se esta no atlas
+	uvec4 handle; //xy = handle bindless do array
+	vec4 uvTransform; //xy = escala, zw = deslocamento da regiao no atlas
+};
+
+layout (std430, binding = 3) readonly buffer Materials { Material materials[]; };
+
+uniform int materialId;
+
+//Texturas difusas, como em sprite.fs
+uniform sampler2DArray diffuseMaps[8];
+uniform bool useBindless;
+
+//G-buffer: 4 alvos de 32 bits, a posicao sai da profundidade
+layout (location = 0) out vec4 gAlbedo; //rgb = textura difusa, a = kd
+layout (location = 1) out vec2 gNormal; //normal octaedrica em [0, 1]
+layout (location = 2) out vec4 gSpecular; //rgb = ks, a = sqrt(q / 1024)
+layout (location = 3) out vec4 gAmbient; //rgb = ka
+
+vec4 sampleMap(sampler2DArray map, Material material, vec2 uv)
+{
+	if (material.texture.z != 0)
+	{
+		vec2 scale = material.uvTransform.xy;
+		vec2 atlasUV = fract(uv) * scale + material.uvTransform.zw;
+		return textureGrad(map, vec3(atlasUV, material.texture.y), dFdx(uv) * scale, dFdy(uv) * scale);
+	}
+	return texture(map, vec3(uv, material.texture.y));
+}
+
+vec4 sampleDiffuse(Material material, vec2 uv)
+{
+#ifdef GL_ARB_bindless_texture
+	if (useBindless)
+	{
+		return sampleMap(sampler2DArray(material.handle.xy), material, uv);
+	}
+#endif
+	return sampleMap(diffuseMaps[material.texture.x], material, uv);
+}
+
+//Octaedro desdobrado no quadrado [-1, 1]; a metade de baixo e dobrada sobre os cantos
+vec2 encodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if (n.z < 0.0)
+	{
+		vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signs;
+	}
+	return n.xy * 0.5 + 0.5;
+}
+
+void main()
+{
+	Material material = materials[materialId];
+
+	gAlbedo = vec4(sampleDiffuse(material, texCoord).rgb, material.ka.w);
+	gNormal = encodeNormal(normalize(scaledNormal));
+	gSpecular = vec4(material.ks.xyz, sqrt(clamp(material.ks.w / 1024.0, 0.0, 1.0)));
+	gAmbient = vec4(material.ka.xyz, 1.0);
+}
@@ -0,0 +1,47 @@
+#version 450
+
+//Pre-passo de profundidade (DepthPrepass): so a posicao. As contas de gl_Position sao as
+//mesmas de sprite.vs e as duas saidas sao invariant, para o passo principal com GL_EQUAL
+//encontrar exatamente a profundidade gravada aqui
+layout (location = 0) in vec3 position;
+
+//Trajetorias (ver CurveBuffer)
+layout (std430, binding = 0) readonly buffer BasisMatrices { mat4 basis[]; };
+layout (std430, binding = 1) readonly buffer SegmentGeometry { mat4 geometry[]; };
+layout (std430, binding = 2) readonly buffer Curves { ivec4 curves[]; };
+
+invariant gl_Position;
+
+uniform mat4 projection;
+uniform mat4 model;
+uniform mat4 view;
+
+uniform bool usePath;
+uniform int pathCurve;
+uniform float pathTime;
+uniform float pathPhaseStep;
+uniform float pathPhase;
+
+vec3 pointOnCurve(int curve, float t)
+{
+	ivec4 c = curves[curve];
+	float ft = clamp(t, 0.0, 1.0) * float(c.y);
+	float segment = min(floor(ft), float(c.y - 1));
+	float u = ft - segment;
+	vec4 T = vec4(u * u * u, u * u, u, 1.0);
+	return (geometry[c.x + int(segment)] * basis[c.z] * T).xyz;
+}
+
+void main()
+{
+	vec4 worldPos = model * vec4(position, 1.0);
+
+	if (usePath)
+	{
+		float t = fract(pathTime / float(curves[pathCurve].y) + pathPhase + gl_InstanceID * pathPhaseStep);
+		worldPos.xyz += pointOnCurve(pathCurve, t);
+	}
+
+	vec4 viewPos = view * worldPos;
+	gl_Position = projection * viewPos;
+}
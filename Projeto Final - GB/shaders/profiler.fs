@@ -0,0 +1,10 @@
+#version 450
+
+in vec3 vertexColor;
+
+out vec4 color;
+
+void main()
+{
+	color = vec4(vertexColor, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 450
+
+//Grafico do FrameProfiler: posicoes em pixels, origem no canto inferior esquerdo
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec3 color;
+
+uniform vec2 viewportSize;
+
+out vec3 vertexColor;
+
+void main()
+{
+	vertexColor = color;
+	gl_Position = vec4(position / viewportSize * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 450
+
+//Sem saida de cor: passos so de profundidade (ShadowMap e pre-passo da DepthPrepass)
+void main()
+{
+}
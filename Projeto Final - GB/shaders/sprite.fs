@@ -1,15 +1,25 @@
 #version 450
+#extension GL_ARB_bindless_texture : enable
 
 in vec3 finalColor;
 in vec3 scaledNormal;
 in vec3 fragPos;
 in vec2 texCoord;
+in float viewDepth;
 
-//Propriedades do material do objeto
-uniform vec3 ka;
-uniform float kd;
-uniform vec3 ks;
-uniform float q;
+//Propriedades dos materiais da cena (ver MaterialLibrary)
+struct Material
+{
+	vec4 ka; //w = kd
+	vec4 ks; //w = q
+	ivec4 texture; //array, camada, 1 se esta no atlas
+	uvec4 handle; //xy = handle bindless do array
+	vec4 uvTransform; //xy = escala, zw = deslocamento da regiao no atlas
+};
+
+layout (std430, binding = 3) readonly buffer Materials { Material materials[]; };
+
+uniform int materialId;
 
 //Propriedades da fonte de luz
 uniform vec3 lightPos;
@@ -21,11 +31,124 @@ uniform vec3 cameraPos;
 //Buffer de sada (color buffer)
 out vec4 color;
 
-//buffer de textura
-uniform sampler2D colorBuffer;
+//Texturas difusas: um array por tamanho de imagem, ou handles bindless quando suportado
+uniform sampler2DArray diffuseMaps[8];
+uniform bool useBindless;
+
+//No atlas a repeticao e feita com fract dentro da regiao; os gradientes vem das UVs
+//continuas para o mipmap nao saltar na costura
+vec4 sampleMap(sampler2DArray map, Material material, vec2 uv)
+{
+	if (material.texture.z != 0)
+	{
+		vec2 scale = material.uvTransform.xy;
+		vec2 atlasUV = fract(uv) * scale + material.uvTransform.zw;
+		return textureGrad(map, vec3(atlasUV, material.texture.y), dFdx(uv) * scale, dFdy(uv) * scale);
+	}
+	return texture(map, vec3(uv, material.texture.y));
+}
+
+vec4 sampleDiffuse(Material material, vec2 uv)
+{
+#ifdef GL_ARB_bindless_texture
+	if (useBindless)
+	{
+		return sampleMap(sampler2DArray(material.handle.xy), material, uv);
+	}
+#endif
+	return sampleMap(diffuseMaps[material.texture.x], material, uv);
+}
+
+//Luzes pontuais em clusters (ver LightClusters): as listas de cada cluster vem de clusters.cs
+struct PointLight
+{
+	vec4 positionRadius;
+	vec4 color;
+};
+
+layout (std430, binding = 4) readonly buffer PointLights { PointLight pointLights[]; };
+layout (std430, binding = 5) readonly buffer ClusterCounts { uint clusterCounts[]; };
+layout (std430, binding = 6) readonly buffer ClusterLights { uint clusterLights[]; };
+
+uniform bool useClusters;
+uniform bool showClusters; //mapa de calor das luzes por cluster
+uniform ivec3 clusterGrid;
+uniform int clusterCapacity;
+uniform vec4 clusterScale; //xy = clusters por pixel; fatia = log(viewDepth) * z + w
+
+//Visualizacao de sobreposicao (ver DepthPrepass): cada fragmento sombreado soma esta cor com
+//blending aditivo sobre fundo preto; 1 camada fica vermelho escuro, 8 laranja, 32 branco
+uniform bool showOverdraw;
+
+int findCluster()
+{
+	ivec2 tile = min(ivec2(gl_FragCoord.xy * clusterScale.xy), clusterGrid.xy - 1);
+	int slice = clamp(int(log(viewDepth) * clusterScale.z + clusterScale.w), 0, clusterGrid.z - 1);
+	return tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice);
+}
+
+//De azul (nenhuma luz) a ciano, verde, amarelo e vermelho (32 ou mais)
+vec3 heatColor(uint count)
+{
+	float t = clamp(float(count) / 32.0, 0.0, 1.0);
+	return clamp(vec3(4.0 * t - 2.0, 2.0 - abs(4.0 * t - 2.0), 2.0 - 4.0 * t), 0.0, 1.0);
+}
+
+//Sombras da ShadowMap: uma camada por cascata, com a profundidade da camera onde cada uma
+//termina e o lado do texel no mundo
+uniform bool useShadows;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 lightSpace[4];
+uniform vec4 cascadeFar;
+uniform vec4 cascadeTexel;
+
+//Fracao da luz que chega ao fragmento. O ponto e afastado da superficie pela normal, mais
+//em angulos rasantes, e o PCF 3x3 soma comparacoes bilineares do hardware. Fora da caixa
+//de uma cascata (atualizada em outro quadro) vale a seguinte
+float shadowFactor(vec3 N, vec3 L)
+{
+	if (!useShadows)
+	{
+		return 1.0;
+	}
+
+	vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+	float slope = 1.0 - abs(dot(N, L));
+	for (int i = 0; i < 4; i++)
+	{
+		if (viewDepth > cascadeFar[i])
+		{
+			continue;
+		}
+
+		vec3 offsetPos = fragPos + N * cascadeTexel[i] * (1.0 + 2.0 * slope);
+		vec3 coord = (lightSpace[i] * vec4(offsetPos, 1.0)).xyz;
+		if (any(lessThan(coord.xy, texel)) || any(greaterThan(coord.xy, 1.0 - texel)))
+		{
+			continue;
+		}
+
+		float lit = 0.0;
+		for (int y = -1; y <= 1; y++)
+		{
+			for (int x = -1; x <= 1; x++)
+			{
+				lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(i), min(coord.z, 1.0)));
+			}
+		}
+		return lit / 9.0;
+	}
+	return 1.0;
+}
 
 void main()
 {
+    Material material = materials[materialId];
+    vec3 ka = material.ka.xyz;
+    float kd = material.ka.w;
+    vec3 ks = material.ks.xyz;
+    float q = material.ks.w;
+
     // Ambient
     vec3 ambient =  lightColor * ka;
     // Diffuse 
@@ -40,8 +163,46 @@ void main()
     float spec = pow(max(dot(R,V),0.0),q);
     vec3 specular = spec * ks * lightColor;
     
-    vec4 texColor = texture(colorBuffer,texCoord);
-    vec3 result = (ambient + diffuse) * vec3(texColor) + specular;
+    // Shadow: so a luz direta
+    float shadow = shadowFactor(N, L);
+
+    // Point lights: so as do cluster do fragmento, com queda suave ate o alcance
+    vec3 pointDiffuse = vec3(0.0);
+    vec3 pointSpecular = vec3(0.0);
+    uint nbPointLights = 0;
+    if (useClusters)
+    {
+        int cluster = findCluster();
+        nbPointLights = clusterCounts[cluster];
+        for (uint i = 0; i < nbPointLights; i++)
+        {
+            PointLight light = pointLights[clusterLights[cluster * clusterCapacity + i]];
+            vec3 toLight = light.positionRadius.xyz - fragPos;
+            float distance2 = dot(toLight, toLight);
+            float radius2 = light.positionRadius.w * light.positionRadius.w;
+            if (distance2 >= radius2 || distance2 < 1e-8)
+            {
+                continue;
+            }
+            float falloff = 1.0 - distance2 / radius2;
+            falloff *= falloff;
+            vec3 Lp = toLight * inversesqrt(distance2);
+            pointDiffuse += max(dot(N, Lp), 0.0) * falloff * light.color.rgb;
+            pointSpecular += pow(max(dot(reflect(-Lp, N), V), 0.0), q) * falloff * light.color.rgb;
+        }
+    }
+
+    vec4 texColor = sampleDiffuse(material, texCoord);
+    vec3 result = (ambient + shadow * diffuse + pointDiffuse * kd) * vec3(texColor) + shadow * specular + pointSpecular * ks;
+    if (showClusters)
+    {
+        result = mix(result, heatColor(nbPointLights), 0.7);
+    }
+
+    if (showOverdraw)
+    {
+        result = vec3(0.125, 0.0625, 0.03125);
+    }
 
     color = vec4(result, 1.0f);
 }
\ No newline at end of file
@@ -1,22 +1,59 @@
-#version 460
+#version 450
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec2 texc;
 layout (location = 2) in vec3 normal;
 
+//Trajetorias (ver CurveBuffer)
+layout (std430, binding = 0) readonly buffer BasisMatrices { mat4 basis[]; };
+layout (std430, binding = 1) readonly buffer SegmentGeometry { mat4 geometry[]; };
+layout (std430, binding = 2) readonly buffer Curves { ivec4 curves[]; };
+
+//Mesma posicao que prepass.vs grava no pre-passo de profundidade
+invariant gl_Position;
+
 out vec3 finalColor;
 out vec3 fragPos;
 out vec2 texCoord;
 out vec3 scaledNormal;
+out float viewDepth; //distancia ao longo da camera, escolhe a cascata de sombra
 
 uniform mat4 projection;
 uniform mat4 model;
 uniform mat4 view;
 
+//Objeto sobre uma trajetoria: cada instancia fica defasada de pathPhaseStep
+uniform bool usePath;
+uniform int pathCurve;
+uniform float pathTime;
+uniform float pathPhaseStep;
+uniform float pathPhase; //Defasagem do objeto na trajetoria compartilhada
+
+vec3 pointOnCurve(int curve, float t)
+{
+	ivec4 c = curves[curve];
+	float ft = clamp(t, 0.0, 1.0) * float(c.y);
+	float segment = min(floor(ft), float(c.y - 1));
+	float u = ft - segment;
+	vec4 T = vec4(u * u * u, u * u, u, 1.0);
+	return (geometry[c.x + int(segment)] * basis[c.z] * T).xyz;
+}
+
 void main()
 {
-	gl_Position = projection * view  * model * vec4(position, 1.0);
-	fragPos = vec3(model * vec4(position, 1.0));
+	vec4 worldPos = model * vec4(position, 1.0);
+
+	if (usePath)
+	{
+		//Um segmento por segundo, como no avanco quadro a quadro anterior
+		float t = fract(pathTime / float(curves[pathCurve].y) + pathPhase + gl_InstanceID * pathPhaseStep);
+		worldPos.xyz += pointOnCurve(pathCurve, t);
+	}
+
+	vec4 viewPos = view * worldPos;
+	gl_Position = projection * viewPos;
+	viewDepth = -viewPos.z;
+	fragPos = vec3(worldPos);
 	texCoord = vec2(texc.x, 1-texc.y);
 	scaledNormal = normal;
-}
\ No newline at end of file
+}